@@ -0,0 +1,283 @@
+// Async.h - Composable futures for the fetch -> decode -> process pipeline
+// Replaces signal/member-variable state machines with values that can be
+// chained (then), joined (whenAll) and run on the thread pool (run).
+// Continuations are delivered on the thread of the QObject passed as context,
+// so GUI code can touch widgets directly inside them.
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <QObject>
+#include <QPointer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QEventLoop>
+#include <QRunnable>
+#include <QThreadPool>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace Async {
+
+template <typename T> class Future;
+template <typename T> class Promise;
+
+namespace detail {
+
+// Queue `fn` onto the context object's thread; with no context, run inline
+inline void dispatch(QObject* context, std::function<void()> fn) {
+    if (!context) {
+        fn();
+        return;
+    }
+    QPointer<QObject> guard(context);
+    QMetaObject::invokeMethod(context, [guard, fn]() {
+        if (guard) fn();
+    }, Qt::QueuedConnection);
+}
+
+// Continuation result -> value type of the future returned by then();
+// void continuations resolve with `true` once they have run
+template <typename R> struct Unwrap { using type = R; };
+template <typename U> struct Unwrap<Future<U>> { using type = U; };
+template <> struct Unwrap<void> { using type = bool; };
+
+class FunctionRunnable : public QRunnable {
+public:
+    explicit FunctionRunnable(std::function<void()> fn) : m_fn(std::move(fn)) {
+        setAutoDelete(true);
+    }
+    void run() override { m_fn(); }
+private:
+    std::function<void()> m_fn;
+};
+
+} // namespace detail
+
+template <typename T>
+class Future {
+public:
+    using ValueType = T;
+
+    Future() : m_state(std::make_shared<State>()) {}
+
+    bool isFinished() const {
+        QMutexLocker locker(&m_state->mutex);
+        return m_state->finished;
+    }
+
+    bool isFailed() const {
+        QMutexLocker locker(&m_state->mutex);
+        return m_state->finished && m_state->failed;
+    }
+
+    // Valid once finished without error
+    T result() const {
+        QMutexLocker locker(&m_state->mutex);
+        return m_state->value;
+    }
+
+    QString errorString() const {
+        QMutexLocker locker(&m_state->mutex);
+        return m_state->error;
+    }
+
+    // Run fn(const T&) on context's thread once the value is ready. If fn
+    // returns a Future<U> the result is flattened to Future<U>; a void fn
+    // yields Future<bool>. Errors skip fn and propagate to the returned future.
+    template <typename F>
+    auto then(QObject* context, F fn) const
+        -> Future<typename detail::Unwrap<std::invoke_result_t<F, const T&>>::type> {
+        using R = std::invoke_result_t<F, const T&>;
+        using U = typename detail::Unwrap<R>::type;
+
+        Promise<U> next;
+        std::shared_ptr<State> state = m_state;
+        subscribe([state, context, fn, next]() {
+            if (state->failed) {
+                next.setError(state->error);
+                return;
+            }
+            detail::dispatch(context, [state, fn, next]() {
+                if constexpr (std::is_void_v<R>) {
+                    fn(state->value);
+                    next.setValue(true);
+                } else if constexpr (std::is_same_v<R, Future<U>>) {
+                    Future<U> inner = fn(state->value);
+                    inner.subscribe([inner, next]() {
+                        if (inner.isFailed()) next.setError(inner.errorString());
+                        else next.setValue(inner.result());
+                    });
+                } else {
+                    next.setValue(fn(state->value));
+                }
+            });
+        });
+        return next.future();
+    }
+
+    // Run fn(error) on context's thread if this future fails
+    Future<T> onFailed(QObject* context, std::function<void(const QString&)> fn) const {
+        std::shared_ptr<State> state = m_state;
+        subscribe([state, context, fn]() {
+            if (!state->failed) return;
+            detail::dispatch(context, [state, fn]() { fn(state->error); });
+        });
+        return *this;
+    }
+
+    // Resolve with `fallback` instead of failing, e.g. for optional tiles
+    Future<T> orElse(T fallback) const {
+        Promise<T> next;
+        std::shared_ptr<State> state = m_state;
+        subscribe([state, fallback, next]() {
+            next.setValue(state->failed ? fallback : state->value);
+        });
+        return next.future();
+    }
+
+    // Spin a local event loop until finished; for CLI tools and scripts
+    T waitForResult() const {
+        if (!isFinished()) {
+            QEventLoop loop;
+            QEventLoop* loopPtr = &loop;
+            subscribe([loopPtr]() {
+                QMetaObject::invokeMethod(loopPtr, "quit", Qt::QueuedConnection);
+            });
+            loop.exec();
+        }
+        return result();
+    }
+
+    // Low-level hook: fn runs on whichever thread completes the future
+    // (or immediately if it already has)
+    void subscribe(std::function<void()> fn) const {
+        QMutexLocker locker(&m_state->mutex);
+        if (m_state->finished) {
+            locker.unlock();
+            fn();
+            return;
+        }
+        m_state->callbacks.push_back(std::move(fn));
+    }
+
+private:
+    struct State {
+        QMutex mutex;
+        bool finished = false;
+        bool failed = false;
+        T value{};
+        QString error;
+        std::vector<std::function<void()>> callbacks;
+    };
+
+    std::shared_ptr<State> m_state;
+
+    friend class Promise<T>;
+};
+
+template <typename T>
+class Promise {
+public:
+    Future<T> future() const { return m_future; }
+
+    // First completion wins; later calls are ignored
+    void setValue(T value) const {
+        complete(false, std::move(value), QString());
+    }
+
+    void setError(const QString& error) const {
+        complete(true, T{}, error);
+    }
+
+private:
+    Future<T> m_future;
+
+    void complete(bool failed, T value, const QString& error) const {
+        auto& state = *m_future.m_state;
+        std::vector<std::function<void()>> callbacks;
+        {
+            QMutexLocker locker(&state.mutex);
+            if (state.finished) return;
+            state.finished = true;
+            state.failed = failed;
+            state.value = std::move(value);
+            state.error = error;
+            callbacks.swap(state.callbacks);
+        }
+        for (auto& callback : callbacks) {
+            callback();
+        }
+    }
+};
+
+// Already-completed futures
+template <typename T>
+Future<T> makeReady(T value) {
+    Promise<T> promise;
+    promise.setValue(std::move(value));
+    return promise.future();
+}
+
+template <typename T>
+Future<T> makeFailed(const QString& error) {
+    Promise<T> promise;
+    promise.setError(error);
+    return promise.future();
+}
+
+// Fan-in: resolves with all values in input order, or fails with the first error
+template <typename T>
+Future<QList<T>> whenAll(const QList<Future<T>>& futures) {
+    Promise<QList<T>> promise;
+    if (futures.isEmpty()) {
+        promise.setValue(QList<T>());
+        return promise.future();
+    }
+
+    struct Join {
+        QMutex mutex;
+        QVector<T> values;
+        int remaining;
+    };
+    auto join = std::make_shared<Join>();
+    join->values.resize(futures.size());
+    join->remaining = futures.size();
+
+    for (int i = 0; i < futures.size(); ++i) {
+        Future<T> future = futures[i];
+        future.subscribe([join, future, i, promise]() {
+            if (future.isFailed()) {
+                promise.setError(future.errorString());
+                return;
+            }
+            QMutexLocker locker(&join->mutex);
+            join->values[i] = future.result();
+            if (--join->remaining == 0) {
+                QList<T> values = join->values.toList();
+                locker.unlock();
+                promise.setValue(values);
+            }
+        });
+    }
+    return promise.future();
+}
+
+// Run fn() on the global thread pool
+template <typename F>
+auto run(F fn) -> Future<std::invoke_result_t<F>> {
+    using R = std::invoke_result_t<F>;
+    Promise<R> promise;
+    QThreadPool::globalInstance()->start(new detail::FunctionRunnable([fn, promise]() {
+        promise.setValue(fn());
+    }));
+    return promise.future();
+}
+
+} // namespace Async
+
+#endif // ASYNC_H
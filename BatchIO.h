@@ -0,0 +1,341 @@
+// BatchIO.h - Batched whole-file reads and atomic writes
+// With liburing (DSS_HAVE_LIBURING) each thread keeps one io_uring, and a
+// batch's opens, sizes, transfers and closes each go through it as one
+// submission, so reading a mosaic's tiles from NVMe is bound by bandwidth
+// rather than per-file latency. Batches go through the ring kRingDepth
+// files at a time, so a batch never holds more descriptors than that.
+// Without it, or if the kernel refuses a ring, the batch is spread over a
+// small thread pool. Writes go to a temporary file renamed into place,
+// like QSaveFile, so readers never see a partial file.
+#ifndef BATCHIO_H
+#define BATCHIO_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QCoreApplication>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#ifdef DSS_HAVE_LIBURING
+#include <liburing.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#endif
+
+class BatchIO {
+public:
+    using FileData = QPair<QString, QByteArray>;
+
+    static QString backend() {
+#ifdef DSS_HAVE_LIBURING
+        return uringAvailable() ? "io_uring" : "threads";
+#else
+        return "threads";
+#endif
+    }
+
+    // Contents of each path, empty where a file is missing or unreadable
+    static QList<QByteArray> readFiles(const QStringList& paths) {
+        QList<QByteArray> result;
+#ifdef DSS_HAVE_LIBURING
+        // kRingDepth files at a time, each chunk closed before the next is
+        // opened, so a batch of any size holds at most kRingDepth descriptors
+        while (uringAvailable() && threadRing().ready && result.size() < paths.size()) {
+            QList<QByteArray> chunk = uringRead(paths.mid(result.size(), int(kRingDepth)));
+            if (!threadRing().ready) break;     // Retired mid-chunk: redo it on the pool
+            result += chunk;
+        }
+#endif
+        const int first = result.size();
+        std::vector<QByteArray> rest(size_t(paths.size() - first));
+        runOnPool(int(rest.size()), [&](int i) {
+            QFile file(paths[first + i]);
+            if (file.open(QIODevice::ReadOnly)) rest[size_t(i)] = file.readAll();
+        });
+        for (QByteArray& data : rest) result << data;
+        return result;
+    }
+
+    // Write each file atomically, creating parent directories; per-file success
+    static QList<bool> writeFiles(const QList<FileData>& files) {
+        for (const FileData& file : files) QDir().mkpath(QFileInfo(file.first).absolutePath());
+        QList<bool> result;
+#ifdef DSS_HAVE_LIBURING
+        while (uringAvailable() && threadRing().ready && result.size() < files.size()) {
+            QList<bool> chunk = uringWrite(files.mid(result.size(), int(kRingDepth)));
+            if (!threadRing().ready) break;
+            result += chunk;
+        }
+#endif
+        const int first = result.size();
+        std::vector<char> rest(size_t(files.size() - first), 0);
+        runOnPool(int(rest.size()), [&](int i) {
+            const FileData& data = files[first + i];
+            QSaveFile file(data.first);
+            rest[size_t(i)] = file.open(QIODevice::WriteOnly)
+                              && file.write(data.second) == data.second.size() && file.commit();
+        });
+        for (char ok : rest) result << bool(ok);
+        return result;
+    }
+
+private:
+    static constexpr int kThreads = 8;
+    static constexpr unsigned kRingDepth = 64;
+
+    template <typename Fn>
+    static void runOnPool(int count, Fn fn) {
+        static QThreadPool* pool = [] {
+            QThreadPool* p = new QThreadPool();
+            p->setMaxThreadCount(kThreads);
+            return p;
+        }();
+        if (count <= 1) {
+            if (count == 1) fn(0);
+            return;
+        }
+        QSemaphore done;
+        for (int i = 0; i < count; ++i) {
+            pool->start([&fn, &done, i]() {
+                fn(i);
+                done.release();
+            });
+        }
+        done.acquire(count);
+    }
+
+#ifdef DSS_HAVE_LIBURING
+    // Probe once: containers and older kernels may forbid io_uring
+    static bool uringAvailable() {
+        static const bool available = [] {
+            io_uring ring;
+            if (io_uring_queue_init(2, &ring, 0) < 0) return false;
+            io_uring_queue_exit(&ring);
+            return true;
+        }();
+        return available;
+    }
+
+    // One ring per thread, set up on first use and kept until the thread
+    // exits, with the kernel's support for open/statx/close probed once
+    struct Ring {
+        io_uring ring;
+        bool initialised = false;
+        bool ready = false;     // Cleared if the ring is retired
+        bool openat = false;
+        bool statx = false;
+        bool close = false;
+
+        Ring() {
+            initialised = ready = io_uring_queue_init(kRingDepth, &ring, 0) >= 0;
+            if (!ready) return;
+            if (io_uring_probe* probe = io_uring_get_probe_ring(&ring)) {
+                openat = io_uring_opcode_supported(probe, IORING_OP_OPENAT);
+                statx = io_uring_opcode_supported(probe, IORING_OP_STATX);
+                close = io_uring_opcode_supported(probe, IORING_OP_CLOSE);
+                io_uring_free_probe(probe);
+            }
+        }
+        ~Ring() {
+            if (initialised) io_uring_queue_exit(&ring);
+        }
+    };
+
+    static Ring& threadRing() {
+        thread_local Ring ring;
+        return ring;
+    }
+
+    // Submit prep(sqe, i) for each i where it returns true, kRingDepth at
+    // a time, and store each completion's result in results[i]
+    template <typename Prep>
+    static void uringSubmit(Ring& ring, size_t count, std::vector<int>& results, Prep prep) {
+        if (!ring.ready) return;
+        for (size_t first = 0; first < count; first += kRingDepth) {
+            size_t last = std::min(count, first + kRingDepth);
+            unsigned queued = 0;
+            for (size_t i = first; i < last; ++i) {
+                io_uring_sqe* sqe = io_uring_get_sqe(&ring.ring);
+                // Skipped entries complete as no-ops tagged 0
+                if (prep(sqe, i)) {
+                    io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(uintptr_t(i + 1)));
+                } else {
+                    io_uring_prep_nop(sqe);
+                    io_uring_sqe_set_data(sqe, nullptr);
+                }
+                queued++;
+            }
+            io_uring_submit(&ring.ring);
+            for (unsigned n = 0; n < queued; ++n) {
+                io_uring_cqe* cqe = nullptr;
+                int waited;
+                do {
+                    waited = io_uring_wait_cqe(&ring.ring, &cqe);
+                } while (waited == -EINTR);
+                if (waited < 0) {
+                    // Completions still in flight would land in a later
+                    // batch: retire the ring, later batches use threads
+                    ring.ready = false;
+                    return;
+                }
+                uintptr_t tag = reinterpret_cast<uintptr_t>(io_uring_cqe_get_data(cqe));
+                if (tag) results[size_t(tag - 1)] = cqe->res;
+                io_uring_cqe_seen(&ring.ring, cqe);
+            }
+        }
+    }
+
+    // Open each path (null entries skipped) through the ring, or with
+    // open(2) on kernels without IORING_OP_OPENAT
+    static std::vector<int> uringOpen(Ring& ring, const std::vector<QByteArray>& paths, int flags) {
+        std::vector<int> fds(paths.size(), -1);
+        if (ring.openat && ring.ready) {
+            uringSubmit(ring, paths.size(), fds, [&](io_uring_sqe* sqe, size_t i) {
+                if (paths[i].isNull()) return false;
+                io_uring_prep_openat(sqe, AT_FDCWD, paths[i].constData(), flags | O_CLOEXEC, 0644);
+                return true;
+            });
+            for (int& fd : fds) fd = std::max(fd, -1);
+        } else {
+            for (size_t i = 0; i < paths.size(); ++i) {
+                if (!paths[i].isNull()) fds[i] = ::open(paths[i].constData(), flags | O_CLOEXEC, 0644);
+            }
+        }
+        return fds;
+    }
+
+    static void uringClose(Ring& ring, const std::vector<int>& fds) {
+        if (ring.close && ring.ready) {
+            std::vector<int> ignored(fds.size(), 0);
+            uringSubmit(ring, fds.size(), ignored, [&](io_uring_sqe* sqe, size_t i) {
+                if (fds[i] < 0) return false;
+                io_uring_prep_close(sqe, fds[i]);
+                return true;
+            });
+        } else {
+            for (int fd : fds) {
+                if (fd >= 0) ::close(fd);
+            }
+        }
+    }
+
+    struct Op {
+        int fd = -1;
+        char* buffer = nullptr;
+        size_t size = 0;
+        int result = -1;
+    };
+
+    // Transfer each op's whole buffer at offset 0; short transfers are
+    // finished with plain pread/pwrite
+    static void uringTransfer(Ring& ring, std::vector<Op>& ops, bool writing) {
+        std::vector<int> results(ops.size(), -1);
+        uringSubmit(ring, ops.size(), results, [&](io_uring_sqe* sqe, size_t i) {
+            if (ops[i].fd < 0) return false;
+            if (writing) io_uring_prep_write(sqe, ops[i].fd, ops[i].buffer, unsigned(ops[i].size), 0);
+            else io_uring_prep_read(sqe, ops[i].fd, ops[i].buffer, unsigned(ops[i].size), 0);
+            return true;
+        });
+
+        for (size_t i = 0; i < ops.size(); ++i) {
+            Op& op = ops[i];
+            if (op.fd < 0 || results[i] < 0) continue;
+            size_t done = size_t(results[i]);
+            while (done < op.size) {
+                ssize_t n = writing ? ::pwrite(op.fd, op.buffer + done, op.size - done, off_t(done))
+                                    : ::pread(op.fd, op.buffer + done, op.size - done, off_t(done));
+                if (n <= 0) break;
+                done += size_t(n);
+            }
+            op.result = int(done);
+        }
+    }
+
+    // Open, size, read and close as four ring submissions; callers pass at
+    // most kRingDepth paths so the opened descriptors stay bounded
+    static QList<QByteArray> uringRead(const QStringList& paths) {
+        Ring& ring = threadRing();
+        std::vector<QByteArray> names;
+        for (const QString& path : paths) names.push_back(QFile::encodeName(path));
+        std::vector<int> fds = uringOpen(ring, names, O_RDONLY);
+
+        std::vector<qint64> sizes(fds.size(), -1);
+        if (ring.statx && ring.ready) {
+            std::vector<struct statx> info(fds.size());
+            std::vector<int> results(fds.size(), -1);
+            uringSubmit(ring, fds.size(), results, [&](io_uring_sqe* sqe, size_t i) {
+                if (fds[i] < 0) return false;
+                io_uring_prep_statx(sqe, fds[i], "", AT_EMPTY_PATH, STATX_SIZE, &info[i]);
+                return true;
+            });
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (results[i] == 0) sizes[i] = qint64(info[i].stx_size);
+            }
+        } else {
+            for (size_t i = 0; i < fds.size(); ++i) {
+                struct stat info;
+                if (fds[i] >= 0 && ::fstat(fds[i], &info) == 0) sizes[i] = qint64(info.st_size);
+            }
+        }
+
+        QList<QByteArray> result;
+        std::vector<Op> ops(fds.size());
+        for (size_t i = 0; i < fds.size(); ++i) {
+            result << QByteArray();
+            if (fds[i] < 0 || sizes[i] <= 0) continue;
+            result[int(i)] = QByteArray(int(sizes[i]), Qt::Uninitialized);
+            ops[i] = Op{fds[i], result[int(i)].data(), size_t(sizes[i]), -1};
+        }
+        uringTransfer(ring, ops, false);
+        uringClose(ring, fds);
+        for (size_t i = 0; i < ops.size(); ++i) {
+            if (ops[i].result != int(ops[i].size)) result[int(i)].clear();
+        }
+        return result;
+    }
+
+    static QList<bool> uringWrite(const QList<FileData>& files) {
+        static std::atomic<quint64> serial{0};
+        Ring& ring = threadRing();
+        QList<bool> result;
+        std::vector<QByteArray> temps;
+        for (const FileData& file : files) {
+            temps.push_back(QFile::encodeName(QString("%1.%2-%3.tmp").arg(file.first)
+                                              .arg(QCoreApplication::applicationPid()).arg(serial++)));
+        }
+        std::vector<int> fds = uringOpen(ring, temps, O_WRONLY | O_CREAT | O_TRUNC);
+        std::vector<Op> ops(fds.size());
+        for (int i = 0; i < files.size(); ++i) {
+            ops[size_t(i)] = Op{fds[size_t(i)], const_cast<char*>(files[i].second.constData()),
+                                size_t(files[i].second.size()), -1};
+        }
+        uringTransfer(ring, ops, true);
+        uringClose(ring, fds);
+        for (int i = 0; i < files.size(); ++i) {
+            result << false;
+            if (fds[size_t(i)] < 0) continue;
+            const QByteArray& temp = temps[size_t(i)];
+            result[i] = ops[size_t(i)].result == int(ops[size_t(i)].size)
+                        && ::rename(temp.constData(), QFile::encodeName(files[i].first).constData()) == 0;
+            if (!result[i]) ::unlink(temp.constData());
+        }
+        return result;
+    }
+#endif
+};
+
+#endif // BATCHIO_H
@@ -0,0 +1,209 @@
+// BufferPool.h - Size-classed, thread-safe pool for large image buffers
+// Tiles, mosaic canvases and output frames are recycled through here so that
+// steady-state batch runs stop hitting malloc/mmap and page faults per target.
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <QImage>
+#include <QImageReader>
+#include <QIODevice>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDebug>
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include "MemoryBudget.h"
+
+class BufferPool {
+public:
+    struct Stats {
+        qint64 hits;              // Acquires served from a free list
+        qint64 misses;            // Acquires that had to allocate
+        qint64 retainedBytes;     // Bytes parked in free lists
+        qint64 outstandingBytes;  // Bytes currently handed out
+    };
+
+    // Process-wide pool shared by decode, assembly, resampling and encode
+    static BufferPool& instance() {
+        static BufferPool pool;
+        return pool;
+    }
+
+    ~BufferPool() {
+        MemoryAccounting::instance().setReclaimer(nullptr);
+        trim();
+    }
+
+    // Acquire a 64-byte aligned buffer of at least `bytes`
+    void* acquire(size_t bytes) {
+        int sizeClass = classFor(bytes);
+        size_t capacity = sizeClass < kNumClasses ? classCapacity(sizeClass) : bytes;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            if (sizeClass < kNumClasses && !m_freeLists[sizeClass].empty()) {
+                void* ptr = m_freeLists[sizeClass].back();
+                m_freeLists[sizeClass].pop_back();
+                m_stats.hits++;
+                m_stats.retainedBytes -= capacity;
+                m_stats.outstandingBytes += capacity;
+                locker.unlock();
+                MemoryAccounting::instance().discharge(MemoryStage::PoolIdle, capacity);
+                return ptr;
+            }
+            m_stats.misses++;
+            m_stats.outstandingBytes += capacity;
+        }
+
+        // Header in front of the payload remembers the capacity for release()
+        char* base = static_cast<char*>(::operator new(capacity + kHeaderSize,
+                                                       std::align_val_t(kAlignment)));
+        *reinterpret_cast<size_t*>(base) = capacity;
+        return base + kHeaderSize;
+    }
+
+    // Return a buffer obtained from acquire()
+    void release(void* ptr) {
+        if (!ptr) return;
+
+        char* base = static_cast<char*>(ptr) - kHeaderSize;
+        size_t capacity = *reinterpret_cast<size_t*>(base);
+        int sizeClass = classFor(capacity);
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stats.outstandingBytes -= capacity;
+            if (sizeClass < kNumClasses &&
+                m_stats.retainedBytes + qint64(capacity) <= m_maxRetainedBytes) {
+                m_freeLists[sizeClass].push_back(ptr);
+                m_stats.retainedBytes += capacity;
+                locker.unlock();
+                MemoryAccounting::instance().charge(MemoryStage::PoolIdle, capacity);
+                return;
+            }
+        }
+
+        ::operator delete(base, std::align_val_t(kAlignment));
+    }
+
+    // QImage backed by a pooled buffer; the buffer returns to the pool when
+    // the last implicitly-shared copy of the image is destroyed
+    QImage createImage(int width, int height, QImage::Format format) {
+        if (width <= 0 || height <= 0) return QImage();
+
+        int depth = QImage::toPixelFormat(format).bitsPerPixel();
+        int bytesPerLine = ((width * depth + 31) / 32) * 4;
+        void* data = acquire(size_t(bytesPerLine) * height);
+
+        return QImage(static_cast<uchar*>(data), width, height, bytesPerLine, format,
+                      &BufferPool::releaseImageBuffer, data);
+    }
+
+    // Decode an image into a pooled buffer. Qt's JPEG/PNG handlers reuse the
+    // destination when its size and format already match, so pre-sizing the
+    // target for the expected tile shape skips the decoder's own allocation.
+    QImage readImage(QIODevice* device, const QSize& expectedSize = QSize(),
+                     QImage::Format expectedFormat = QImage::Format_RGB32,
+                     const char* format = nullptr) {
+        QImageReader reader(device, format);
+        QSize size = reader.size();
+        if (!size.isValid()) size = expectedSize;
+
+        QImage image;
+        if (size.isValid() && reader.imageFormat() == expectedFormat) {
+            image = createImage(size.width(), size.height(), expectedFormat);
+        }
+
+        if (!reader.read(&image)) {
+            return QImage();
+        }
+        return image;
+    }
+
+    // Cap on bytes parked in free lists; anything above is freed on release
+    void setMaxRetainedBytes(qint64 bytes) {
+        QMutexLocker locker(&m_mutex);
+        m_maxRetainedBytes = bytes;
+    }
+
+    Stats stats() const {
+        QMutexLocker locker(&m_mutex);
+        return m_stats;
+    }
+
+    // Free every parked buffer
+    void trim() {
+        QMutexLocker locker(&m_mutex);
+        qint64 freed = 0;
+        for (int i = 0; i < kNumClasses; ++i) {
+            for (void* ptr : m_freeLists[i]) {
+                ::operator delete(static_cast<char*>(ptr) - kHeaderSize,
+                                  std::align_val_t(kAlignment));
+            }
+            freed += qint64(m_freeLists[i].size()) * classCapacity(i);
+            m_freeLists[i].clear();
+        }
+        m_stats.retainedBytes -= freed;
+        locker.unlock();
+        MemoryAccounting::instance().discharge(MemoryStage::PoolIdle, freed);
+    }
+
+    void printStats() const {
+        Stats s = stats();
+        qDebug() << QString("BufferPool: %1 hits, %2 misses, %3 MB retained, %4 MB outstanding")
+                    .arg(s.hits).arg(s.misses)
+                    .arg(s.retainedBytes / (1024.0 * 1024.0), 0, 'f', 1)
+                    .arg(s.outstandingBytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+
+private:
+    // Four classes per power of two (x1.25, x1.5, x1.75, x2) keep the
+    // worst-case slack under 25% for odd sizes like 1536x1536 RGB32.
+    static constexpr int kMinShift = 16;            // 64 KiB smallest class
+    static constexpr int kStepsPerOctave = 4;
+    static constexpr int kNumClasses = 15 * kStepsPerOctave;  // up to 2 GiB
+    static constexpr size_t kAlignment = 64;
+    static constexpr size_t kHeaderSize = 64;
+
+    mutable QMutex m_mutex;
+    std::vector<void*> m_freeLists[kNumClasses];
+    qint64 m_maxRetainedBytes = 512LL * 1024 * 1024;
+    Stats m_stats = {0, 0, 0, 0};
+
+    BufferPool() {
+        // Construct the accounting singleton first so it outlives the pool;
+        // idle buffers are freed when admission would otherwise exceed the budget
+        MemoryAccounting::instance().setReclaimer(&BufferPool::trimInstance);
+    }
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    static int classFor(size_t bytes) {
+        if (bytes <= (size_t(1) << kMinShift)) return 0;
+
+        int shift = 63 - __builtin_clzll(static_cast<unsigned long long>(bytes - 1));
+        size_t step = size_t(1) << (shift - 2);
+        size_t steps = (bytes + step - 1) / step;   // 5..8 quarter-octaves
+        int index = (shift - kMinShift) * kStepsPerOctave + int(steps) - kStepsPerOctave - 1;
+        return index < kNumClasses ? index : kNumClasses;
+    }
+
+    static size_t classCapacity(int sizeClass) {
+        int octave = sizeClass / kStepsPerOctave;
+        int step = sizeClass % kStepsPerOctave;
+        size_t base = size_t(1) << (kMinShift + octave);
+        return base + (base / kStepsPerOctave) * (step + 1);
+    }
+
+    static void releaseImageBuffer(void* info) {
+        BufferPool::instance().release(info);
+    }
+
+    static void trimInstance() {
+        BufferPool::instance().trim();
+    }
+};
+
+#endif // BUFFERPOOL_H
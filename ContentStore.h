@@ -0,0 +1,420 @@
+// ContentStore.h - Content-addressed blobs with per-key references
+// Each unique payload is stored once as blobs/<h0h1>/<sha1>.<ext>, and a
+// key points at it through refs/<key>.ref holding the hash. Both live in a
+// TieredCache, so dedupe holds in RAM, locally and on shared tiers alike.
+// Hashes known to decode to a single colour are recorded as
+// blank/<sha1>.fill so later loads skip decoding altogether.
+//
+// With TileCodec available, JPEG blobs are recompressed losslessly in the
+// background to blobs/<h0h1>/<sha1>.jxl in the local directory tiers and
+// the JPEG copy there dropped; reads restore the original bytes. Packing
+// only saves disk space: the RAM tier keeps plain JPEGs so hot reads never
+// unpack, and shared tiers keep them so builds without libjxl can use them.
+// DSS_TILE_CODEC=none turns recompression off.
+//
+// A reference re-pointed to new content leaves its old blob behind; gc()
+// sweeps blobs no reference points at from the private tiers.
+#ifndef CONTENTSTORE_H
+#define CONTENTSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QColor>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include "TieredCache.h"
+#include "TileCodec.h"
+#include "Snapshot.h"
+
+class ContentStore {
+public:
+    // Tiers come from TieredCache::standardTiers(localDir, sharedName)
+    ContentStore(const QString& localDir, const QString& sharedName, const QString& extension)
+        : m_localDir(localDir), m_extension(extension) {
+        const char* codec = std::getenv("DSS_TILE_CODEC");
+        m_packing = TileCodec::available() && extension == "jpg"
+                    && !(codec && QString(codec) == "none");
+        m_packer.setMaxThreadCount(1);
+        m_tiers = std::make_unique<TieredCache>(
+            TieredCache::standardTiers(localDir, sharedName),
+            QStringList() << "*." + extension << "*." + TileCodec::extension() << "*.ref" << "*.fill");
+    }
+
+    ~ContentStore() {
+        m_packer.waitForDone();
+    }
+
+    static QString hashOf(const QByteArray& data) {
+        return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+    }
+
+    // Store `data` under `key`; the blob is written only if no tier has
+    // it yet. Returns the content hash, or empty on failure.
+    QString put(const QString& key, const QByteArray& data) {
+        if (data.isEmpty()) return QString();
+        QString hash = hashOf(data);
+
+        if (m_tiers->contains(blobKey(hash)) || (m_packing && m_tiers->contains(packedKey(hash)))) {
+            m_dedupedPuts++;
+        } else if (!m_tiers->put(blobKey(hash), data)) {
+            return QString();
+        } else {
+            schedulePack(hash, data);
+        }
+
+        QString previous = referenceOf(key);
+        if (previous != hash) {
+            if (!m_tiers->put(refKey(key), hash.toLatin1())) return QString();
+            if (!previous.isEmpty()) m_superseded++;
+            QMutexLocker locker(&m_mutex);
+            m_refs.insert(key, hash);
+        }
+        return hash;
+    }
+
+    // Hash `key` points at, or empty if it was never stored
+    QString referenceOf(const QString& key) {
+        {
+            QMutexLocker locker(&m_mutex);
+            auto it = m_refs.constFind(key);
+            if (it != m_refs.constEnd()) return *it;
+        }
+        QString hash = QString::fromLatin1(m_tiers->get(refKey(key))).trimmed();
+        if (hash.isEmpty()) return QString();
+        QMutexLocker locker(&m_mutex);
+        m_refs.insert(key, hash);
+        return hash;
+    }
+
+    QByteArray blob(const QString& hash) {
+        if (hash.isEmpty()) return QByteArray();
+        if (m_packing) {
+            QByteArray data = m_tiers->peek(blobKey(hash), CacheTier::Memory);
+            if (!data.isEmpty()) return data;
+            QByteArray packed = m_tiers->peek(packedKey(hash), CacheTier::Disk);
+            data = unpack(packed);
+            if (!data.isEmpty()) {
+                m_tiers->putTo(CacheTier::Memory, blobKey(hash), data);
+                return data;
+            }
+        }
+        QByteArray data = m_tiers->get(blobKey(hash));
+        // Blobs stored before packing was on, or promoted from a shared tier
+        if (!data.isEmpty()) schedulePack(hash, data);
+        return data;
+    }
+
+    // The stored bytes, also for blank hashes. Readers that short-circuit
+    // blank hashes through isBlank() (EnhancedMosaicCreator::loadTile)
+    // hand out a 1x1 placeholder instead of a full tile; anything that
+    // takes the size of such an image or crops it must check
+    // EnhancedMosaicCreator::blankFill() first.
+    QByteArray get(const QString& key) {
+        return blob(referenceOf(key));
+    }
+
+    // Read the references, then the non-blank blobs, of `keys` as two
+    // batches so later get()/blob() calls are served from the RAM tier.
+    // Without a RAM tier only blobs missing locally are fetched.
+    void prefetch(const QStringList& keys) {
+        QStringList unresolved, refKeys;
+        {
+            QMutexLocker locker(&m_mutex);
+            for (const QString& key : keys) {
+                if (m_refs.contains(key)) continue;
+                unresolved << key;
+                refKeys << refKey(key);
+            }
+        }
+        QList<QByteArray> refs = m_tiers->getMany(refKeys);
+
+        QStringList blobKeys;
+        QMutexLocker locker(&m_mutex);
+        for (int i = 0; i < unresolved.size(); ++i) {
+            QString hash = QString::fromLatin1(refs[i]).trimmed();
+            if (!hash.isEmpty()) m_refs.insert(unresolved[i], hash);
+        }
+        QStringList hashes;
+        for (const QString& key : keys) {
+            QString hash = m_refs.value(key);
+            if (hash.isEmpty() || m_blank.contains(hash)) continue;
+            hashes << hash;
+            blobKeys << blobKey(hash);
+        }
+        locker.unlock();
+
+        // Packed copies are unpacked into RAM as JPEGs; the rest read through
+        if (m_packing && m_tiers->hasTier(CacheTier::Memory)) {
+            QList<QByteArray> inRam = m_tiers->peekMany(blobKeys, CacheTier::Memory);
+            QStringList packedKeys, unpackedKeys;
+            for (int i = 0; i < hashes.size(); ++i) {
+                if (inRam[i].isEmpty()) packedKeys << packedKey(hashes[i]);
+            }
+            QList<QByteArray> packed = m_tiers->peekMany(packedKeys, CacheTier::Disk);
+            for (int i = 0, p = 0; i < hashes.size(); ++i) {
+                if (!inRam[i].isEmpty()) continue;
+                QByteArray data = unpack(packed[p++]);
+                if (data.isEmpty()) unpackedKeys << blobKey(hashes[i]);
+                else m_tiers->putTo(CacheTier::Memory, blobKey(hashes[i]), data);
+            }
+            blobKeys = unpackedKeys;
+        } else if (m_packing) {
+            QStringList unpackedKeys;
+            for (const QString& hash : hashes) {
+                if (!m_tiers->contains(packedKey(hash))) unpackedKeys << blobKey(hash);
+            }
+            blobKeys = unpackedKeys;
+        }
+        m_tiers->prefetch(blobKeys);
+    }
+
+    // Wait until queued local writes are on disk
+    void flushLocal() {
+        m_tiers->flushLocal();
+    }
+
+    // Whether `hash` is known to be a uniform tile, and its colour
+    bool isBlank(const QString& hash, QRgb* fill) {
+        {
+            QMutexLocker locker(&m_mutex);
+            auto it = m_blank.constFind(hash);
+            if (it != m_blank.constEnd()) {
+                if (fill) *fill = *it;
+                return true;
+            }
+            if (m_notBlank.contains(hash)) return false;
+        }
+        QByteArray stored = m_tiers->get(blankKey(hash));
+        QMutexLocker locker(&m_mutex);
+        if (stored.isEmpty()) {
+            // Remembered for this run only; the caller classifies it next
+            m_notBlank.insert(hash);
+            return false;
+        }
+        QRgb colour = QColor(QString::fromLatin1(stored).trimmed()).rgb();
+        m_blank.insert(hash, colour);
+        if (fill) *fill = colour;
+        return true;
+    }
+
+    void markBlank(const QString& hash, QRgb fill) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_blank.insert(hash, fill);
+            m_notBlank.remove(hash);
+        }
+        m_tiers->put(blankKey(hash), QColor(fill).name().toLatin1());
+    }
+
+    void markNotBlank(const QString& hash) {
+        QMutexLocker locker(&m_mutex);
+        m_notBlank.insert(hash);
+    }
+
+    // References re-pointed to a different hash during this run
+    qint64 supersededRefs() const { return m_superseded.load(); }
+
+    // Mark and sweep over the local directory: blobs and blank marks that
+    // no reference points at are removed from the private tiers. Files
+    // younger than minAgeSecs are kept, because another process sharing
+    // the directory may have written a blob but not yet its reference.
+    // Shared tiers are left alone. Returns the number of files removed.
+    int gc(qint64 minAgeSecs = 3600) {
+        m_tiers->flushLocal();
+        QStringList refPaths;
+        QDirIterator refs(m_localDir + "/refs", QStringList() << "*.ref", QDir::Files);
+        while (refs.hasNext()) refPaths << refs.next();
+
+        QSet<QString> live;
+        for (const QByteArray& stored : BatchIO::readFiles(refPaths)) {
+            QString hash = QString::fromLatin1(stored).trimmed();
+            // An unreadable reference could hide a live blob: sweep nothing
+            if (hash.isEmpty()) return 0;
+            live.insert(hash);
+        }
+        {
+            QMutexLocker locker(&m_mutex);
+            for (const QString& hash : m_refs) live.insert(hash);
+        }
+
+        QDateTime cutoff = QDateTime::currentDateTime().addSecs(-minAgeSecs);
+        QDir root(m_localDir);
+        QStringList garbage;
+        QDirIterator it(m_localDir, QStringList() << "*." + m_extension << "*." + TileCodec::extension()
+                                                  << "*.fill",
+                        QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            QFileInfo info = it.fileInfo();
+            QString relative = root.relativeFilePath(info.absoluteFilePath());
+            if (!relative.startsWith("blobs/") && !relative.startsWith("blank/")) continue;
+            if (live.contains(info.completeBaseName()) || info.lastModified() > cutoff) continue;
+            garbage << relative;
+        }
+
+        for (const QString& key : garbage) {
+            m_tiers->remove(key);
+            QString hash = QFileInfo(key).completeBaseName();
+            QMutexLocker locker(&m_mutex);
+            m_blank.remove(hash);
+            m_notBlank.remove(hash);
+        }
+        if (!garbage.isEmpty()) {
+            qDebug() << QString("Content store: collected %1 unreferenced files").arg(garbage.size());
+        }
+        m_superseded = 0;
+        return garbage.size();
+    }
+
+    // Keys with a reference in the local directory tier
+    QStringList localKeys() const {
+        QStringList keys;
+        QDirIterator it(m_localDir + "/refs", QStringList() << "*.ref", QDir::Files);
+        while (it.hasNext()) {
+            it.next();
+            keys << it.fileInfo().completeBaseName();
+        }
+        return keys;
+    }
+
+    const TieredCache& tiers() const { return *m_tiers; }
+
+    // Rough heap held by the in-memory reference and blank indexes:
+    // UTF-16 key and hash strings plus a hash node each
+    qint64 indexBytes() const {
+        constexpr qint64 kNode = 48;
+        constexpr qint64 kHash = 2 * 40;
+        QMutexLocker locker(&m_mutex);
+        qint64 bytes = 0;
+        for (auto it = m_refs.constBegin(); it != m_refs.constEnd(); ++it) {
+            bytes += kNode + 2 * it.key().size() + kHash;
+        }
+        return bytes + (m_blank.size() + m_notBlank.size()) * (kNode + kHash);
+    }
+
+    // Resolved references and blank hashes, for warm-start snapshots
+    void saveIndex(SnapshotWriter& writer, const QString& prefix) const {
+        QMutexLocker locker(&m_mutex);
+        writer.addStream(prefix + "refs", m_refs);
+        writer.addStream(prefix + "blank", m_blank);
+    }
+
+    bool loadIndex(const Snapshot& snapshot, const QString& prefix) {
+        QHash<QString, QString> refs;
+        QHash<QString, QRgb> blank;
+        if (!snapshot.readStream(prefix + "refs", refs) || !snapshot.readStream(prefix + "blank", blank)) {
+            return false;
+        }
+        QMutexLocker locker(&m_mutex);
+        m_refs = refs;
+        m_blank = blank;
+        return true;
+    }
+
+    void printStats() const {
+        QMutexLocker locker(&m_mutex);
+        qDebug() << QString("Content store: %1 puts deduplicated, %2 blank hashes known")
+                    .arg(m_dedupedPuts.load()).arg(m_blank.size());
+        locker.unlock();
+        if (m_packing) {
+            // Compare the unpack cost with the read time the saved bytes buy
+            qint64 in = m_packedIn.load(), out = m_packedOut.load(), unpacked = m_unpacked.load();
+            qDebug() << QString("  %1: %2 blobs packed, %3 MB saved (%4%), unpack %5 ms/tile over %6 reads, %7 rejected")
+                        .arg(TileCodec::extension()).arg(m_packedBlobs.load())
+                        .arg((in - out) / (1024.0 * 1024.0), 0, 'f', 1)
+                        .arg(in > 0 ? 100.0 * (in - out) / in : 0.0, 0, 'f', 1)
+                        .arg(unpacked > 0 ? m_unpackNs.load() / 1e6 / unpacked : 0.0, 0, 'f', 2)
+                        .arg(unpacked).arg(m_packRejected.load());
+        }
+        m_tiers->printStats();
+    }
+
+private:
+    QString m_localDir;
+    QString m_extension;
+    std::unique_ptr<TieredCache> m_tiers;
+    std::atomic<qint64> m_dedupedPuts{0};
+    std::atomic<qint64> m_superseded{0};
+
+    mutable QMutex m_mutex;
+    QHash<QString, QString> m_refs;     // key -> hash
+    QHash<QString, QRgb> m_blank;       // hash -> fill colour
+    QSet<QString> m_notBlank;
+    QSet<QString> m_queued;             // hashes waiting to be packed
+
+    bool m_packing = false;
+    QThreadPool m_packer;
+    std::atomic<qint64> m_packedBlobs{0};
+    std::atomic<qint64> m_packRejected{0};
+    std::atomic<qint64> m_packedIn{0};
+    std::atomic<qint64> m_packedOut{0};
+    std::atomic<qint64> m_unpacked{0};
+    std::atomic<qint64> m_unpackNs{0};
+
+    QString blobKey(const QString& hash) const {
+        return QString("blobs/%1/%2.%3").arg(hash.left(2)).arg(hash).arg(m_extension);
+    }
+
+    static QString packedKey(const QString& hash) {
+        return QString("blobs/%1/%2.%3").arg(hash.left(2)).arg(hash).arg(TileCodec::extension());
+    }
+
+    QByteArray unpack(const QByteArray& packed) {
+        if (packed.isEmpty()) return QByteArray();
+        QElapsedTimer timer;
+        timer.start();
+        QByteArray data = TileCodec::unpack(packed);
+        m_unpackNs += timer.nsecsElapsed();
+        m_unpacked++;
+        return data;
+    }
+
+    // Recompress off the caller's thread; the packed copy replaces the
+    // local JPEG only if it is smaller and restores to the identical bytes
+    void schedulePack(const QString& hash, const QByteArray& data) {
+        if (!m_packing) return;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queued.contains(hash)) return;
+            m_queued.insert(hash);
+        }
+        m_packer.start([this, hash, data]() {
+            QByteArray packed = TileCodec::pack(data);
+            if (!packed.isEmpty() && packed.size() < data.size() && TileCodec::unpack(packed) == data
+                && m_tiers->putTo(CacheTier::Disk, packedKey(hash), packed)) {
+                m_tiers->removeFrom(CacheTier::Disk, blobKey(hash));
+                m_packedBlobs++;
+                m_packedIn += data.size();
+                m_packedOut += packed.size();
+            } else {
+                m_packRejected++;
+            }
+            QMutexLocker locker(&m_mutex);
+            m_queued.remove(hash);
+        });
+    }
+
+    static QString refKey(const QString& key) {
+        return QString("refs/%1.ref").arg(key);
+    }
+
+    static QString blankKey(const QString& hash) {
+        return QString("blank/%1.fill").arg(hash);
+    }
+};
+
+#endif // CONTENTSTORE_H
@@ -0,0 +1,176 @@
+// DeepZoom.h - Tiled multi-resolution export (Deep Zoom / DZI) for mosaics
+// Writes <name>.dzi plus <name>_files/<level>/<col>_<row>.<format>, where
+// the top level is full size and each level below is a 2x2 area average
+// of the one above, down to 1x1. Viewers (OpenSeadragon etc.) then fetch
+// only the tiles in view at the zoom they need. The writer takes a finished
+// image: mosaics and frames are already whole QImages when they are saved.
+#ifndef DEEPZOOM_H
+#define DEEPZOOM_H
+
+#include <QImage>
+#include <QString>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "MemoryBudget.h"
+
+struct DeepZoomOptions {
+    int tileSize = 254;         // 254 + 2 * overlap = 256 pixel tiles
+    int overlap = 1;            // Pixels shared with each neighbour
+    QString format = "jpg";     // jpg or png
+    int quality = 90;
+    int threads = 0;            // 0 = one per core
+};
+
+class DeepZoomWriter {
+public:
+    explicit DeepZoomWriter(const DeepZoomOptions& options = DeepZoomOptions()) : m_options(options) {}
+
+    static int levelCount(int width, int height) {
+        int size = std::max(width, height);
+        int levels = 1;
+        while ((1 << (levels - 1)) < size) ++levels;
+        return levels;
+    }
+
+    // dziPath names the descriptor; tiles go in the sibling _files directory.
+    // Each level is one fork/join: its tiles are encoded while the next
+    // level down is averaged from it, both by the same workers.
+    bool write(const QImage& image, const QString& dziPath) const {
+        if (image.isNull()) return false;
+
+        QFileInfo info(dziPath);
+        QString filesDir = info.absolutePath() + "/" + info.completeBaseName() + "_files";
+        if (QDir(filesDir).exists()) QDir(filesDir).removeRecursively();
+
+        int threads = m_options.threads > 0 ? m_options.threads
+                                            : std::max(1, QThread::idealThreadCount());
+        QImage level = image.convertToFormat(QImage::Format_RGB32);
+        MemoryCharge levelCharge(MemoryStage::PyramidExport, level.sizeInBytes());
+        std::atomic<bool> ok{true};
+
+        for (int l = levelCount(image.width(), image.height()) - 1; l >= 0; --l) {
+            QString levelDir = QString("%1/%2").arg(filesDir).arg(l);
+            if (!QDir().mkpath(levelDir)) return false;
+
+            const int step = m_options.tileSize;
+            const int cols = (level.width() + step - 1) / step;
+            const int rows = (level.height() + step - 1) / step;
+            const int tiles = cols * rows;
+
+            QImage next;
+            int bands = 0;
+            if (l > 0) {
+                next = QImage((level.width() + 1) / 2, (level.height() + 1) / 2, QImage::Format_RGB32);
+                bands = (next.height() + kBandRows - 1) / kBandRows;
+            }
+            MemoryCharge nextCharge(MemoryStage::PyramidExport, next.sizeInBytes());
+
+            // Detach once here; workers only write through the raw pointer
+            const QImage& current = level;
+            uchar* nextBits = next.isNull() ? nullptr : next.bits();
+            const int nextStride = next.bytesPerLine();
+            const int nextWidth = next.width();
+            parallelFor(tiles + bands, threads, [&](int i) {
+                if (i < tiles) {
+                    if (!writeTile(current, i % cols, i / cols, levelDir)) ok = false;
+                } else {
+                    int y0 = (i - tiles) * kBandRows;
+                    halveRows(current, nextBits, nextStride, nextWidth,
+                              y0, std::min(next.height(), y0 + kBandRows));
+                }
+            });
+            if (!ok) {
+                qDebug() << "Failed to write Deep Zoom tiles to" << levelDir;
+                return false;
+            }
+            if (l > 0) {
+                level = next;
+                levelCharge.resize(level.sizeInBytes());
+            }
+        }
+
+        return writeDescriptor(dziPath, image.width(), image.height());
+    }
+
+private:
+    static constexpr int kBandRows = 64;
+    DeepZoomOptions m_options;
+
+    template <typename Fn>
+    static void parallelFor(int count, int threads, Fn&& fn) {
+        std::atomic<int> next{0};
+        auto worker = [&]() {
+            for (int i = next++; i < count; i = next++) fn(i);
+        };
+        std::vector<std::thread> workers;
+        for (int t = 1; t < std::min(threads, count); ++t) workers.emplace_back(worker);
+        worker();
+        for (std::thread& thread : workers) thread.join();
+    }
+
+    bool writeTile(const QImage& level, int col, int row, const QString& levelDir) const {
+        const int step = m_options.tileSize;
+        const int overlap = m_options.overlap;
+        int x0 = std::max(0, col * step - overlap);
+        int y0 = std::max(0, row * step - overlap);
+        int x1 = std::min(level.width(), (col + 1) * step + overlap);
+        int y1 = std::min(level.height(), (row + 1) * step + overlap);
+
+        QImage tile = level.copy(x0, y0, x1 - x0, y1 - y0);
+        QString path = QString("%1/%2_%3.%4").arg(levelDir).arg(col).arg(row).arg(m_options.format);
+        return tile.save(path, nullptr, m_options.quality);
+    }
+
+    // Output rows [y0, y1) of the half-size level: each pixel is the mean
+    // of the up-to-2x2 source pixels it covers (odd edges average fewer)
+    static void halveRows(const QImage& src, uchar* dst, int dstStride, int dstWidth,
+                          int y0, int y1) {
+        const int sw = src.width(), sh = src.height();
+        for (int y = y0; y < y1; ++y) {
+            const QRgb* r0 = reinterpret_cast<const QRgb*>(src.constScanLine(2 * y));
+            const QRgb* r1 = reinterpret_cast<const QRgb*>(src.constScanLine(std::min(2 * y + 1, sh - 1)));
+            const int rowsIn = (2 * y + 1 < sh) ? 2 : 1;
+            QRgb* out = reinterpret_cast<QRgb*>(dst + size_t(y) * dstStride);
+            for (int x = 0; x < dstWidth; ++x) {
+                int xa = 2 * x, xb = std::min(2 * x + 1, sw - 1);
+                int n = rowsIn * ((2 * x + 1 < sw) ? 2 : 1);
+                int r = 0, g = 0, b = 0;
+                auto sum = [&](QRgb p) { r += qRed(p); g += qGreen(p); b += qBlue(p); };
+                sum(r0[xa]);
+                if (xb != xa) sum(r0[xb]);
+                if (rowsIn == 2) {
+                    sum(r1[xa]);
+                    if (xb != xa) sum(r1[xb]);
+                }
+                out[x] = qRgb((r + n / 2) / n, (g + n / 2) / n, (b + n / 2) / n);
+            }
+        }
+    }
+
+    bool writeDescriptor(const QString& dziPath, int width, int height) const {
+        QFile file(dziPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qDebug() << "Failed to write Deep Zoom descriptor:" << dziPath;
+            return false;
+        }
+        QTextStream out(&file);
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\"\n"
+            << "       Format=\"" << m_options.format << "\" Overlap=\"" << m_options.overlap
+            << "\" TileSize=\"" << m_options.tileSize << "\">\n"
+            << "  <Size Width=\"" << width << "\" Height=\"" << height << "\"/>\n"
+            << "</Image>\n";
+        return true;
+    }
+};
+
+#endif // DEEPZOOM_H
@@ -5,17 +5,34 @@ EnhancedMosaicCreator::EnhancedMosaicCreator(QObject *parent)  // CHANGED: QObje
     : QObject(parent) {  // CHANGED: QObject constructor
     
     m_hipsClient = new ProperHipsClient(this);
+    m_survey = m_hipsClient->surveys().id("DSS2_Color");
     m_networkManager = new QNetworkAccessManager(this);
     m_currentTileIndex = 0;
     
     QString homeDir = QDir::homePath();
     m_outputDir = QDir(homeDir).absoluteFilePath("Library/Application Support/OriginSimulator/Images/mosaics");
     QDir().mkpath(m_outputDir);
+    m_tileStore = std::make_unique<ContentStore>(m_outputDir + "/tile_store", "tile_store", "jpg");
+    scanTileStore();
+    m_renderCache = std::make_unique<RenderCache>(m_outputDir + "/render_cache");
+    m_pixelSlab = PixelSlab::fromEnvironment(m_outputDir + "/tile_store/pixels.slab");
+    
+    m_snapshotTimer = new QTimer(this);
+    m_snapshotTimer->setInterval(5 * 60 * 1000);
+    connect(m_snapshotTimer, &QTimer::timeout, this, &EnhancedMosaicCreator::saveTileSnapshot);
+    m_snapshotTimer->start();
     
     qDebug() << "=== Enhanced Mosaic Creator - Headless Mode ===";
     qDebug() << "Precise coordinate placement with sub-tile accuracy!";
 }
 
+EnhancedMosaicCreator::~EnhancedMosaicCreator() {
+    // Tiles that came back with new content leave their old blobs behind;
+    // sweep before the snapshot so its stamp matches the store
+    if (m_tileStore->supersededRefs() > 0) m_tileStore->gc();
+    saveTileSnapshot();
+}
+
 // NEW: Public coordinate setter method
 void EnhancedMosaicCreator::setCustomCoordinates(const QString& raText, const QString& decText, const QString& name) {
     try {
@@ -38,6 +55,10 @@ void EnhancedMosaicCreator::createCustomMosaic(const SkyPosition& target) {
     
     qDebug() << QString("\n=== Creating Coordinate-Centered Mosaic for %1 ===").arg(target.name);
     
+    if (reuseRenderedMosaic(target)) {
+        return;
+    }
+    
     // Store the actual target coordinates for precise centering
     createTileGrid(target);
     
@@ -50,11 +71,49 @@ void EnhancedMosaicCreator::createCustomMosaic(const SkyPosition& target) {
 }
 
 void EnhancedMosaicCreator::createTileGrid(const SkyPosition& position) {
-    m_tiles.clear();
-    int order = 8;
+    m_tiles = buildTileGrid(position, 8);
+    m_tileCharge.reset();
+    prefetchTiles(m_tiles);
+}
+
+static TileKey parentKey(const TileKey& key) {
+    return TileKey{key.pixel >> 2, key.survey, quint8(key.order - 1)};
+}
+
+// One batched read for the whole plan instead of one per tile
+void EnhancedMosaicCreator::prefetchTiles(const QList<SimpleTile>& tiles) {
+    QStringList keys;
+    for (const SimpleTile& tile : tiles) {
+        keys << tileKey(tile.key);
+    }
+    m_tileStore->prefetch(keys);
+}
+
+// Parents of the tiles that failed, fetched only once a tile has failed
+// and only where the store has no parent to cut from, so a grid whose
+// tiles all arrive never waits on them. Failed parents resolve to a null
+// image and the tile stays a hole.
+QList<Async::Future<QImage>> EnhancedMosaicCreator::fetchParents(const QList<SimpleTile>& tiles) {
+    QList<Async::Future<QImage>> fetches;
+    QSet<long long> seen;
+    for (const SimpleTile& tile : tiles) {
+        if (tile.downloaded || !tile.key.isValid() || tile.key.order == 0) continue;
+        TileKey parent = parentKey(tile.key);
+        if (seen.contains(parent.pixel)) continue;
+        seen.insert(parent.pixel);
+        if (!m_tileStore->referenceOf(tileKey(parent)).isEmpty()) continue;
+        fetches << fetchTile(parent).orElse(QImage());
+    }
+    return fetches;
+}
+
+QList<EnhancedMosaicCreator::SimpleTile> EnhancedMosaicCreator::buildTileGrid(const SkyPosition& position,
+                                                                             int order) const {
+    QList<SimpleTile> tiles;
     
     long long centerPixel = m_hipsClient->calculateHealPixel(position, order);
-    QList<QList<long long>> grid = m_hipsClient->createProper3x3Grid(centerPixel, order);
+    TileGrid grid = m_hipsClient->createProper3x3Grid(centerPixel, order);
+    SkyCoord center = position.coord();
     
     qDebug() << QString("Creating 3×3 tile grid around %1:").arg(position.name);
     
@@ -63,41 +122,310 @@ void EnhancedMosaicCreator::createTileGrid(const SkyPosition& position) {
             SimpleTile tile;
             tile.gridX = x;
             tile.gridY = y;
-            tile.healpixPixel = grid[y][x];
+            tile.key = grid.key(x, y, m_survey);
             tile.downloaded = false;
             
             // Calculate the sky coordinates for this tile
-            tile.skyCoordinates = healpixToSkyPosition(tile.healpixPixel, order);
-            
-            QString objectName = position.name.toLower();
-            tile.filename = QString("%1/tile_pixel%2.jpg")
-                           .arg(m_outputDir).arg(tile.healpixPixel);
-            
-            int dir = (tile.healpixPixel / 10000) * 10000;
-            tile.url = QString("http://alasky.u-strasbg.fr/DSS/DSSColor/Norder%1/Dir%2/Npix%3.jpg")
-                      .arg(order).arg(dir).arg(tile.healpixPixel);
+            tile.skyCoordinates = healpixToSkyCoord(tile.key.pixel, order);
             
             // Calculate distance from target to tile center
-            double distance = calculateAngularDistance(m_actualTarget, tile.skyCoordinates);
+            double distance = calculateAngularDistance(center, tile.skyCoordinates);
             
-            if (tile.healpixPixel == centerPixel) {
+            if (tile.key.pixel == centerPixel) {
                 qDebug() << QString("  Grid(%1,%2): HEALPix %3 ★ NEAREST TILE ★ (%4 arcsec from target)")
-                            .arg(x).arg(y).arg(tile.healpixPixel).arg(distance * 3600.0, 0, 'f', 1);
+                            .arg(x).arg(y).arg(tile.key.pixel).arg(distance * 3600.0, 0, 'f', 1);
             } else {
                 qDebug() << QString("  Grid(%1,%2): HEALPix %3 (%4 arcsec from target)")
-                            .arg(x).arg(y).arg(tile.healpixPixel).arg(distance * 3600.0, 0, 'f', 1);
+                            .arg(x).arg(y).arg(tile.key.pixel).arg(distance * 3600.0, 0, 'f', 1);
             }
             
-            m_tiles.append(tile);
+            tiles.append(tile);
+        }
+    }
+    
+    qDebug() << QString("Created %1 tile grid - will crop to center target precisely").arg(tiles.size());
+    return tiles;
+}
+
+// Tile store key, named after the loose tile files of older versions and
+// prefixed with the survey's source; order 8 of the built-in survey keeps
+// the historical name so existing tile caches stay valid
+QString EnhancedMosaicCreator::tileKey(const TileKey& key) const {
+    QString prefix = tilePrefix(key.survey);
+    if (key.order == 8 && prefix.isEmpty()) {
+        return QString("tile_pixel%1").arg(key.pixel);
+    }
+    return QString("%1tile_order%2_pixel%3").arg(prefix).arg(key.order).arg(key.pixel);
+}
+
+// Tiles stored before keys named their survey all came from the built-in
+// DSS2 colour survey, so that source keeps unprefixed keys. Any other
+// source, including DSS2_Color redefined by DSS_SURVEYS with another URL,
+// gets keys of its own instead of reusing those tiles.
+QString EnhancedMosaicCreator::tilePrefix(SurveyId survey) const {
+    const SurveyRegistry& surveys = m_hipsClient->surveys();
+    if (surveys.key(survey) == "DSS2_Color" && surveys.info(survey).baseUrl == kLegacyTileSource) {
+        return QString();
+    }
+    return surveys.cacheName(survey) + "_";
+}
+
+int EnhancedMosaicCreator::tileWidth() const {
+    return m_hipsClient->surveys().info(m_survey).tileWidth;
+}
+
+QString EnhancedMosaicCreator::tileUrl(const TileKey& key) const {
+    return m_hipsClient->surveys().tileUrl(key.survey, key.order, key.pixel);
+}
+
+// Move loose tile_*.jpg files from older versions into the content
+// store, then seed the coverage map from the local references
+void EnhancedMosaicCreator::scanTileStore() {
+    QString prefix = tilePrefix(m_survey);
+    QRegularExpression legacy("^tile_pixel(\\d+)$");
+    QRegularExpression ordered("^" + QRegularExpression::escape(prefix) + "tile_order(\\d+)_pixel(\\d+)$");
+    
+    QStringList loose = QDir(m_outputDir).entryList(QStringList() << "tile_*.jpg", QDir::Files);
+    int migrated = 0;
+    for (const QString& name : loose) {
+        QFile file(QDir(m_outputDir).filePath(name));
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        QByteArray data = file.readAll();
+        file.close();
+        if (!m_tileStore->put(QFileInfo(name).completeBaseName(), data).isEmpty()) {
+            file.remove();
+            migrated++;
         }
     }
+    if (migrated > 0) {
+        qDebug() << QString("Moved %1 tiles into the content-addressed store").arg(migrated);
+    }
+    
+    if (loadTileSnapshot()) return;
     
-    qDebug() << QString("Created %1 tile grid - will crop to center target precisely").arg(m_tiles.size());
+    QMutexLocker locker(&m_coverageMutex);
+    m_tileCoverage.clear();
+    QStringList names = m_tileStore->localKeys();
+    for (const QString& name : names) {
+        QRegularExpressionMatch match = ordered.match(name);
+        if (match.hasMatch()) {
+            if (match.captured(1).toInt() == 8) {
+                m_tileCoverage.addCell(8, match.captured(2).toULongLong());
+            }
+            continue;
+        }
+        match = legacy.match(name);
+        if (prefix.isEmpty() && match.hasMatch()) {
+            m_tileCoverage.addCell(8, match.captured(1).toULongLong());
+        }
+    }
+    qDebug() << QString("Tile store covers %1 deg² in %2 ranges")
+                .arg(m_tileCoverage.areaSqDeg(), 0, 'f', 2)
+                .arg(m_tileCoverage.ranges().size());
+}
+
+// Adding or replacing a reference or blank marker renames a file into
+// these directories, which moves their mtime
+// The coverage map is for m_survey only; a new source (and so a new cache
+// name) must not reuse a map built from another survey's tiles
+QByteArray EnhancedMosaicCreator::tileStoreStamp() const {
+    QString root = m_outputDir + "/tile_store/";
+    return m_hipsClient->surveys().cacheName(m_survey).toUtf8() + ";" +
+           Snapshot::fileStamp(root + "refs") + ";" + Snapshot::fileStamp(root + "blank");
+}
+
+bool EnhancedMosaicCreator::loadTileSnapshot() {
+    QByteArray stamp = tileStoreStamp();
+    Snapshot snapshot(m_outputDir + "/tile_store/index.snapshot", kTileSnapshotVersion, stamp);
+    if (!snapshot.isValid()) return false;
+    
+    Moc coverage;
+    if (!snapshot.readMoc("tiles.coverage", coverage) || !m_tileStore->loadIndex(snapshot, "tiles.")) {
+        return false;
+    }
+    QMutexLocker locker(&m_coverageMutex);
+    m_tileCoverage = coverage;
+    m_snapshotStamp = stamp;
+    qDebug() << QString("Tile store covers %1 deg² in %2 ranges (from snapshot)")
+                .arg(m_tileCoverage.areaSqDeg(), 0, 'f', 2)
+                .arg(m_tileCoverage.ranges().size());
+    return true;
+}
+
+void EnhancedMosaicCreator::saveTileSnapshot() {
+    m_tileStore->flushLocal();
+    QByteArray stamp = tileStoreStamp();
+    if (stamp == m_snapshotStamp) return;
+    
+    SnapshotWriter writer(kTileSnapshotVersion, stamp);
+    {
+        QMutexLocker locker(&m_coverageMutex);
+        writer.addMoc("tiles.coverage", m_tileCoverage);
+    }
+    m_tileStore->saveIndex(writer, "tiles.");
+    if (writer.write(m_outputDir + "/tile_store/index.snapshot")) {
+        m_snapshotStamp = stamp;
+    }
+}
+
+// Coverage counts mosaic-order tiles only; a stored parent stands in for
+// a missing child at lower resolution but does not make it local
+void EnhancedMosaicCreator::recordTile(const TileKey& key) {
+    if (key.order != 8) return;
+    QMutexLocker locker(&m_coverageMutex);
+    m_tileCoverage.addCell(key.order, key.pixel);
+}
+
+Moc EnhancedMosaicCreator::tileCoverage() const {
+    QMutexLocker locker(&m_coverageMutex);
+    return m_tileCoverage;
+}
+
+// The cells a mosaic of `target` reads: the centre tile and its neighbours
+Moc EnhancedMosaicCreator::mosaicRegion(const SkyPosition& target, int order) const {
+    Moc region;
+    long long centerPixel = m_hipsClient->calculateHealPixel(target, order);
+    if (centerPixel < 0) return region;
+    region.addCell(order, centerPixel);
+    for (long long pixel : m_hipsClient->getNeighboringPixels(centerPixel, order)) {
+        region.addCell(order, pixel);
+    }
+    return region;
+}
+
+bool EnhancedMosaicCreator::canRenderLocally(const SkyPosition& target) const {
+    Moc region = mosaicRegion(target, 8);
+    QMutexLocker locker(&m_coverageMutex);
+    return !region.isEmpty() && m_tileCoverage.contains(region);
+}
+
+Moc EnhancedMosaicCreator::missingCoverage(const SkyPosition& target) const {
+    Moc region = mosaicRegion(target, 8);
+    QMutexLocker locker(&m_coverageMutex);
+    return region.subtracted(m_tileCoverage);
+}
+
+RenderKey EnhancedMosaicCreator::mosaicKey(const SkyPosition& target) const {
+    const int order = 8;
+    RenderKey key("centered_mosaic");
+    key.add("version", kMosaicRenderVersion)
+       .add("ra", target.ra_deg)
+       .add("dec", target.dec_deg)
+       .add("label", target.name)
+       .add("survey", m_hipsClient->surveys().info(m_survey).baseUrl)
+       .add("order", order)
+       .add("crop", 1200);
+    
+    long long centerPixel = m_hipsClient->calculateHealPixel(target, order);
+    if (centerPixel < 0) {
+        key.invalidate();
+        return key;
+    }
+    TileGrid grid = m_hipsClient->createProper3x3Grid(centerPixel, order);
+    for (int y = 0; y < TileGrid::kSize; y++) {
+        for (int x = 0; x < TileGrid::kSize; x++) {
+            // A tile's version is its content hash
+            QString hash = m_tileStore->referenceOf(tileKey(grid.key(x, y, m_survey)));
+            if (hash.isEmpty()) key.invalidate();
+            key.add(QString("tile_%1_%2").arg(x).arg(y), hash);
+        }
+    }
+    return key;
+}
+
+Async::Future<QImage> EnhancedMosaicCreator::fetchTile(const TileKey& key) {
+    QImage cached = loadTile(key);
+    if (!cached.isNull()) {
+        recordTile(key);    // may have just been promoted from a shared tier
+        return Async::makeReady(cached);
+    }
+    
+    QNetworkRequest request(QUrl(tileUrl(key)));
+    request.setHeader(QNetworkRequest::UserAgentHeader, "EnhancedMosaicCreator/1.0");
+    request.setRawHeader("Accept", "image/*");
+    
+    Async::Promise<QImage> promise;
+    QNetworkReply* reply = m_networkManager->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, promise, key]() {
+        if (reply->error() == QNetworkReply::NoError) {
+            QByteArray imageData = reply->readAll();
+            QBuffer buffer(&imageData);
+            buffer.open(QIODevice::ReadOnly);
+            QImage image = BufferPool::instance().readImage(&buffer, QSize(tileWidth(), tileWidth()));
+            if (image.isNull()) {
+                promise.setError(QString("Tile %1: could not decode %2 bytes")
+                                 .arg(key.pixel).arg(imageData.size()));
+            } else {
+                QString hash = storeTile(key, imageData, image);
+                if (!hash.isEmpty()) {
+                    recordTile(key);
+                    image = classifyTile(hash, image);
+                }
+                promise.setValue(image);
+            }
+        } else {
+            promise.setError(QString("Tile %1: %2").arg(key.pixel).arg(reply->errorString()));
+        }
+        reply->deleteLater();
+    });
+    
+    QTimer::singleShot(15000, reply, &QNetworkReply::abort);
+    return promise.future();
+}
+
+Async::Future<QImage> EnhancedMosaicCreator::renderMosaic(const SkyPosition& target) {
+    // An unchanged repeat never reads its tiles
+    QImage cached = restoreRenderedMosaic(target);
+    if (!cached.isNull()) {
+        return Async::makeReady(cached);
+    }
+    
+    const int order = 8;
+    QList<SimpleTile> tiles = buildTileGrid(target, order);
+    prefetchTiles(tiles);
+    
+    // Missing tiles fall back to cached ancestors, as in the sequential path
+    QList<Async::Future<QImage>> fetches;
+    for (const SimpleTile& tile : tiles) {
+        fetches << fetchTile(tile.key).orElse(QImage());
+    }
+    
+    return Async::whenAll(fetches).then(this, [this, tiles, target](const QList<QImage>& images) {
+        QList<SimpleTile> loaded = tiles;
+        for (int i = 0; i < loaded.size(); ++i) {
+            setTileImage(loaded[i], images[i]);
+        }
+        
+        // Empty unless a tile failed with no cached parent
+        return Async::whenAll(fetchParents(loaded)).then(this, [this, loaded, target](const QList<QImage>&) {
+            QList<SimpleTile> filled = loaded;
+            fillFromAncestors(filled);
+            
+            QImage mosaic = composeCenteredMosaic(filled, target);
+            if (mosaic.isNull()) {
+                return Async::makeFailed<QImage>(QString("Failed to download tiles for %1").arg(target.name));
+            }
+            
+            // Same outputs as the sequential path; the PNG written is the
+            // one the render cache keeps, so it is encoded once
+            QString mosaicFilename = outputFile(target.name, "centered_mosaic.png");
+            if (mosaic.save(mosaicFilename)) {
+                m_renderCache->storeFile(mosaicKey(target), mosaicFilename);
+            } else {
+                m_renderCache->storeImage(mosaicKey(target), mosaic);
+            }
+            saveProgressReport(target.name, target, filled);
+            return Async::makeReady(mosaic);
+        });
+    });
 }
 
 void EnhancedMosaicCreator::processNextTile() {
     if (m_currentTileIndex >= m_tiles.size()) {
-        assembleFinalMosaicCentered();
+        // Failed tiles without a cached parent fetch it before the fallback
+        Async::whenAll(fetchParents(m_tiles)).then(this, [this](const QList<QImage>&) {
+            assembleFinalMosaicCentered();
+        });
         return;
     }
     
@@ -106,7 +434,7 @@ void EnhancedMosaicCreator::processNextTile() {
         qDebug() << QString("Reusing tile %1/%2: Grid(%3,%4) HEALPix %5")
                     .arg(m_currentTileIndex).arg(m_tiles.size())
                     .arg(tile.gridX).arg(tile.gridY)
-                    .arg(tile.healpixPixel);
+                    .arg(tile.key.pixel);
         m_currentTileIndex++;
         QTimer::singleShot(100, this, &EnhancedMosaicCreator::processNextTile);
         return;
@@ -123,9 +451,9 @@ void EnhancedMosaicCreator::downloadTile(int tileIndex) {
     qDebug() << QString("Downloading tile %1/%2: Grid(%3,%4) HEALPix %5")
                 .arg(tileIndex + 1).arg(m_tiles.size())
                 .arg(tile.gridX).arg(tile.gridY)
-                .arg(tile.healpixPixel);
+                .arg(tile.key.pixel);
     
-    QNetworkRequest request(QUrl(tile.url));
+    QNetworkRequest request(QUrl(tileUrl(tile.key)));
     request.setHeader(QNetworkRequest::UserAgentHeader, "EnhancedMosaicCreator/1.0");
     request.setRawHeader("Accept", "image/*");
     
@@ -152,11 +480,19 @@ void EnhancedMosaicCreator::onTileDownloaded() {
     
     if (reply->error() == QNetworkReply::NoError) {
         QByteArray imageData = reply->readAll();
-        tile.image.loadFromData(imageData);
+        QBuffer buffer(&imageData);
+        buffer.open(QIODevice::ReadOnly);
+        QImage image = BufferPool::instance().readImage(&buffer, QSize(tileWidth(), tileWidth()));
         
-        if (!tile.image.isNull()) {
-            bool saved = tile.image.save(tile.filename);
-            tile.downloaded = true;
+        if (!image.isNull()) {
+            QString hash = storeTile(tile.key, imageData, image);
+            bool saved = !hash.isEmpty();
+            if (saved) {
+                recordTile(tile.key);
+                image = classifyTile(hash, image);
+            }
+            setTileImage(tile, image);
+            m_tileCharge.add(tile.image.sizeInBytes());
             
             qint64 downloadTime = m_downloadStartTime.msecsTo(QDateTime::currentDateTime());
             qDebug() << QString("✅ Tile %1/%2 downloaded: %3ms, %4 bytes, %5x%6 pixels%7")
@@ -181,30 +517,108 @@ void EnhancedMosaicCreator::assembleFinalMosaicCentered() {
     
     qDebug() << QString("\n=== Assembling Coordinate-Centered %1 Mosaic ===").arg(targetName);
     
+    int fallbackTiles = fillFromAncestors(m_tiles);
     int successfulTiles = 0;
     for (const SimpleTile& tile : m_tiles) {
         if (tile.downloaded && !tile.image.isNull()) {
             successfulTiles++;
+            if (tile.sourceOrder > 0) m_tileCharge.add(tile.image.sizeInBytes());
         }
     }
     
-    if (successfulTiles == 0) {
+    QImage centeredMosaic = composeCenteredMosaic(m_tiles, m_actualTarget);
+    if (centeredMosaic.isNull()) {
         qDebug() << QString("Failed to download tiles for %1").arg(targetName);
         return;
     }
     
+    // Store the final centered mosaic
+    m_fullMosaic = centeredMosaic;
+    m_mosaicCharge.resize(m_fullMosaic.sizeInBytes());
+    
+    // Save final mosaic
+    QString mosaicFilename = outputFile(targetName, "centered_mosaic.png");
+    bool saved = centeredMosaic.save(mosaicFilename);
+    
+    qDebug() << QString("\n🎯 %1 COORDINATE-CENTERED MOSAIC COMPLETE!").arg(targetName);
+    qDebug() << QString("📁 Final size: %1×%2 pixels (%3 tiles used, %4 from lower orders)")
+                .arg(centeredMosaic.width()).arg(centeredMosaic.height())
+                .arg(successfulTiles).arg(fallbackTiles);
+    qDebug() << QString("📁 Saved to: %1 (%2)")
+                .arg(mosaicFilename).arg(saved ? "SUCCESS" : "FAILED");
+    if (saved) {
+        m_renderCache->storeFile(mosaicKey(m_actualTarget), mosaicFilename);
+    }
+    qDebug() << QString("✅ Target coordinates are now at exact center pixel (%1,%2)")
+                .arg(centeredMosaic.width() / 2).arg(centeredMosaic.height() / 2);
+    
+    saveProgressReport(targetName, m_actualTarget, m_tiles);
+    BufferPool::instance().printStats();
+    
+    // NEW: Emit completion signal
+    emit mosaicComplete(centeredMosaic);
+}
+
+// A repeat of an earlier render: restore the named PNG from the cached
+// copy instead of reassembling, then finish as a fresh render would
+bool EnhancedMosaicCreator::reuseRenderedMosaic(const SkyPosition& target) {
+    QImage cached = restoreRenderedMosaic(target);
+    if (cached.isNull()) return false;
+    
+    m_fullMosaic = cached;
+    m_mosaicCharge.resize(m_fullMosaic.sizeInBytes());
+    qDebug() << QString("♻️ %1 unchanged since last render, reused cached mosaic").arg(target.name);
+    
+    emit mosaicComplete(cached);
+    return true;
+}
+
+// The cached mosaic for target, copied to its named PNG; null if the
+// render cache has no valid copy
+QImage EnhancedMosaicCreator::restoreRenderedMosaic(const SkyPosition& target) {
+    QString cachedPath = m_renderCache->lookup(mosaicKey(target));
+    if (cachedPath.isEmpty()) return QImage();
+    
+    QImage cached(cachedPath);
+    if (cached.isNull()) return QImage();
+    
+    QString mosaicFilename = outputFile(target.name, "centered_mosaic.png");
+    QFile::remove(mosaicFilename);
+    bool saved = QFile::copy(cachedPath, mosaicFilename);
+    qDebug() << QString("📁 Saved to: %1 (%2)")
+                .arg(mosaicFilename).arg(saved ? "SUCCESS" : "FAILED");
+    return cached;
+}
+
+// Stateless assembly shared by the signal-driven and future-based paths;
+// returns a null image if no tile carries pixels
+QImage EnhancedMosaicCreator::composeCenteredMosaic(const QList<SimpleTile>& tiles,
+                                                    const SkyPosition& target) const {
+    bool anyTile = false;
+    for (const SimpleTile& tile : tiles) {
+        if (tile.downloaded && !tile.image.isNull()) {
+            anyTile = true;
+            break;
+        }
+    }
+    if (!anyTile) {
+        return QImage();
+    }
+    
     // Step 1: Create the raw 3x3 mosaic
-    int tileSize = 512;
-    int rawMosaicSize = 3 * tileSize; // 1536x1536
+    int tileSize = tileWidth();
+    int rawMosaicSize = 3 * tileSize; // 1536x1536 for 512-pixel tiles
     
-    QImage rawMosaic(rawMosaicSize, rawMosaicSize, QImage::Format_RGB32);
+    QImage rawMosaic = BufferPool::instance().createImage(rawMosaicSize, rawMosaicSize,
+                                                          QImage::Format_RGB32);
     rawMosaic.fill(Qt::black);
+    MemoryCharge canvasCharge(MemoryStage::MosaicAssembly, rawMosaic.sizeInBytes());
     
     QPainter rawPainter(&rawMosaic);
     
     qDebug() << QString("Step 1: Assembling raw 3x3 mosaic (%1x%1 pixels)").arg(rawMosaicSize);
     
-    for (const SimpleTile& tile : m_tiles) {
+    for (const SimpleTile& tile : tiles) {
         if (!tile.downloaded || tile.image.isNull()) {
             qDebug() << QString("  Skipping tile %1,%2 - not downloaded").arg(tile.gridX).arg(tile.gridY);
             continue;
@@ -213,7 +627,14 @@ void EnhancedMosaicCreator::assembleFinalMosaicCentered() {
         int pixelX = tile.gridX * tileSize;
         int pixelY = tile.gridY * tileSize;
         
-        rawPainter.drawImage(pixelX, pixelY, tile.image);
+        if (tile.blank) {
+            // Known-blank content: a constant fill, never decoded
+            if (tile.fill != qRgb(0, 0, 0)) {
+                rawPainter.fillRect(pixelX, pixelY, tileSize, tileSize, QColor(tile.fill));
+            }
+        } else {
+            rawPainter.drawImage(pixelX, pixelY, tile.image);
+        }
         
         qDebug() << QString("  ✅ Placed tile (%1,%2) at pixel (%3,%4)")
                     .arg(tile.gridX).arg(tile.gridY).arg(pixelX).arg(pixelY);
@@ -221,7 +642,7 @@ void EnhancedMosaicCreator::assembleFinalMosaicCentered() {
     rawPainter.end();
     
     // Step 2: Calculate where the target coordinates fall in the raw mosaic
-    QPoint targetPixel = calculateTargetPixelPosition();
+    QPoint targetPixel = calculateTargetPixelPosition(tiles, target);
     
     qDebug() << QString("Step 2: Target coordinates map to pixel (%1,%2) in raw mosaic")
                 .arg(targetPixel.x()).arg(targetPixel.y());
@@ -247,56 +668,49 @@ void EnhancedMosaicCreator::assembleFinalMosaicCentered() {
     painter.setPen(QPen(Qt::yellow, 1));
     painter.setFont(QFont("Arial", 14, QFont::Bold));
     
-    painter.drawText(centerX + 40, centerY - 20, targetName);
+    painter.drawText(centerX + 40, centerY - 20, target.name);
     
     painter.setFont(QFont("Arial", 10));
     QString coordText = QString("RA:%1° Dec:%2°")
-                       .arg(m_actualTarget.ra_deg, 0, 'f', 4)
-                       .arg(m_actualTarget.dec_deg, 0, 'f', 4);
+                       .arg(target.ra_deg, 0, 'f', 4)
+                       .arg(target.dec_deg, 0, 'f', 4);
     painter.drawText(centerX + 40, centerY - 5, coordText);
     
     painter.drawText(centerX + 40, centerY + 10, "COORDINATE CENTERED");
     
     painter.end();
     
-    // Store the final centered mosaic
-    m_fullMosaic = centeredMosaic;
-    
-    // Save final mosaic
-    QString safeName = targetName.toLower().replace(" ", "_").replace("(", "").replace(")", "");
-    QString mosaicFilename = QString("%1/%2_centered_mosaic.png").arg(m_outputDir).arg(safeName);
-    bool saved = centeredMosaic.save(mosaicFilename);
-    
-    qDebug() << QString("\n🎯 %1 COORDINATE-CENTERED MOSAIC COMPLETE!").arg(targetName);
-    qDebug() << QString("📁 Final size: %1×%2 pixels (%3 tiles used)")
-                .arg(centeredMosaic.width()).arg(centeredMosaic.height()).arg(successfulTiles);
-    qDebug() << QString("📁 Saved to: %1 (%2)")
-                .arg(mosaicFilename).arg(saved ? "SUCCESS" : "FAILED");
-    qDebug() << QString("✅ Target coordinates are now at exact center pixel (%1,%2)")
-                .arg(centerX).arg(centerY);
-    
-    saveProgressReport(targetName);
-    
-    // NEW: Emit completion signal
-    emit mosaicComplete(centeredMosaic);
+    return centeredMosaic;
 }
 
-QPoint EnhancedMosaicCreator::calculateTargetPixelPosition() {
+QPoint EnhancedMosaicCreator::calculateTargetPixelPosition(const QList<SimpleTile>& tiles,
+                                                           const SkyPosition& target) const {
     // Find the tile that contains our target
-    SimpleTile* containingTile = nullptr;
+    const SimpleTile* containingTile = nullptr;
     double minDistance = std::numeric_limits<double>::max();
     
-    for (SimpleTile& tile : m_tiles) {
-        double distance = calculateAngularDistance(m_actualTarget, tile.skyCoordinates);
-        if (distance < minDistance) {
-            minDistance = distance;
-            containingTile = &tile;
+    // Distances from the target to every tile center in one batch
+    const int count = tiles.size();
+    std::vector<float> x(count), y(count), z(count), distance(count);
+    for (int i = 0; i < count; i++) {
+        x[i] = float(tiles[i].skyCoordinates.x);
+        y[i] = float(tiles[i].skyCoordinates.y);
+        z[i] = float(tiles[i].skyCoordinates.z);
+    }
+    spherical::separationAndAngle(spherical::Rotation::tangentFrame(target.ra_deg, target.dec_deg),
+                                  x.data(), y.data(), z.data(), count, distance.data(), nullptr);
+    for (int i = 0; i < count; i++) {
+        if (distance[i] < minDistance) {
+            minDistance = distance[i];
+            containingTile = &tiles[i];
         }
     }
     
+    const int tileSize = tileWidth();
+    const int rawMosaicSize = 3 * tileSize;
     if (!containingTile) {
         qDebug() << "Warning: Could not find containing tile, using geometric center";
-        return QPoint(1536/2, 1536/2);
+        return QPoint(rawMosaicSize / 2, rawMosaicSize / 2);
     }
     
     qDebug() << QString("Target is in tile (%1,%2) with center at RA=%3°, Dec=%4°")
@@ -304,15 +718,21 @@ QPoint EnhancedMosaicCreator::calculateTargetPixelPosition() {
                 .arg(containingTile->skyCoordinates.ra_deg, 0, 'f', 6)
                 .arg(containingTile->skyCoordinates.dec_deg, 0, 'f', 6);
     
-    // Use definitive astrometry data
-    const double ARCSEC_PER_PIXEL = 1.61;
-    
-    // Calculate angular offsets from the nearest tile center
-    double offsetRA_arcsec = (m_actualTarget.ra_deg - containingTile->skyCoordinates.ra_deg) * 3600.0;
-    double offsetDec_arcsec = (m_actualTarget.dec_deg - containingTile->skyCoordinates.dec_deg) * 3600.0;
-    
-    // Apply cosine correction for RA at this declination
-    offsetRA_arcsec *= cos(m_actualTarget.dec_deg * M_PI / 180.0);
+    // HiPS pixel scale: a tile at order k spans sqrt(4π / (12·4^k)) radians
+    // across its tileWidth pixels (1.61"/pixel for 512-pixel order 8 tiles)
+    const double tileArcsec = std::sqrt(4.0 * M_PI / (12.0 * std::pow(4.0, containingTile->key.order)))
+                              * 180.0 / M_PI * 3600.0;
+    const double ARCSEC_PER_PIXEL = tileArcsec / tileSize;
+    
+    // Angular offsets from the nearest tile center: the target's standard
+    // coordinates in the tile's tangent plane, which unlike RA differences
+    // stay correct across RA 0/360 and near the poles
+    spherical::Vec3 offset = spherical::Rotation::tangentFrame(containingTile->skyCoordinates.ra_deg,
+                                                               containingTile->skyCoordinates.dec_deg)
+                             .apply(spherical::fromRaDec(target.ra_deg, target.dec_deg));
+    const double ARCSEC_PER_RADIAN = 180.0 / M_PI * 3600.0;
+    double offsetRA_arcsec = offset.x / offset.z * ARCSEC_PER_RADIAN;
+    double offsetDec_arcsec = offset.y / offset.z * ARCSEC_PER_RADIAN;
     
     qDebug() << QString("Angular offset from tile center: RA=%1\", Dec=%2\"")
                 .arg(offsetRA_arcsec, 0, 'f', 2)
@@ -326,16 +746,16 @@ QPoint EnhancedMosaicCreator::calculateTargetPixelPosition() {
                 .arg(offsetRA_pixels, 0, 'f', 1)
                 .arg(offsetDec_pixels, 0, 'f', 1);
     
-    // Calculate absolute pixel position in the 1536x1536 raw mosaic
-    int tilePixelX = containingTile->gridX * 512 + 256; // Tile center X
-    int tilePixelY = containingTile->gridY * 512 + 256; // Tile center Y
+    // Calculate absolute pixel position in the raw mosaic
+    int tilePixelX = containingTile->gridX * tileSize + tileSize / 2; // Tile center X
+    int tilePixelY = containingTile->gridY * tileSize + tileSize / 2; // Tile center Y
     
     int targetPixelX = tilePixelX + static_cast<int>(round(offsetRA_pixels));
     int targetPixelY = tilePixelY + static_cast<int>(round(offsetDec_pixels));
     
     // Clamp to mosaic bounds
-    targetPixelX = std::max(0, std::min(targetPixelX, 1535));
-    targetPixelY = std::max(0, std::min(targetPixelY, 1535));
+    targetPixelX = std::max(0, std::min(targetPixelX, rawMosaicSize - 1));
+    targetPixelY = std::max(0, std::min(targetPixelY, rawMosaicSize - 1));
     
     qDebug() << QString("Target pixel in raw mosaic: (%1,%2)")
                 .arg(targetPixelX).arg(targetPixelY);
@@ -343,7 +763,7 @@ QPoint EnhancedMosaicCreator::calculateTargetPixelPosition() {
     return QPoint(targetPixelX, targetPixelY);
 }
 
-QImage EnhancedMosaicCreator::cropMosaicToCenter(const QImage& rawMosaic, const QPoint& targetPixel) {
+QImage EnhancedMosaicCreator::cropMosaicToCenter(const QImage& rawMosaic, const QPoint& targetPixel) const {
     // Determine crop size - aim for ~1200x1200 final mosaic
     int cropSize = 1200;
     
@@ -379,84 +799,195 @@ QImage EnhancedMosaicCreator::cropMosaicToCenter(const QImage& rawMosaic, const
     qDebug() << QString("Crop rectangle: (%1,%2) %3x%4")
                 .arg(cropX).arg(cropY).arg(cropSize).arg(cropSize);
     
-    return rawMosaic.copy(cropRect);
+    // Copy scanlines into a pooled image instead of QImage::copy()
+    QImage cropped = BufferPool::instance().createImage(cropRect.width(), cropRect.height(),
+                                                        rawMosaic.format());
+    const int bytesPerPixel = rawMosaic.depth() / 8;
+    for (int y = 0; y < cropRect.height(); ++y) {
+        memcpy(cropped.scanLine(y),
+               rawMosaic.constScanLine(cropRect.y() + y) + cropRect.x() * bytesPerPixel,
+               size_t(cropRect.width()) * bytesPerPixel);
+    }
+    
+    return cropped;
 }
 
-SkyPosition EnhancedMosaicCreator::healpixToSkyPosition(long long pixel, int order) const {
+SkyCoord EnhancedMosaicCreator::healpixToSkyCoord(long long pixel, int order) const {
     try {
         long long nside = 1LL << order;
         Healpix_Base healpix(nside, NEST, SET_NSIDE);
-        
-        pointing pt = healpix.pix2ang(pixel);
-        
-        SkyPosition pos;
-        pos.ra_deg = pt.phi * 180.0 / M_PI;
-        pos.dec_deg = 90.0 - pt.theta * 180.0 / M_PI;
-        pos.name = QString("HEALPix_%1").arg(pixel);
-        pos.description = QString("Order %1 pixel %2").arg(order).arg(pixel);
-        
-        return pos;
+        return SkyCoord::fromPointing(healpix.pix2ang(pixel));
     } catch (...) {
         // Fallback
-        SkyPosition pos;
-        pos.ra_deg = 0.0;
-        pos.dec_deg = 0.0;
-        pos.name = "Error";
-        pos.description = "HEALPix conversion failed";
-        return pos;
+        return SkyCoord::fromRaDec(0.0, 0.0);
     }
 }
 
-double EnhancedMosaicCreator::calculateAngularDistance(const SkyPosition& pos1, const SkyPosition& pos2) const {
-    // Convert to radians
-    double ra1 = pos1.ra_deg * M_PI / 180.0;
-    double dec1 = pos1.dec_deg * M_PI / 180.0;
-    double ra2 = pos2.ra_deg * M_PI / 180.0;
-    double dec2 = pos2.dec_deg * M_PI / 180.0;
-    
-    // Haversine formula for angular distance
-    double dra = ra2 - ra1;
-    double ddec = dec2 - dec1;
-    
-    double a = sin(ddec/2) * sin(ddec/2) + 
-               cos(dec1) * cos(dec2) * sin(dra/2) * sin(dra/2);
-    double c = 2 * atan2(sqrt(a), sqrt(1-a));
-    
-    return c; // Return in radians
+double EnhancedMosaicCreator::calculateAngularDistance(const SkyCoord& pos1, const SkyCoord& pos2) const {
+    return pos1.distanceTo(pos2); // Return in radians
 }
 
 bool EnhancedMosaicCreator::checkExistingTile(const SimpleTile& tile) {
-    QFileInfo fileInfo(tile.filename);
-    if (!fileInfo.exists() || fileInfo.size() < 1024) return false;
-    
-    if (!isValidJpeg(tile.filename)) return false;
+    QImage image = loadTile(tile.key);
+    if (image.isNull()) return false;
+    recordTile(tile.key);
     
     SimpleTile* mutableTile = const_cast<SimpleTile*>(&tile);
-    mutableTile->image.load(tile.filename);
-    
-    if (mutableTile->image.isNull()) return false;
-    
-    mutableTile->downloaded = true;
+    setTileImage(*mutableTile, image);
+    m_tileCharge.add(image.sizeInBytes());
     return true;
 }
 
-bool EnhancedMosaicCreator::isValidJpeg(const QString& filename) {
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly)) return false;
+void EnhancedMosaicCreator::setTileImage(SimpleTile& tile, const QImage& image) {
+    tile.image = image;
+    tile.downloaded = !image.isNull();
+    tile.blank = blankFill(image, &tile.fill);
+}
+
+// HiPS is hierarchical: pixel p at order k is one quarter of pixel p>>2 at
+// order k-1. Cut the matching square from the nearest cached ancestor and
+// upsample it, so a failed tile costs resolution instead of a hole.
+QImage EnhancedMosaicCreator::ancestorTile(const TileKey& key, int* sourceOrder) const {
+    if (!key.isValid()) return QImage();
+    
+    for (int level = 1; level <= kMaxFallbackLevels && level <= key.order; level++) {
+        TileKey parent{key.pixel >> (2 * level), key.survey, quint8(key.order - level)};
+        QImage ancestor = loadTile(parent);
+        if (ancestor.isNull()) continue;
+        if (sourceOrder) *sourceOrder = parent.order;
+        return cutFromAncestor(ancestor, key.pixel, level, tileWidth());
+    }
+    return QImage();
+}
+
+QImage EnhancedMosaicCreator::cutFromAncestor(const QImage& ancestor, long long pixel, int levels, int width) {
+    if (ancestor.isNull() || blankFill(ancestor, nullptr)) return ancestor;  // Children of a blank tile are blank
+    
+    // Nested digits from coarse to fine: bit 1 picks the column half,
+    // bit 0 the row half counted from the top
+    int column = 0, row = 0;
+    for (int digit = levels - 1; digit >= 0; digit--) {
+        int child = int((pixel >> (2 * digit)) & 3);
+        column = column * 2 + ((child >> 1) & 1);
+        row = row * 2 + (1 - (child & 1));
+    }
+    int cutWidth = ancestor.width() >> levels;
+    int cutHeight = ancestor.height() >> levels;
+    return ancestor.copy(column * cutWidth, row * cutHeight, cutWidth, cutHeight)
+                   .scaled(width, width, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+// Returns the number of tiles filled; they are logged as lower resolution
+int EnhancedMosaicCreator::fillFromAncestors(QList<SimpleTile>& tiles) {
+    int filled = 0;
+    for (SimpleTile& tile : tiles) {
+        if (tile.downloaded && !tile.image.isNull()) continue;
+        
+        int sourceOrder = 0;
+        QImage image = ancestorTile(tile.key, &sourceOrder);
+        if (image.isNull()) continue;
+        
+        setTileImage(tile, image);
+        tile.sourceOrder = sourceOrder;
+        filled++;
+        qDebug() << QString("  🔶 Tile (%1,%2) HEALPix %3 filled from order %4 (%5x lower resolution)")
+                    .arg(tile.gridX).arg(tile.gridY).arg(tile.key.pixel)
+                    .arg(sourceOrder).arg(1 << (tile.key.order - sourceOrder));
+    }
+    return filled;
+}
+
+// Blank tiles travel as a 1x1 image of their colour tagged "blank"
+QImage EnhancedMosaicCreator::blankTile(QRgb fill) {
+    QImage image(1, 1, QImage::Format_RGB32);
+    image.setPixel(0, 0, fill);
+    image.setText("blank", "1");
+    return image;
+}
+
+bool EnhancedMosaicCreator::blankFill(const QImage& image, QRgb* fill) {
+    if (image.width() != 1 || image.height() != 1 || image.text("blank") != "1") return false;
+    if (fill) *fill = image.pixel(0, 0);
+    return true;
+}
+
+// First decode of a hash decides whether it is a uniform tile; the
+// answer is stored with the blob so later loads skip the decode
+QImage EnhancedMosaicCreator::classifyTile(const QString& hash, const QImage& image) const {
+    QImage rgb = image.convertToFormat(QImage::Format_RGB32);
+    const QRgb first = reinterpret_cast<const QRgb*>(rgb.constScanLine(0))[0];
+    for (int y = 0; y < rgb.height(); ++y) {
+        const QRgb* row = reinterpret_cast<const QRgb*>(rgb.constScanLine(y));
+        for (int x = 0; x < rgb.width(); ++x) {
+            if (row[x] != first) {
+                m_tileStore->markNotBlank(hash);
+                return image;
+            }
+        }
+    }
+    m_tileStore->markBlank(hash, first);
+    return blankTile(first);
+}
+
+// Read through the tile store: RAM, then the local tile directory, then
+// any shared tier (a shared hit is copied into the local directory)
+QImage EnhancedMosaicCreator::loadTile(const TileKey& key) const {
+    QString hash = m_tileStore->referenceOf(tileKey(key));
+    if (hash.isEmpty()) return QImage();
     
-    QByteArray header = file.read(4);
-    file.close();
+    QRgb fill;
+    if (m_tileStore->isBlank(hash, &fill)) return blankTile(fill);
+    
+    // Hot tiles come straight from the mapped slab, no decode
+    QImage hot = m_pixelSlab->lookup(hash);
+    if (!hot.isNull()) return hot;
+    
+    QByteArray data = m_tileStore->blob(hash);
+    if (data.size() < 1024) return QImage();
+    
+    if (!isValidJpeg(data)) return QImage();
     
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QImage image = BufferPool::instance().readImage(&buffer, QSize(tileWidth(), tileWidth()));
+    if (image.isNull()) return image;
+    
+    image = classifyTile(hash, image);
+    if (!blankFill(image, nullptr)) m_pixelSlab->noteDecode(hash, image);
+    return image;
+}
+
+// Keep the downloaded JPEG as-is (once per distinct content) and write it
+// back to shared tiers; anything else is re-encoded so the store only
+// holds JPEGs. Returns the content hash, empty on failure.
+QString EnhancedMosaicCreator::storeTile(const TileKey& key, const QByteArray& downloaded,
+                                      const QImage& image) {
+    QByteArray jpegData = downloaded;
+    if (!isValidJpeg(jpegData)) {
+        jpegData.clear();
+        QBuffer buffer(&jpegData);
+        buffer.open(QIODevice::WriteOnly);
+        if (!image.save(&buffer, "JPEG")) return QString();
+    }
+    return m_tileStore->put(tileKey(key), jpegData);
+}
+
+bool EnhancedMosaicCreator::isValidJpeg(const QByteArray& header) const {
     return (header.size() >= 3 && 
             static_cast<unsigned char>(header[0]) == 0xFF && 
             static_cast<unsigned char>(header[1]) == 0xD8 && 
             static_cast<unsigned char>(header[2]) == 0xFF);
 }
 
-void EnhancedMosaicCreator::saveProgressReport(const QString& targetName) {
+// <output dir>/<target name, lower case, spaces to _>_<suffix>
+QString EnhancedMosaicCreator::outputFile(const QString& targetName, const QString& suffix) const {
     QString safeName = targetName.toLower().replace(" ", "_").replace("(", "").replace(")", "");
-    QString reportFile = QString("%1/%2_centered_report.txt").arg(m_outputDir).arg(safeName);
-    QFile file(reportFile);
+    return QString("%1/%2_%3").arg(m_outputDir, safeName, suffix);
+}
+
+void EnhancedMosaicCreator::saveProgressReport(const QString& targetName, const SkyPosition& target,
+                                               const QList<SimpleTile>& tiles) const {
+    QFile file(outputFile(targetName, "centered_report.txt"));
     
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return;
     
@@ -466,24 +997,33 @@ void EnhancedMosaicCreator::saveProgressReport(const QString& targetName) {
     
     out << "COORDINATE CENTERING ENHANCEMENT:\n";
     out << QString("Target coordinates: RA %1°, Dec %2°\n")
-           .arg(m_actualTarget.ra_deg, 0, 'f', 6)
-           .arg(m_actualTarget.dec_deg, 0, 'f', 6);
+           .arg(target.ra_deg, 0, 'f', 6)
+           .arg(target.dec_deg, 0, 'f', 6);
     out << "Enhancement: Target coordinates placed at exact mosaic center\n\n";
     
-    out << QString("Custom Target: %1\n").arg(m_customTarget.name);
+    out << QString("Custom Target: %1\n").arg(targetName);
     
     out << "\n3x3 Tile Grid Used:\n";
-    out << "Grid_X,Grid_Y,HEALPix_Pixel,Tile_RA,Tile_Dec,Downloaded,ImageSize,Filename\n";
+    out << "Grid_X,Grid_Y,HEALPix_Pixel,Tile_RA,Tile_Dec,Downloaded,ImageSize,Store_Key,Source_Order\n";
     
-    for (const SimpleTile& tile : m_tiles) {
-        out << QString("%1,%2,%3,%4,%5,%6,%7x%8,%9\n")
+    for (const SimpleTile& tile : tiles) {
+        out << QString("%1,%2,%3,%4,%5,%6,%7x%8,%9,%10\n")
                .arg(tile.gridX).arg(tile.gridY)
-               .arg(tile.healpixPixel)
+               .arg(tile.key.pixel)
                .arg(tile.skyCoordinates.ra_deg, 0, 'f', 6)
                .arg(tile.skyCoordinates.dec_deg, 0, 'f', 6)
-               .arg(tile.downloaded ? "YES" : "NO")
+               .arg(tile.sourceOrder > 0 ? "FILLED" : (tile.downloaded ? "YES" : "NO"))
                .arg(tile.image.width()).arg(tile.image.height())
-               .arg(tile.filename);
+               .arg(tileKey(tile.key))
+               .arg(tile.sourceOrder > 0 ? tile.sourceOrder : tile.key.order);
+    }
+    
+    // Regions drawn from upsampled ancestor tiles
+    for (const SimpleTile& tile : tiles) {
+        if (tile.sourceOrder > 0) {
+            out << QString("Lower resolution: grid (%1,%2) from order %3\n")
+                   .arg(tile.gridX).arg(tile.gridY).arg(tile.sourceOrder);
+        }
     }
     
     file.close();
@@ -30,9 +30,24 @@
 #include <QScrollArea>
 #include <QSplitter>
 #include <QTextStream>
+#include <QBuffer>
+#include <QMutex>
+#include <QSet>
 #include <cmath>
+#include <cstring>
 #include <limits>
+#include <memory>
+#include <vector>
 #include "ProperHipsClient.h"
+#include "BufferPool.h"
+#include "MemoryBudget.h"
+#include "Async.h"
+#include "Moc.h"
+#include "RenderCache.h"
+#include "ContentStore.h"
+#include "PixelSlab.h"
+#include "Snapshot.h"
+#include "matcher/SphericalGeometry.h"
 
 // Coordinate parser (same as original)
 struct SimpleCoordinateParser {
@@ -117,11 +132,39 @@ class EnhancedMosaicCreator : public QObject {  // CHANGED: Inherit from QObject
 
 public:
     explicit EnhancedMosaicCreator(QObject *parent = nullptr);  // CHANGED: Constructor signature
+    ~EnhancedMosaicCreator();
 
     // NEW: Public interface for external control
     void setCustomCoordinates(const QString& raText, const QString& decText, const QString& name);
     void createCustomMosaic(const SkyPosition& target);
     QImage getLastGeneratedMosaic() const { return m_fullMosaic; }
+    
+    // Future-returning API: no shared per-call state, safe to run concurrently.
+    // A uniform tile comes back as a 1x1 placeholder; check blankFill()
+    // before using its size or cropping it. renderMosaic writes the same
+    // PNG and report as createCustomMosaic.
+    Async::Future<QImage> fetchTile(const TileKey& key);
+    Async::Future<QImage> renderMosaic(const SkyPosition& target);
+    
+    // Coverage of the local tile store, kept current as tiles are saved
+    Moc tileCoverage() const;
+    bool canRenderLocally(const SkyPosition& target) const;
+    Moc missingCoverage(const SkyPosition& target) const;
+    
+    // Everything a centred mosaic of `target` depends on, including the
+    // version of each tile file; invalid while any tile is missing
+    RenderKey mosaicKey(const SkyPosition& target) const;
+    
+    // Content-addressed tiles behind RAM / local directory / shared tiers
+    const ContentStore& tileStore() const { return *m_tileStore; }
+    const PixelSlab& pixelSlab() const { return *m_pixelSlab; }
+    
+    // True for a blank-tile placeholder, with its colour in `fill`
+    static bool blankFill(const QImage& image, QRgb* fill);
+    
+    // The part of `ancestor`, `levels` orders above nested `pixel`, that
+    // covers the pixel, upsampled to `width`; blank ancestors pass through
+    static QImage cutFromAncestor(const QImage& ancestor, long long pixel, int levels, int width);
 
 signals:
     void mosaicComplete(const QImage& mosaic);  // NEW: Signal for completion
@@ -132,6 +175,7 @@ private slots:
 
 private:
     ProperHipsClient* m_hipsClient;
+    SurveyId m_survey;          // Tile source in m_hipsClient->surveys()
     QNetworkAccessManager* m_networkManager;
     
     // Target tracking
@@ -142,32 +186,91 @@ private:
     // Tile structure
     struct SimpleTile {
         int gridX, gridY;
-        long long healpixPixel;
-        QString filename;
-        QString url;
+        TileKey key;                // Survey, order and HEALPix pixel
         QImage image;
         bool downloaded;
-        SkyPosition skyCoordinates;
+        bool blank = false;     // Uniform tile: fill with `fill`, no pixels
+        QRgb fill = 0;
+        int sourceOrder = 0;        // Ancestor order the pixels were cut from, 0 if native
+        SkyCoord skyCoordinates;    // Tile center
     };
     
+    // Base URL of the survey all unprefixed tile store keys came from
+    static constexpr const char* kLegacyTileSource = "http://alasky.u-strasbg.fr/DSS/DSSColor";
+    
+    // Missing tiles are cut from a cached parent or grandparent; a parent
+    // is fetched only after its child fails and neither is cached
+    static constexpr int kMaxFallbackLevels = 2;
+    
     QList<SimpleTile> m_tiles;
     int m_currentTileIndex;
     QString m_outputDir;
     QDateTime m_downloadStartTime;
     
+    // Memory accounting for decoded tiles and the retained mosaic
+    MemoryCharge m_tileCharge{MemoryStage::TileDecode};
+    MemoryCharge m_mosaicCharge{MemoryStage::MosaicAssembly};
+    
+    // Tiles by content hash under m_outputDir/tile_store, keyed by
+    // tileKey() (tile_pixel<N> for the built-in survey); blank hashes skip
+    // decoding
+    std::unique_ptr<ContentStore> m_tileStore;
+    
+    // Decoded pixels of frequently loaded tiles, mapped from disk
+    std::unique_ptr<PixelSlab> m_pixelSlab;
+    
+    // Tiles present in m_outputDir
+    Moc m_tileCoverage;
+    mutable QMutex m_coverageMutex;
+    
+    // Coverage and tile references saved on exit and every few minutes,
+    // so the next start skips the tile store scan
+    static constexpr quint32 kTileSnapshotVersion = 1;
+    QByteArray m_snapshotStamp;
+    QTimer* m_snapshotTimer;
+    
+    // Finished mosaics by mosaicKey(); bump the version when composition changes
+    static constexpr int kMosaicRenderVersion = 2;
+    std::unique_ptr<RenderCache> m_renderCache;
+    
     // Core algorithms
     void createTileGrid(const SkyPosition& position);
+    void prefetchTiles(const QList<SimpleTile>& tiles);
+    QList<Async::Future<QImage>> fetchParents(const QList<SimpleTile>& tiles);
+    QList<SimpleTile> buildTileGrid(const SkyPosition& position, int order) const;
     void downloadTile(int tileIndex);
     
     // Enhanced mosaic assembly
     void assembleFinalMosaicCentered();
-    QPoint calculateTargetPixelPosition();
-    QImage cropMosaicToCenter(const QImage& rawMosaic, const QPoint& targetPixel);
+    bool reuseRenderedMosaic(const SkyPosition& target);
+    QImage restoreRenderedMosaic(const SkyPosition& target);
+    QImage composeCenteredMosaic(const QList<SimpleTile>& tiles, const SkyPosition& target) const;
+    QPoint calculateTargetPixelPosition(const QList<SimpleTile>& tiles, const SkyPosition& target) const;
+    QImage cropMosaicToCenter(const QImage& rawMosaic, const QPoint& targetPixel) const;
     
     // Helper functions
-    void saveProgressReport(const QString& targetName);
+    QString outputFile(const QString& targetName, const QString& suffix) const;
+    void saveProgressReport(const QString& targetName, const SkyPosition& target,
+                            const QList<SimpleTile>& tiles) const;
+    void scanTileStore();
+    QByteArray tileStoreStamp() const;
+    bool loadTileSnapshot();
+    void saveTileSnapshot();
+    void recordTile(const TileKey& key);
+    Moc mosaicRegion(const SkyPosition& target, int order) const;
+    QString tileKey(const TileKey& key) const;
+    QString tilePrefix(SurveyId survey) const;
+    int tileWidth() const;
+    QString tileUrl(const TileKey& key) const;
+    QImage loadTile(const TileKey& key) const;
+    QString storeTile(const TileKey& key, const QByteArray& downloaded, const QImage& image);
+    QImage classifyTile(const QString& hash, const QImage& image) const;
+    void setTileImage(SimpleTile& tile, const QImage& image);
+    QImage ancestorTile(const TileKey& key, int* sourceOrder) const;
+    int fillFromAncestors(QList<SimpleTile>& tiles);
+    static QImage blankTile(QRgb fill);
     bool checkExistingTile(const SimpleTile& tile);
-    bool isValidJpeg(const QString& filename);
-    SkyPosition healpixToSkyPosition(long long pixel, int order) const;
-    double calculateAngularDistance(const SkyPosition& pos1, const SkyPosition& pos2) const;
+    bool isValidJpeg(const QByteArray& header) const;
+    SkyCoord healpixToSkyCoord(long long pixel, int order) const;
+    double calculateAngularDistance(const SkyCoord& pos1, const SkyCoord& pos2) const;
 };
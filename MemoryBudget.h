@@ -0,0 +1,253 @@
+// MemoryBudget.h - Per-stage memory accounting and a global admission budget
+// Large buffer owners (tile decode, mosaic assembly, FITS pipeline stages,
+// matcher frames, batch jobs) report their bytes here. A process-wide budget
+// lets callers throttle new work or fall back to streaming code paths before
+// the worker runs out of memory.
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <atomic>
+#include <cstdlib>
+
+enum class MemoryStage {
+    TileDecode,         // Decoded HiPS tiles held for assembly
+    MosaicAssembly,     // Raw canvas, centre crop and the last mosaic
+    ImageCacheIndex,    // In-memory ImageCache metadata
+    FitsDecode,         // Float pixel buffers read from FITS
+    FitsProcessing,     // Temporary copies inside FitsProcessor stages
+    MatcherFrames,      // User/library frames held by ImageMatcherDialog
+    BatchJobs,          // Reservations for in-flight batch targets
+    PoolIdle,           // Buffers parked in BufferPool free lists
+    PyramidExport,      // Deep Zoom levels being tiled and downsampled
+    CacheRam,           // RAM tier of TieredCache (tiles, cutouts)
+    StageCount
+};
+
+class MemoryAccounting {
+public:
+    static MemoryAccounting& instance() {
+        static MemoryAccounting accounting;
+        return accounting;
+    }
+
+    static QString stageName(MemoryStage stage) {
+        switch (stage) {
+            case MemoryStage::TileDecode:      return "tile_decode";
+            case MemoryStage::MosaicAssembly:  return "mosaic_assembly";
+            case MemoryStage::ImageCacheIndex: return "image_cache_index";
+            case MemoryStage::FitsDecode:      return "fits_decode";
+            case MemoryStage::FitsProcessing:  return "fits_processing";
+            case MemoryStage::MatcherFrames:   return "matcher_frames";
+            case MemoryStage::BatchJobs:       return "batch_jobs";
+            case MemoryStage::PoolIdle:        return "pool_idle";
+            case MemoryStage::PyramidExport:   return "pyramid_export";
+            case MemoryStage::CacheRam:        return "cache_ram";
+            default:                           return "unknown";
+        }
+    }
+
+    void charge(MemoryStage stage, qint64 bytes) {
+        if (bytes == 0) return;
+        int i = static_cast<int>(stage);
+        qint64 now = m_current[i].fetch_add(bytes) + bytes;
+        updatePeak(m_peak[i], now);
+
+        qint64 total = m_total.fetch_add(bytes) + bytes;
+        updatePeak(m_totalPeak, total);
+
+        if (bytes < 0) {
+            QMutexLocker locker(&m_waitMutex);
+            m_released.wakeAll();
+        }
+    }
+
+    void discharge(MemoryStage stage, qint64 bytes) {
+        charge(stage, -bytes);
+    }
+
+    qint64 currentBytes(MemoryStage stage) const {
+        return m_current[static_cast<int>(stage)].load();
+    }
+
+    qint64 peakBytes(MemoryStage stage) const {
+        return m_peak[static_cast<int>(stage)].load();
+    }
+
+    qint64 totalBytes() const { return m_total.load(); }
+    qint64 totalPeakBytes() const { return m_totalPeak.load(); }
+
+    // Bytes held by work; buffers parked in the pool can be reclaimed and
+    // do not count against admission
+    qint64 committedBytes() const {
+        return m_total.load() - m_current[static_cast<int>(MemoryStage::PoolIdle)].load();
+    }
+
+    // Called when admitted work would push the real total over budget;
+    // BufferPool registers its trim() here
+    void setReclaimer(void (*reclaim)()) { m_reclaim.store(reclaim); }
+
+    // Global budget in bytes; 0 disables enforcement
+    void setBudget(qint64 bytes) { m_budget.store(bytes); }
+    qint64 budget() const { return m_budget.load(); }
+
+    // Fraction of the budget above which callers should prefer streaming paths
+    void setStreamingThreshold(double fraction) { m_streamingThreshold = fraction; }
+
+    // True if `bytes` more would still fit inside the budget
+    bool canAdmit(qint64 bytes) const {
+        qint64 limit = m_budget.load();
+        return limit <= 0 || committedBytes() + bytes <= limit;
+    }
+
+    // Reserve `bytes` under `stage` if they fit; caller discharges when done
+    bool tryAdmit(MemoryStage stage, qint64 bytes) {
+        if (!canAdmit(bytes)) return false;
+        reclaimIdle(bytes);
+        charge(stage, bytes);
+        return true;
+    }
+
+    // Block until `bytes` fit (or the timeout expires), then reserve them
+    bool waitForAdmission(MemoryStage stage, qint64 bytes, int timeoutMs = -1) {
+        QDeadlineTimer deadline = timeoutMs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever)
+                                                : QDeadlineTimer(timeoutMs);
+        {
+            QMutexLocker locker(&m_waitMutex);
+            while (!canAdmit(bytes)) {
+                if (!m_released.wait(&m_waitMutex, deadline)) {
+                    return false;
+                }
+            }
+        }
+        reclaimIdle(bytes);
+        charge(stage, bytes);
+        return true;
+    }
+
+    // True if allocating `bytes` more would push usage past the streaming threshold
+    bool shouldStream(qint64 bytes) const {
+        qint64 limit = m_budget.load();
+        if (limit <= 0) return false;
+        return committedBytes() + bytes > qint64(limit * m_streamingThreshold);
+    }
+
+    QStringList reportLines() const {
+        QStringList lines;
+        lines << QString("%1 %2 %3").arg("Stage", -20).arg("Current MB", 12).arg("Peak MB", 12);
+        for (int i = 0; i < kStages; ++i) {
+            lines << QString("%1 %2 %3")
+                     .arg(stageName(static_cast<MemoryStage>(i)), -20)
+                     .arg(m_current[i].load() / (1024.0 * 1024.0), 12, 'f', 1)
+                     .arg(m_peak[i].load() / (1024.0 * 1024.0), 12, 'f', 1);
+        }
+        lines << QString("%1 %2 %3")
+                 .arg("TOTAL", -20)
+                 .arg(m_total.load() / (1024.0 * 1024.0), 12, 'f', 1)
+                 .arg(m_totalPeak.load() / (1024.0 * 1024.0), 12, 'f', 1);
+        if (m_budget.load() > 0) {
+            lines << QString("Budget: %1 MB").arg(m_budget.load() / (1024.0 * 1024.0), 0, 'f', 0);
+        }
+        return lines;
+    }
+
+    void printReport() const {
+        qDebug() << "=== Memory Accounting ===";
+        for (const QString& line : reportLines()) {
+            qDebug().noquote() << line;
+        }
+    }
+
+private:
+    static constexpr int kStages = static_cast<int>(MemoryStage::StageCount);
+
+    std::atomic<qint64> m_current[kStages] = {};
+    std::atomic<qint64> m_peak[kStages] = {};
+    std::atomic<qint64> m_total{0};
+    std::atomic<qint64> m_totalPeak{0};
+    std::atomic<qint64> m_budget{0};
+    double m_streamingThreshold = 0.75;
+    std::atomic<void (*)()> m_reclaim{nullptr};
+
+    QMutex m_waitMutex;
+    QWaitCondition m_released;
+
+    MemoryAccounting() {
+        // Workers set DSS_MEMORY_BUDGET_MB to cap the whole process
+        const char* env = std::getenv("DSS_MEMORY_BUDGET_MB");
+        if (env) {
+            m_budget.store(qint64(std::atoll(env)) * 1024 * 1024);
+        }
+    }
+
+    // Free parked pool buffers if they alone would push the total over budget
+    void reclaimIdle(qint64 bytes) {
+        qint64 limit = m_budget.load();
+        void (*reclaim)() = m_reclaim.load();
+        if (limit > 0 && reclaim && m_total.load() + bytes > limit) reclaim();
+    }
+
+    static void updatePeak(std::atomic<qint64>& peak, qint64 value) {
+        qint64 seen = peak.load();
+        while (value > seen && !peak.compare_exchange_weak(seen, value)) {
+        }
+    }
+};
+
+// RAII handle for bytes owned by one stage; resize() tracks a growing or
+// shrinking owner, and destruction (or reset) returns the bytes.
+class MemoryCharge {
+public:
+    explicit MemoryCharge(MemoryStage stage = MemoryStage::FitsProcessing, qint64 bytes = 0)
+        : m_stage(stage), m_bytes(0) {
+        resize(bytes);
+    }
+
+    ~MemoryCharge() { reset(); }
+
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+    MemoryCharge(MemoryCharge&& other) noexcept
+        : m_stage(other.m_stage), m_bytes(other.m_bytes) {
+        other.m_bytes = 0;
+    }
+
+    MemoryCharge& operator=(MemoryCharge&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_stage = other.m_stage;
+            m_bytes = other.m_bytes;
+            other.m_bytes = 0;
+        }
+        return *this;
+    }
+
+    void resize(qint64 bytes) {
+        MemoryAccounting::instance().charge(m_stage, bytes - m_bytes);
+        m_bytes = bytes;
+    }
+
+    void add(qint64 bytes) { resize(m_bytes + bytes); }
+    void reset() { resize(0); }
+    qint64 bytes() const { return m_bytes; }
+
+    // Take over a reservation already made with MemoryAccounting::tryAdmit()
+    static MemoryCharge adopt(MemoryStage stage, qint64 bytes) {
+        MemoryCharge charge(stage);
+        charge.m_bytes = bytes;
+        return charge;
+    }
+
+private:
+    MemoryStage m_stage;
+    qint64 m_bytes;
+};
+
+#endif // MEMORYBUDGET_H
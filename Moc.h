@@ -0,0 +1,438 @@
+// Moc.h - Multi-Order Coverage maps (IVOA MOC) over HEALPix NEST cells
+// A MOC is a sorted list of disjoint half-open ranges of order-29 NEST
+// indices, so union, intersection and difference are linear merges and
+// "is this region covered?" is a binary search per region range.
+#ifndef MOC_H
+#define MOC_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDebug>
+#include <fitsio.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+class Moc {
+public:
+    static constexpr int kMaxOrder = 29;
+
+    // [begin, end) in order-29 NEST indices
+    using Range = std::pair<uint64_t, uint64_t>;
+
+    Moc() = default;
+
+    static Moc fromCell(int order, uint64_t pixel) {
+        Moc moc;
+        moc.addCell(order, pixel);
+        return moc;
+    }
+
+    // Cells of `order` touching the cone (inclusive) or lying entirely
+    // inside it (inner). Query with inclusive regions and record what is
+    // held with inner ones, so "covered" never over-promises.
+    static Moc fromCone(double raDeg, double decDeg, double radiusDeg, int order,
+                        bool inclusive = true) {
+        Moc moc;
+        order = std::clamp(order, 0, kMaxOrder);
+        double center[3];
+        toVector(raDeg, decDeg, center);
+        double radius = radiusDeg * M_PI / 180.0;
+        for (uint64_t face = 0; face < 12; ++face) {
+            coneCells(moc, center, radius, 0, face, order, inclusive);
+        }
+        return moc;
+    }
+
+    // Incremental insert, merging with touching neighbours
+    void addCell(int order, uint64_t pixel) {
+        int shift = 2 * (kMaxOrder - order);
+        addRange(pixel << shift, (pixel + 1) << shift);
+    }
+
+    void addRange(uint64_t begin, uint64_t end) {
+        if (begin >= end) return;
+        // First range that ends at or after `begin` (touching ranges merge)
+        auto first = std::lower_bound(m_ranges.begin(), m_ranges.end(), begin,
+                                      [](const Range& r, uint64_t v) { return r.second < v; });
+        auto last = first;
+        while (last != m_ranges.end() && last->first <= end) {
+            begin = std::min(begin, last->first);
+            end = std::max(end, last->second);
+            ++last;
+        }
+        if (first == last) {
+            m_ranges.insert(first, {begin, end});
+        } else {
+            *first = {begin, end};
+            m_ranges.erase(first + 1, last);
+        }
+    }
+
+    void add(const Moc& other) { *this = united(other); }
+
+    Moc united(const Moc& other) const {
+        Moc result;
+        std::vector<Range>& out = result.m_ranges;
+        out.reserve(m_ranges.size() + other.m_ranges.size());
+        auto a = m_ranges.begin(), b = other.m_ranges.begin();
+        while (a != m_ranges.end() || b != other.m_ranges.end()) {
+            const Range& next = (b == other.m_ranges.end() ||
+                                 (a != m_ranges.end() && a->first < b->first)) ? *a++ : *b++;
+            if (!out.empty() && next.first <= out.back().second) {
+                out.back().second = std::max(out.back().second, next.second);
+            } else {
+                out.push_back(next);
+            }
+        }
+        return result;
+    }
+
+    Moc intersected(const Moc& other) const {
+        Moc result;
+        auto a = m_ranges.begin(), b = other.m_ranges.begin();
+        while (a != m_ranges.end() && b != other.m_ranges.end()) {
+            uint64_t begin = std::max(a->first, b->first);
+            uint64_t end = std::min(a->second, b->second);
+            if (begin < end) result.m_ranges.push_back({begin, end});
+            if (a->second < b->second) ++a; else ++b;
+        }
+        return result;
+    }
+
+    // This minus other: e.g. region.subtracted(cache) = what still needs syncing
+    Moc subtracted(const Moc& other) const {
+        Moc result;
+        auto b = other.m_ranges.begin();
+        for (Range r : m_ranges) {
+            while (b != other.m_ranges.end() && b->second <= r.first) ++b;
+            for (auto c = b; c != other.m_ranges.end() && c->first < r.second; ++c) {
+                if (c->first > r.first) result.m_ranges.push_back({r.first, c->first});
+                r.first = std::max(r.first, c->second);
+                if (r.first >= r.second) break;
+            }
+            if (r.first < r.second) result.m_ranges.push_back(r);
+        }
+        return result;
+    }
+
+    // True if every cell of `region` is covered
+    bool contains(const Moc& region) const {
+        for (const Range& r : region.m_ranges) {
+            auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), r.first,
+                                       [](uint64_t v, const Range& c) { return v < c.first; });
+            if (it == m_ranges.begin()) return false;
+            --it;
+            if (it->second < r.second) return false;
+        }
+        return true;
+    }
+
+    bool intersects(const Moc& region) const {
+        for (const Range& r : region.m_ranges) {
+            auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), r.first,
+                                       [](const Range& c, uint64_t v) { return c.second <= v; });
+            if (it != m_ranges.end() && it->first < r.second) return true;
+        }
+        return false;
+    }
+
+    bool containsCell(int order, uint64_t pixel) const {
+        return contains(fromCell(order, pixel));
+    }
+
+    bool containsPoint(double raDeg, double decDeg) const {
+        return containsCell(kMaxOrder, pixelAt(kMaxOrder, raDeg, decDeg));
+    }
+
+    bool isEmpty() const { return m_ranges.empty(); }
+    void clear() { m_ranges.clear(); }
+    const std::vector<Range>& ranges() const { return m_ranges; }
+
+    // Ranges already sorted and disjoint, e.g. from ranges() of another MOC
+    static Moc fromRanges(const Range* ranges, size_t count) {
+        Moc moc;
+        moc.m_ranges.assign(ranges, ranges + count);
+        return moc;
+    }
+    bool operator==(const Moc& other) const { return m_ranges == other.m_ranges; }
+
+    double skyFraction() const {
+        long double cells = 0;
+        for (const Range& r : m_ranges) cells += r.second - r.first;
+        return double(cells / (12.0L * std::pow(4.0L, kMaxOrder)));
+    }
+
+    double areaSqDeg() const {
+        return skyFraction() * 4.0 * M_PI * std::pow(180.0 / M_PI, 2);
+    }
+
+    // Finest order needed to express the ranges exactly
+    int order() const {
+        int finest = 0;
+        for (const Range& r : m_ranges) {
+            finest = std::max({finest, alignmentOrder(r.first), alignmentOrder(r.second)});
+        }
+        return finest;
+    }
+
+    // Coarsest cells covering the ranges, as NUNIQ = 4 * 4^order + pixel
+    std::vector<uint64_t> toUniq() const {
+        std::vector<uint64_t> uniq;
+        for (Range r : m_ranges) {
+            while (r.first < r.second) {
+                // Largest aligned cell starting at r.first that fits in the range
+                int level = 0;
+                while (level < kMaxOrder) {
+                    uint64_t size = uint64_t(1) << (2 * (level + 1));
+                    if (r.first % size != 0 || r.first + size > r.second) break;
+                    ++level;
+                }
+                int cellOrder = kMaxOrder - level;
+                uint64_t pixel = r.first >> (2 * level);
+                uniq.push_back((uint64_t(4) << (2 * cellOrder)) + pixel);
+                r.first += uint64_t(1) << (2 * level);
+            }
+        }
+        return uniq;
+    }
+
+    static Moc fromUniq(const std::vector<uint64_t>& uniq) {
+        std::vector<Range> ranges;
+        ranges.reserve(uniq.size());
+        for (uint64_t u : uniq) {
+            if (u < 4) continue;
+            int cellOrder = 0;
+            while ((uint64_t(4) << (2 * (cellOrder + 1))) <= u) ++cellOrder;
+            uint64_t pixel = u - (uint64_t(4) << (2 * cellOrder));
+            int shift = 2 * (kMaxOrder - cellOrder);
+            ranges.push_back({pixel << shift, (pixel + 1) << shift});
+        }
+        std::sort(ranges.begin(), ranges.end());
+        Moc moc;
+        for (const Range& r : ranges) {
+            if (!moc.m_ranges.empty() && r.first <= moc.m_ranges.back().second) {
+                moc.m_ranges.back().second = std::max(moc.m_ranges.back().second, r.second);
+            } else {
+                moc.m_ranges.push_back(r);
+            }
+        }
+        return moc;
+    }
+
+    // FITS MOC (2.0 keywords, readable by 1.x tools): one binary table,
+    // column UNIQ (64-bit NUNIQ)
+    bool writeFits(const QString& filename, const QString& tool = "dss") const {
+        std::vector<uint64_t> uniqCells = toUniq();
+        std::vector<LONGLONG> uniq(uniqCells.begin(), uniqCells.end());
+
+        fitsfile* fptr = nullptr;
+        int status = 0;
+        QByteArray path = ("!" + filename).toLocal8Bit();    // '!' overwrites
+        if (fits_create_file(&fptr, path.constData(), &status)) {
+            fits_report_error(stderr, status);
+            return false;
+        }
+        char ttype[] = "UNIQ";
+        char tform[] = "1K";
+        char* ttypes[] = {ttype};
+        char* tforms[] = {tform};
+        fits_create_tbl(fptr, BINARY_TBL, 0, 1, ttypes, tforms, nullptr, "COVERAGE", &status);
+
+        int mocOrder = order();
+        QByteArray toolName = tool.toLatin1();
+        char pixtype[] = "HEALPIX", ordering[] = "NUNIQ", coordsys[] = "C";
+        char mocdim[] = "SPACE", mocvers[] = "2.0";
+        fits_update_key(fptr, TSTRING, "MOCVERS", mocvers, "MOC version", &status);
+        fits_update_key(fptr, TSTRING, "MOCDIM", mocdim, "Physical dimension", &status);
+        fits_update_key(fptr, TSTRING, "PIXTYPE", pixtype, "HEALPix magic code", &status);
+        fits_update_key(fptr, TSTRING, "ORDERING", ordering, "NUNIQ coding method", &status);
+        fits_update_key(fptr, TSTRING, "COORDSYS", coordsys, "ICRS reference frame", &status);
+        fits_update_key(fptr, TINT, "MOCORDER", &mocOrder, "MOC resolution (best order)", &status);
+        fits_update_key(fptr, TINT, "MOCORD_S", &mocOrder, "MOC resolution (best order)", &status);
+        fits_update_key(fptr, TSTRING, "MOCTOOL", toolName.data(), "Name of the MOC generator", &status);
+        if (!uniq.empty()) {
+            fits_write_col(fptr, TLONGLONG, 1, 1, 1, uniq.size(), uniq.data(), &status);
+        }
+        fits_close_file(fptr, &status);
+        if (status) {
+            fits_report_error(stderr, status);
+            return false;
+        }
+        return true;
+    }
+
+    static bool readFits(const QString& filename, Moc& moc) {
+        fitsfile* fptr = nullptr;
+        int status = 0;
+        if (fits_open_table(&fptr, filename.toLocal8Bit().constData(), READONLY, &status)) {
+            fits_report_error(stderr, status);
+            return false;
+        }
+        LONGLONG rows = 0;
+        int column = 1;
+        char uniqName[] = "UNIQ";
+        fits_get_num_rowsll(fptr, &rows, &status);
+        fits_get_colnum(fptr, CASEINSEN, uniqName, &column, &status);
+        std::vector<LONGLONG> uniq(rows);
+        if (rows > 0) {
+            fits_read_col(fptr, TLONGLONG, column, 1, 1, rows, nullptr, uniq.data(), nullptr, &status);
+        }
+        fits_close_file(fptr, &status);
+        if (status) {
+            fits_report_error(stderr, status);
+            return false;
+        }
+        moc = fromUniq(std::vector<uint64_t>(uniq.begin(), uniq.end()));
+        return true;
+    }
+
+    // NEST index of the cell containing (ra, dec)
+    static uint64_t pixelAt(int order, double raDeg, double decDeg) {
+        const uint64_t nside = uint64_t(1) << order;
+        double z = std::sin(decDeg * M_PI / 180.0);
+        double za = std::abs(z);
+        double tt = std::fmod(raDeg / 90.0, 4.0);
+        if (tt < 0) tt += 4.0;
+
+        uint64_t face, ix, iy;
+        if (za <= 2.0 / 3.0) {
+            double temp1 = nside * (0.5 + tt);
+            double temp2 = nside * z * 0.75;
+            uint64_t jp = uint64_t(temp1 - temp2);    // ascending edge line
+            uint64_t jm = uint64_t(temp1 + temp2);    // descending edge line
+            uint64_t ifp = jp >> order, ifm = jm >> order;
+            face = ifp == ifm ? (ifp | 4) : (ifp < ifm ? ifp : ifm + 8);
+            ix = jm & (nside - 1);
+            iy = nside - (jp & (nside - 1)) - 1;
+        } else {
+            int ntt = std::min(3, int(tt));
+            double tp = tt - ntt;
+            double tmp = nside * std::sqrt(3.0 * (1.0 - za));
+            uint64_t jp = std::min(nside - 1, uint64_t(tp * tmp));
+            uint64_t jm = std::min(nside - 1, uint64_t((1.0 - tp) * tmp));
+            if (z >= 0) {
+                face = ntt;
+                ix = nside - jm - 1;
+                iy = nside - jp - 1;
+            } else {
+                face = ntt + 8;
+                ix = jp;
+                iy = jm;
+            }
+        }
+        return (face << (2 * order)) + spread(ix) + (spread(iy) << 1);
+    }
+
+    static void cellCenter(int order, uint64_t pixel, double& raDeg, double& decDeg) {
+        double v[3];
+        cellVector(order, pixel, v);
+        decDeg = std::asin(std::clamp(v[2], -1.0, 1.0)) * 180.0 / M_PI;
+        raDeg = std::atan2(v[1], v[0]) * 180.0 / M_PI;
+        if (raDeg < 0) raDeg += 360.0;
+    }
+
+private:
+    std::vector<Range> m_ranges;
+
+    static int alignmentOrder(uint64_t boundary) {
+        if (boundary == 0) return 0;
+        int zeros = 0;
+        while (zeros < 2 * kMaxOrder && !(boundary & (uint64_t(1) << zeros))) ++zeros;
+        return kMaxOrder - zeros / 2;
+    }
+
+    // Interleave the bits of x into the even bit positions
+    static uint64_t spread(uint64_t x) {
+        x &= 0xFFFFFFFFull;
+        x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+        x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+        x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+        x = (x | (x << 2)) & 0x3333333333333333ull;
+        x = (x | (x << 1)) & 0x5555555555555555ull;
+        return x;
+    }
+
+    static uint64_t compress(uint64_t x) {
+        x &= 0x5555555555555555ull;
+        x = (x | (x >> 1)) & 0x3333333333333333ull;
+        x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+        x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+        x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+        x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+        return x;
+    }
+
+    static void toVector(double raDeg, double decDeg, double* v) {
+        double ra = raDeg * M_PI / 180.0, dec = decDeg * M_PI / 180.0;
+        v[0] = std::cos(dec) * std::cos(ra);
+        v[1] = std::cos(dec) * std::sin(ra);
+        v[2] = std::sin(dec);
+    }
+
+    // Unit vector of a NEST cell centre
+    static void cellVector(int order, uint64_t pixel, double* v) {
+        static const int jrll[12] = {2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4};
+        static const int jpll[12] = {1, 3, 5, 7, 0, 2, 4, 6, 1, 3, 5, 7};
+        const int64_t nside = int64_t(1) << order;
+        const double npface = double(nside) * nside;
+        int face = int(pixel >> (2 * order));
+        uint64_t inFace = pixel & ((uint64_t(1) << (2 * order)) - 1);
+        int64_t ix = compress(inFace), iy = compress(inFace >> 1);
+
+        int64_t jr = jrll[face] * nside - ix - iy - 1;
+        int64_t nr, kshift;
+        double z;
+        if (jr < nside) {
+            nr = jr;
+            z = 1.0 - nr * nr / (3.0 * npface);
+            kshift = 0;
+        } else if (jr > 3 * nside) {
+            nr = 4 * nside - jr;
+            z = nr * nr / (3.0 * npface) - 1.0;
+            kshift = 0;
+        } else {
+            nr = nside;
+            z = (2 * nside - jr) * 2.0 / (3.0 * nside);
+            kshift = (jr - nside) & 1;
+        }
+        int64_t jp = (jpll[face] * nr + ix - iy + 1 + kshift) / 2;
+        if (jp > 4 * nside) jp -= 4 * nside;
+        if (jp < 1) jp += 4 * nside;
+        double phi = (jp - (kshift + 1) * 0.5) * (M_PI / 2.0 / nr);
+        double sinTheta = std::sqrt(std::max(0.0, (1.0 - z) * (1.0 + z)));
+        v[0] = sinTheta * std::cos(phi);
+        v[1] = sinTheta * std::sin(phi);
+        v[2] = z;
+    }
+
+    // Upper bound on the centre-to-corner angle of any cell of `order`
+    static double cellRadius(int order) {
+        return 1.1 / double(uint64_t(1) << order);
+    }
+
+    static void coneCells(Moc& moc, const double* center, double radius,
+                          int order, uint64_t pixel, int maxOrder, bool inclusive) {
+        double v[3];
+        cellVector(order, pixel, v);
+        double dot = std::clamp(v[0] * center[0] + v[1] * center[1] + v[2] * center[2], -1.0, 1.0);
+        double distance = std::acos(dot);
+        double cell = cellRadius(order);
+        if (distance - cell >= radius) return;                  // wholly outside
+        if (distance + cell <= radius) {                        // wholly inside
+            moc.addCell(order, pixel);
+            return;
+        }
+        if (order == maxOrder) {
+            if (inclusive) moc.addCell(order, pixel);
+            return;
+        }
+        for (uint64_t child = 0; child < 4; ++child) {
+            coneCells(moc, center, radius, order + 1, 4 * pixel + child, maxOrder, inclusive);
+        }
+    }
+};
+
+#endif // MOC_H
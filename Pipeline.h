@@ -0,0 +1,346 @@
+// Pipeline.h - Stage-graph executor with bounded lock-free queues
+// Each stage owns a bounded MPMC queue and a fixed number of worker threads.
+// When a stage's queue is full its producers block, so a slow encoder
+// throttles resampling, which in turn throttles submission (downloads)
+// instead of letting decoded frames pile up in memory. Per-stage busy,
+// idle and blocked times make utilisation observable.
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Bounded multi-producer/multi-consumer queue (Vyukov). Each cell carries a
+// sequence number that tells producers and consumers whose turn it is, so
+// push and pop are a single CAS on the shared index in the common case.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        m_mask = size - 1;
+        m_cells = std::unique_ptr<Cell[]>(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    size_t capacity() const { return m_mask + 1; }
+
+    // Moves from `item` only on success
+    bool tryPush(T& item) {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;   // full
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item) {
+        Cell* cell;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;   // empty
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->data);
+        cell->data = T();   // drop references (e.g. pooled image buffers) promptly
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate; exact only when no push/pop is in progress
+    size_t sizeApprox() const {
+        size_t enq = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t deq = m_dequeuePos.load(std::memory_order_relaxed);
+        return enq >= deq ? enq - deq : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    // Producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) std::atomic<size_t> m_dequeuePos;
+    alignas(64) std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+};
+
+// Linear chain of stages over one item type. A stage function transforms the
+// item in place and returns false to drop it (e.g. decode failure).
+template <typename T>
+class Pipeline {
+public:
+    using StageFunction = std::function<bool(T&)>;
+
+    struct StageStats {
+        QString name;
+        int concurrency;
+        qint64 processed;   // Items the stage function ran on
+        qint64 dropped;     // Items the stage function rejected
+        qint64 busyNs;      // Time spent inside the stage function
+        qint64 idleNs;      // Time waiting for input
+        qint64 blockedNs;   // Time waiting for space downstream (backpressure)
+        size_t queued;      // Items waiting in the stage's input queue
+        size_t capacity;
+    };
+
+    explicit Pipeline(const QString& name = "pipeline") : m_name(name) {}
+
+    ~Pipeline() {
+        close();
+        wait();
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Stages run in the order they are added; call before start()
+    Pipeline& addStage(const QString& name, int concurrency, size_t queueCapacity,
+                       StageFunction fn) {
+        auto stage = std::make_unique<Stage>(queueCapacity);
+        stage->name = name;
+        stage->concurrency = std::max(1, concurrency);
+        stage->fn = std::move(fn);
+        m_stages.push_back(std::move(stage));
+        return *this;
+    }
+
+    void start() {
+        m_clock.start();
+        for (size_t i = 0; i < m_stages.size(); ++i) {
+            Stage* stage = m_stages[i].get();
+            stage->liveWorkers.store(stage->concurrency);
+            for (int w = 0; w < stage->concurrency; ++w) {
+                m_threads.emplace_back([this, i]() { workerLoop(i); });
+            }
+        }
+    }
+
+    // Hand an item to the first stage; false (item untouched) if its queue is full
+    bool trySubmit(T& item) {
+        if (m_stages.empty()) return false;
+        Stage* first = m_stages.front().get();
+        if (!first->queue.tryPush(item)) return false;
+        first->wakeConsumer();
+        return true;
+    }
+
+    // Blocking submit for producers that are not on an event loop
+    void submit(T& item) {
+        Stage* first = m_stages.front().get();
+        while (!first->queue.tryPush(item)) {
+            first->waitForSpace();
+        }
+        first->wakeConsumer();
+    }
+
+    // No more submissions; stages drain in order and their workers exit
+    void close() {
+        if (m_stages.empty() || m_stages.front()->inputClosed.exchange(true)) return;
+        m_stages.front()->wakeAll();
+    }
+
+    void wait() {
+        for (std::thread& thread : m_threads) {
+            if (thread.joinable()) thread.join();
+        }
+        m_threads.clear();
+    }
+
+    QList<StageStats> stats() const {
+        QList<StageStats> result;
+        for (const auto& stage : m_stages) {
+            StageStats s;
+            s.name = stage->name;
+            s.concurrency = stage->concurrency;
+            s.processed = stage->processed.load();
+            s.dropped = stage->dropped.load();
+            s.busyNs = stage->busyNs.load();
+            s.idleNs = stage->idleNs.load();
+            s.blockedNs = stage->blockedNs.load();
+            s.queued = stage->queue.sizeApprox();
+            s.capacity = stage->queue.capacity();
+            result << s;
+        }
+        return result;
+    }
+
+    // Utilisation = busy time / (wall time x workers)
+    QStringList statsLines() const {
+        QStringList lines;
+        double wallNs = std::max<qint64>(1, m_clock.isValid() ? m_clock.nsecsElapsed() : 1);
+        lines << QString("%1 %2 %3 %4 %5 %6 %7")
+                 .arg("Stage", -12).arg("Workers", 8).arg("Items", 8).arg("Dropped", 8)
+                 .arg("Busy %", 8).arg("Blocked %", 10).arg("Queue", 8);
+        for (const StageStats& s : stats()) {
+            double capacityNs = wallNs * s.concurrency;
+            lines << QString("%1 %2 %3 %4 %5 %6 %7")
+                     .arg(s.name, -12)
+                     .arg(s.concurrency, 8)
+                     .arg(s.processed, 8)
+                     .arg(s.dropped, 8)
+                     .arg(100.0 * s.busyNs / capacityNs, 8, 'f', 1)
+                     .arg(100.0 * s.blockedNs / capacityNs, 10, 'f', 1)
+                     .arg(QString("%1/%2").arg(s.queued).arg(s.capacity), 8);
+        }
+        return lines;
+    }
+
+    void printStats() const {
+        qDebug() << QString("=== Pipeline %1 ===").arg(m_name);
+        for (const QString& line : statsLines()) {
+            qDebug().noquote() << line;
+        }
+    }
+
+private:
+    // Parked threads re-check their queue at least this often, so a wake-up
+    // lost between a failed tryPop and the wait costs at most one interval
+    static constexpr unsigned long kParkMs = 5;
+
+    struct Stage {
+        explicit Stage(size_t capacity) : queue(capacity) {}
+
+        QString name;
+        int concurrency = 1;
+        StageFunction fn;
+        BoundedQueue<T> queue;
+
+        std::atomic<bool> inputClosed{false};
+        std::atomic<int> liveWorkers{0};
+
+        std::atomic<qint64> processed{0};
+        std::atomic<qint64> dropped{0};
+        std::atomic<qint64> busyNs{0};
+        std::atomic<qint64> idleNs{0};
+        std::atomic<qint64> blockedNs{0};
+
+        QMutex parkMutex;
+        QWaitCondition notEmpty;
+        QWaitCondition notFull;
+
+        void wakeConsumer() {
+            QMutexLocker locker(&parkMutex);
+            notEmpty.wakeOne();
+        }
+        void wakeProducer() {
+            QMutexLocker locker(&parkMutex);
+            notFull.wakeOne();
+        }
+        void wakeAll() {
+            QMutexLocker locker(&parkMutex);
+            notEmpty.wakeAll();
+            notFull.wakeAll();
+        }
+        void waitForItem() {
+            QMutexLocker locker(&parkMutex);
+            notEmpty.wait(&parkMutex, kParkMs);
+        }
+        void waitForSpace() {
+            QMutexLocker locker(&parkMutex);
+            notFull.wait(&parkMutex, kParkMs);
+        }
+    };
+
+    QString m_name;
+    std::vector<std::unique_ptr<Stage>> m_stages;
+    std::vector<std::thread> m_threads;
+    QElapsedTimer m_clock;
+
+    void workerLoop(size_t index) {
+        Stage* stage = m_stages[index].get();
+        Stage* next = index + 1 < m_stages.size() ? m_stages[index + 1].get() : nullptr;
+        QElapsedTimer timer;
+
+        for (;;) {
+            T item;
+            timer.start();
+            bool got = stage->queue.tryPop(item);
+            while (!got) {
+                // Producers push before closing, so closed + empty means drained
+                if (stage->inputClosed.load()) {
+                    got = stage->queue.tryPop(item);
+                    if (!got) break;
+                } else {
+                    stage->waitForItem();
+                    got = stage->queue.tryPop(item);
+                }
+            }
+            stage->idleNs += timer.nsecsElapsed();
+            if (!got) break;
+            stage->wakeProducer();
+
+            timer.start();
+            bool keep = stage->fn(item);
+            stage->busyNs += timer.nsecsElapsed();
+            stage->processed++;
+            if (!keep) {
+                stage->dropped++;
+                continue;
+            }
+
+            if (next) {
+                timer.start();
+                while (!next->queue.tryPush(item)) {
+                    next->waitForSpace();
+                }
+                stage->blockedNs += timer.nsecsElapsed();
+                next->wakeConsumer();
+            }
+        }
+
+        // Last worker out closes the next stage's input
+        if (stage->liveWorkers.fetch_sub(1) == 1 && next) {
+            next->inputClosed.store(true);
+            next->wakeAll();
+        }
+    }
+};
+
+#endif // PIPELINE_H
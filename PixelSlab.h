@@ -0,0 +1,252 @@
+// PixelSlab.h - Memory-mapped cache of decoded tile pixels
+// One slab file holds fixed-size slots, each a 4 KB header page followed
+// by a 512x512 RGB888 tile. Tiles decoded often enough are copied into a
+// slot; later loads return a QImage over the mapped slot, so hot tiles
+// (popular Messier fields) reach assembly with no JPEG decode at all.
+// Images pin their slot until released, and eviction replaces the least
+// used unpinned slot.
+//
+// A slab file belongs to one process at a time, held by a lock file for
+// the slab's lifetime; a concurrent process takes the next free file
+// (pixels-1.slab, ...) so slots are never rewritten under another
+// process's mapped images. Each file persists for later runs.
+//
+//   DSS_PIXEL_SLAB_MB     Slab size (default 0 = disabled)
+//   DSS_PIXEL_SLAB_HITS   Decodes of a tile before it is promoted (default 3)
+#ifndef PIXELSLAB_H
+#define PIXELSLAB_H
+
+#include <QString>
+#include <QImage>
+#include <QHash>
+#include <QVector>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QLockFile>
+#include <QDebug>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+class PixelSlab {
+public:
+    static constexpr int kTileSize = 512;
+    static constexpr qint64 kHeaderBytes = 4096;
+    static constexpr qint64 kPixelBytes = qint64(kTileSize) * kTileSize * 3;
+    static constexpr qint64 kSlotBytes = kHeaderBytes + kPixelBytes;
+    static constexpr int kMaxFiles = 8;             // Concurrent processes with a slab
+    static constexpr int kDecodesPerSlot = 4;       // Decode counts kept per slot
+
+    // Size and promotion threshold from the environment
+    static std::unique_ptr<PixelSlab> fromEnvironment(const QString& path) {
+        const char* mb = std::getenv("DSS_PIXEL_SLAB_MB");
+        qint64 bytes = mb ? qint64(QString(mb).toLongLong()) * 1024 * 1024 : 0;
+        const char* hits = std::getenv("DSS_PIXEL_SLAB_HITS");
+        int threshold = hits ? qMax(1, QString(hits).toInt()) : 3;
+        return std::make_unique<PixelSlab>(path, int(bytes / kSlotBytes), threshold);
+    }
+
+    PixelSlab(const QString& path, int slots, int promoteAfter)
+        : m_state(std::make_shared<State>()), m_promoteAfter(promoteAfter) {
+        if (slots <= 0) return;
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        State& state = *m_state;
+        QString slabPath = claimFile(path);
+        if (slabPath.isEmpty()) {
+            qDebug() << "Pixel slab unavailable: all" << kMaxFiles << "slab files in use";
+            return;
+        }
+        state.file.setFileName(slabPath);
+        if (!state.file.open(QIODevice::ReadWrite) || !state.file.resize(slots * kSlotBytes)) {
+            qDebug() << "Pixel slab unavailable:" << slabPath << state.file.errorString();
+            return;
+        }
+        state.base = state.file.map(0, slots * kSlotBytes);
+        if (!state.base) {
+            qDebug() << "Failed to map pixel slab:" << slabPath;
+            return;
+        }
+        state.slots.resize(slots);
+        for (int i = 0; i < slots; ++i) {
+            const Header* header = headerAt(i);
+            if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) continue;
+            QString hash = QString::fromLatin1(header->hash, sizeof(header->hash));
+            state.slots[i].hash = hash;
+            state.slots[i].uses = header->uses;
+            state.index.insert(hash, i);
+        }
+        qDebug() << QString("Pixel slab: %1 of %2 slots filled in %3")
+                    .arg(state.index.size()).arg(slots).arg(slabPath);
+    }
+
+    bool isEnabled() const { return m_state->base != nullptr; }
+
+    // Tile for `hash` backed by the mapping, or null if not resident
+    QImage lookup(const QString& hash) {
+        if (!isEnabled()) return QImage();
+        State& state = *m_state;
+        QMutexLocker locker(&state.mutex);
+        auto it = state.index.constFind(hash);
+        if (it == state.index.constEnd()) {
+            m_misses++;
+            return QImage();
+        }
+        int slot = *it;
+        Slot& entry = state.slots[slot];
+        entry.uses++;
+        entry.pins++;
+        headerAt(slot)->uses = entry.uses;
+        m_hits++;
+        auto* pin = new Pin{m_state, slot};
+        // Read-only over the slot: writing to the image detaches a copy
+        const uchar* pixels = state.base + slot * kSlotBytes + kHeaderBytes;
+        return QImage(pixels, kTileSize, kTileSize, kTileSize * 3, QImage::Format_RGB888,
+                      &PixelSlab::unpin, pin);
+    }
+
+    // Called after each full decode of `hash`; copies the pixels into a
+    // slot once the tile has been decoded promoteAfter times
+    void noteDecode(const QString& hash, const QImage& image) {
+        if (!isEnabled() || image.width() != kTileSize || image.height() != kTileSize) return;
+        State& state = *m_state;
+        QMutexLocker locker(&state.mutex);
+        if (state.index.contains(hash)) return;
+        if (state.decodes.size() >= state.slots.size() * kDecodesPerSlot) ageDecodesLocked();
+        int decodes = ++state.decodes[hash];
+        if (decodes < m_promoteAfter) return;
+
+        int slot = victimLocked();
+        if (slot < 0) return;
+        Slot& entry = state.slots[slot];
+        if (!entry.hash.isEmpty()) {
+            // Full slab: halve every count so past popularity fades
+            state.index.remove(entry.hash);
+            for (Slot& other : state.slots) other.uses >>= 1;
+        }
+
+        // Clear the magic first so a crash mid-copy leaves an empty slot
+        Header* header = headerAt(slot);
+        std::memset(header, 0, sizeof(Header));
+        QImage rgb = image.convertToFormat(QImage::Format_RGB888);
+        uchar* pixels = state.base + slot * kSlotBytes + kHeaderBytes;
+        for (int y = 0; y < kTileSize; ++y) {
+            std::memcpy(pixels + y * kTileSize * 3, rgb.constScanLine(y), kTileSize * 3);
+        }
+        QByteArray hashBytes = hash.toLatin1().leftJustified(sizeof(header->hash), '\0', true);
+        std::memcpy(header->hash, hashBytes.constData(), sizeof(header->hash));
+        header->uses = quint32(decodes);
+        std::memcpy(header->magic, kMagic, sizeof(kMagic));
+
+        entry.hash = hash;
+        entry.uses = quint32(decodes);
+        state.index.insert(hash, slot);
+        state.decodes.remove(hash);
+        m_promotions++;
+    }
+
+    void printStats() const {
+        if (!isEnabled()) return;
+        QMutexLocker locker(&m_state->mutex);
+        qDebug() << QString("Pixel slab: %1/%2 slots, %3 hits, %4 misses, %5 promotions")
+                    .arg(m_state->index.size()).arg(m_state->slots.size())
+                    .arg(m_hits.load()).arg(m_misses.load()).arg(m_promotions.load());
+    }
+
+private:
+    static constexpr char kMagic[8] = {'D', 'S', 'S', 'P', 'I', 'X', '1', '\0'};
+
+    struct Header {
+        char magic[8];
+        char hash[40];          // SHA-1 hex of the tile's JPEG
+        quint32 uses;
+    };
+
+    struct Slot {
+        QString hash;
+        quint32 uses = 0;
+        int pins = 0;           // Live QImages over this slot
+    };
+
+    // Shared with every pinned image so the mapping outlives the slab
+    // object if an image is released after it
+    struct State {
+        std::unique_ptr<QLockFile> lock;
+        QFile file;
+        uchar* base = nullptr;
+        QMutex mutex;
+        QVector<Slot> slots;
+        QHash<QString, int> index;      // hash -> slot
+        QHash<QString, int> decodes;    // hash -> decodes while not resident
+    };
+
+    struct Pin {
+        std::shared_ptr<State> state;
+        int slot;
+    };
+
+    std::shared_ptr<State> m_state;
+    int m_promoteAfter;
+    std::atomic<qint64> m_hits{0};
+    std::atomic<qint64> m_misses{0};
+    std::atomic<qint64> m_promotions{0};
+
+    Header* headerAt(int slot) const {
+        return reinterpret_cast<Header*>(m_state->base + slot * kSlotBytes);
+    }
+
+    // `path`, or the first of path-1, path-2, ... not locked by another
+    // live process; the lock stays held in the state
+    QString claimFile(const QString& path) {
+        QFileInfo info(path);
+        for (int i = 0; i < kMaxFiles; ++i) {
+            QString candidate = i == 0 ? path
+                : QString("%1/%2-%3.%4").arg(info.absolutePath()).arg(info.completeBaseName())
+                                        .arg(i).arg(info.suffix());
+            auto lock = std::make_unique<QLockFile>(candidate + ".lock");
+            lock->setStaleLockTime(0);      // Stale only once the owner has exited
+            if (lock->tryLock(0)) {
+                m_state->lock = std::move(lock);
+                return candidate;
+            }
+        }
+        return QString();
+    }
+
+    // Bound the counts of tiles not yet promoted: halve them all and drop
+    // those that reach zero, as eviction does for slot uses
+    void ageDecodesLocked() {
+        QHash<QString, int>& decodes = m_state->decodes;
+        for (auto it = decodes.begin(); it != decodes.end();) {
+            it.value() >>= 1;
+            if (it.value() == 0) it = decodes.erase(it);
+            else ++it;
+        }
+    }
+
+    static void unpin(void* info) {
+        Pin* pin = static_cast<Pin*>(info);
+        {
+            QMutexLocker locker(&pin->state->mutex);
+            pin->state->slots[pin->slot].pins--;
+        }
+        delete pin;
+    }
+
+    // First empty slot, else the unpinned slot with the fewest uses
+    int victimLocked() const {
+        const QVector<Slot>& slots = m_state->slots;
+        int best = -1;
+        for (int i = 0; i < slots.size(); ++i) {
+            if (slots[i].hash.isEmpty()) return i;
+            if (slots[i].pins > 0) continue;
+            if (best < 0 || slots[i].uses < slots[best].uses) best = i;
+        }
+        return best;
+    }
+};
+
+#endif // PIXELSLAB_H
@@ -74,23 +74,28 @@ QMap<QString, long long> ProperHipsClient::getDirectionalNeighbors(long long cen
 }
 
 // Create proper 3x3 grid from directional neighbors
-QList<QList<long long>> ProperHipsClient::createProper3x3Grid(long long centerPixel, int order) const {
-    QMap<QString, long long> neighbors = getDirectionalNeighbors(centerPixel, order);
-    
-    // Map directions to 3x3 grid positions
+TileGrid ProperHipsClient::createProper3x3Grid(long long centerPixel, int order) const {
     // Grid layout:
     // [NW] [N ] [NE]
     // [W ] [C ] [E ]  
     // [SW] [S ] [SE]
+    TileGrid grid{order, {{-1, -1, -1}, {-1, centerPixel, -1}, {-1, -1, -1}}};
     
-    QList<QList<long long>> grid = {
-        // Bottom row: SW, S, SE
-        {neighbors.value("SW", -1), neighbors.value("S", -1), neighbors.value("SE", -1)},
-        // Middle row: W, Center, E  
-        {neighbors.value("W", -1), centerPixel, neighbors.value("E", -1)},
-        // Top row: NW, N, NE
-        {neighbors.value("NW", -1), neighbors.value("N", -1), neighbors.value("NE", -1)}
-    };
+    try {
+        long long nside = 1LL << order;
+        Healpix_Base healpix(nside, NEST, SET_NSIDE);
+        
+        fix_arr<int,8> neighborArray;
+        healpix.neighbors(centerPixel, neighborArray);
+        
+        // Neighbour order as in getDirectionalNeighbors: S, SE, E, NE, N, NW, W, SW
+        static const int cell[8][2] = {{1, 0}, {2, 0}, {2, 1}, {2, 2}, {1, 2}, {0, 2}, {0, 1}, {0, 0}};
+        for (int i = 0; i < 8; i++) {
+            grid[cell[i][1]][cell[i][0]] = neighborArray[i];
+        }
+    } catch (const std::exception& e) {
+        qDebug() << "HEALPix directional neighbors error:" << e.what();
+    }
     
     return grid;
 }
@@ -111,72 +116,75 @@ ProperHipsClient::ProperHipsClient(QObject *parent)
 
 void ProperHipsClient::setupSurveys() {
     // Working surveys based on your test results
-    m_surveys["DSS2_Color"] = {
+    m_surveys.add("DSS2_Color", {
         "DSS2 Color",
         "http://alasky.u-strasbg.fr/DSS/DSSColor",
         "jpg",
         "Digital Sky Survey 2 Color - proven 100% success",
         true, 11, {"full_sky"}
-    };
+    });
 /*
-    m_surveys["2MASS_Color"] = {
+    m_surveys.add("2MASS_Color", {
         "2MASS Color",
         "http://alasky.u-strasbg.fr/2MASS/Color", 
         "jpg",
         "2MASS near-infrared color - proven 100% success",
         true, 9, {"full_sky"}
-    };
+    });
     
-    m_surveys["2MASS_J"] = {
+    m_surveys.add("2MASS_J", {
         "2MASS J-band",
         "http://alasky.u-strasbg.fr/2MASS/J",
         "jpg", 
         "2MASS J-band (1.25 micron) - proven 100% success",
         true, 9, {"full_sky"}
-    };
+    });
     
     // Test additional surveys with proper HEALPix
-    m_surveys["DSS2_Red"] = {
+    m_surveys.add("DSS2_Red", {
         "DSS2 Red",
         "http://alasky.u-strasbg.fr/DSS/DSS2-red",
         "jpg",
         "DSS2 red band",
         true, 11, {"full_sky"}
-    };
+    });
     
-    m_surveys["Gaia_DR3"] = {
+    m_surveys.add("Gaia_DR3", {
         "Gaia DR3", 
         "http://alasky.u-strasbg.fr/Gaia/Gaia-DR3",
         "png",
         "Gaia Data Release 3",
         true, 13, {"full_sky"}
-    };
+    });
     
-    m_surveys["SDSS_DR12"] = {
+    m_surveys.add("SDSS_DR12", {
         "SDSS DR12",
         "http://alasky.u-strasbg.fr/SDSS/DR12/color", 
         "jpg",
         "Sloan Digital Sky Survey DR12",
         true, 12, {"northern_sky"}
-    };
+    });
     
-    m_surveys["Mellinger_Color"] = {
+    m_surveys.add("Mellinger_Color", {
         "Mellinger Color",
         "http://alasky.u-strasbg.fr/Mellinger/Mellinger_color",
         "jpg",
         "Mellinger all-sky optical mosaic", 
         true, 8, {"full_sky"}
-    };
+    });
     
     // Rubin Observatory (may need different URL patterns)
-    m_surveys["Rubin_Virgo_Color"] = {
+    m_surveys.add("Rubin_Virgo_Color", {
         "Rubin Virgo Color",
         "https://images.rubinobservatory.org/hips/SVImages_v2/color_ugri",
         "webp",
         "Rubin Observatory Virgo Cluster",
         true, 12, {"virgo_cluster"}
-    };
+    });
  */
+    
+    // Site-specific surveys from DSS_SURVEYS add to or replace the above
+    m_surveys.loadFromEnvironment();
 }
 
 void ProperHipsClient::setupTestPositions() {
@@ -212,7 +220,7 @@ void ProperHipsClient::testPixelCalculation() {
                     .arg(order).arg(nside).arg(realPixel).arg(simplePixel).arg(realPixel - simplePixel);
         
         // Build test URLs for DSS (known working survey)
-        QString realUrl = buildDSSUrl(orion, order, "DSS2_Color");
+        QString realUrl = buildTileUrl("DSS2_Color", orion, order);
         qDebug() << "  Real HEALPix URL:" << realUrl;
     }
     
@@ -248,75 +256,14 @@ QList<long long> ProperHipsClient::calculateTileGrid(const SkyPosition& center,
     return pixels;
 }
 
-QString ProperHipsClient::buildDSSUrl(const SkyPosition& position, int order, const QString& survey) const {
-    const HipsSurveyInfo& info = m_surveys[survey];
-    long long pixel = calculateHealPixel(position, order);
-    
-    if (pixel < 0) return QString();
-    
-    // Standard HiPS URL format for DSS
-    int dir = (pixel / 10000) * 10000;
-    return QString("%1/Norder%2/Dir%3/Npix%4.%5")
-           .arg(info.baseUrl)
-           .arg(order)
-           .arg(dir) 
-           .arg(pixel)
-           .arg(info.format);
-}
-
-QString ProperHipsClient::build2MASSUrl(const SkyPosition& position, int order, const QString& survey) const {
-    // 2MASS uses same format as DSS
-    return buildDSSUrl(position, order, survey);
-}
-
-QString ProperHipsClient::buildRubinUrl(const SkyPosition& position, int order, const QString& survey) const {
-    const HipsSurveyInfo& info = m_surveys[survey];
-    long long pixel = calculateHealPixel(position, order);
-    
-    if (pixel < 0) return QString();
-    
-    // Rubin may use different directory structure
-    int dir = (pixel / 10000) * 10000;
-    return QString("%1/Norder%2/Dir%3/Npix%4.%5")
-           .arg(info.baseUrl)
-           .arg(order)
-           .arg(dir)
-           .arg(pixel) 
-           .arg(info.format);
-}
-
-QString ProperHipsClient::buildGenericHipsUrl(const QString& baseUrl, const QString& format,
-                                              const SkyPosition& position, int order) const {
-    long long pixel = calculateHealPixel(position, order);
-    
-    if (pixel < 0) return QString();
-    
-    int dir = (pixel / 10000) * 10000;
-    return QString("%1/Norder%2/Dir%3/Npix%4.%5")
-           .arg(baseUrl)
-           .arg(order)
-           .arg(dir)
-           .arg(pixel)
-           .arg(format);
-}
-
 QString ProperHipsClient::buildTileUrl(const QString& surveyName, const SkyPosition& position, int order) const {
-    if (!m_surveys.contains(surveyName)) {
+    SurveyId id = m_surveys.id(surveyName);
+    if (id == SurveyRegistry::kInvalid) {
         return QString();
     }
     
-    const HipsSurveyInfo& survey = m_surveys[surveyName];
-    
-    // Use appropriate URL builder based on survey type
-    if (surveyName.startsWith("DSS") || surveyName.contains("Mellinger")) {
-        return buildDSSUrl(position, order, surveyName);
-    } else if (surveyName.startsWith("2MASS")) {
-        return build2MASSUrl(position, order, surveyName); 
-    } else if (surveyName.startsWith("Rubin")) {
-        return buildRubinUrl(position, order, surveyName);
-    } else {
-        return buildGenericHipsUrl(survey.baseUrl, survey.format, position, order);
-    }
+    long long pixel = calculateHealPixel(position, order);
+    return m_surveys.tileUrl(id, order, pixel);
 }
 
 void ProperHipsClient::testAllSurveys() {
@@ -332,7 +279,7 @@ void ProperHipsClient::testAllSurveys() {
 }
 
 void ProperHipsClient::startNextTest() {
-    if (m_currentSurveyIndex >= m_surveys.keys().size()) {
+    if (m_currentSurveyIndex >= m_surveys.size()) {
         finishTesting();
         return;
     }
@@ -15,16 +15,8 @@
 // Real HEALPix includes
 #include "healpix_base.h"
 #include "pointing.h"
-
-struct HipsSurveyInfo {
-    QString name;
-    QString baseUrl;
-    QString format;
-    QString description;
-    bool available;
-    int maxOrder;
-    QStringList regions;
-};
+#include "SkyTypes.h"
+#include "SurveyRegistry.h"
 
 struct SkyPosition {
     double ra_deg;
@@ -32,12 +24,11 @@ struct SkyPosition {
     QString name;
     QString description;
     
+    // Coordinates without the name, for per-tile math
+    SkyCoord coord() const { return SkyCoord::fromRaDec(ra_deg, dec_deg); }
+    
     // Convert to HEALPix pointing
-    pointing toPointing() const {
-        double theta = (90.0 - dec_deg) * M_PI / 180.0;  // colatitude
-        double phi = ra_deg * M_PI / 180.0;              // longitude
-        return pointing(theta, phi);
-    }
+    pointing toPointing() const { return coord().toPointing(); }
 };
 
 struct TileResult {
@@ -68,6 +59,7 @@ public:
     QStringList getWorkingSurveys() const;
     QString getBestSurveyForPosition(const SkyPosition& position) const;
     QString buildTileUrl(const QString& surveyName, const SkyPosition& position, int order = 6) const;
+    const SurveyRegistry& surveys() const { return m_surveys; }
     
     // Results access
     QList<TileResult> getResults() const { return m_results; }
@@ -77,7 +69,7 @@ public:
     long long calculateHealPixel(const SkyPosition& position, int order) const;
     QList<long long> getNeighboringPixels(long long centerPixel, int order) const;
     QMap<QString, long long> getDirectionalNeighbors(long long centerPixel, int order) const;
-    QList<QList<long long>> createProper3x3Grid(long long centerPixel, int order) const;
+    TileGrid createProper3x3Grid(long long centerPixel, int order) const;
     void verifyGridAlignment(long long centerPixel, int order) const;
 										 
 private slots:
@@ -88,7 +80,7 @@ signals:
 
 private:
     QNetworkAccessManager* m_networkManager;
-    QMap<QString, HipsSurveyInfo> m_surveys;
+    SurveyRegistry m_surveys;
     QList<SkyPosition> m_testPositions;
     QList<TileResult> m_results;
     QTimer* m_testTimer;
@@ -107,13 +99,6 @@ private:
     // HEALPix utilities
     long long calculateSimplePixel(double ra_deg, double dec_deg, int order) const; // For comparison
     QList<long long> calculateTileGrid(const SkyPosition& center, int order, int gridSize = 4) const;
-    
-    // URL building for different survey types
-    QString buildDSSUrl(const SkyPosition& position, int order, const QString& survey) const;
-    QString build2MASSUrl(const SkyPosition& position, int order, const QString& survey) const;
-    QString buildRubinUrl(const SkyPosition& position, int order, const QString& survey) const;
-    QString buildGenericHipsUrl(const QString& baseUrl, const QString& format, 
-                               const SkyPosition& position, int order) const;
 };
 
 #endif // PROPERHIPSCLIENT_H
@@ -0,0 +1,187 @@
+// RenderCache.h - Rendered-output cache keyed by every render input
+// A RenderKey collects the parameters that determine an output (target,
+// FOV, survey, sensor, code version) plus the size and mtime of each input
+// file; its SHA-256 names the cached file. Changing any input changes the
+// key, so stale entries are never served - they just age out by LRU.
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QImage>
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <map>
+
+class RenderKey {
+public:
+    explicit RenderKey(const QString& output = QString()) {
+        if (!output.isEmpty()) add("output", output);
+    }
+
+    // Fields are kept sorted, so insertion order never changes the hash
+    RenderKey& add(const QString& name, const QString& value) {
+        m_fields[name] = value;
+        return *this;
+    }
+    RenderKey& add(const QString& name, const char* value) { return add(name, QString(value)); }
+    RenderKey& add(const QString& name, qint64 value) { return add(name, QString::number(value)); }
+    RenderKey& add(const QString& name, int value) { return add(name, QString::number(value)); }
+    RenderKey& add(const QString& name, double value) { return add(name, QString::number(value, 'g', 17)); }
+
+    // An input file's version is its size and mtime; a missing file makes
+    // the key invalid, since the output could not be reproduced from it
+    RenderKey& addFile(const QString& name, const QString& path) {
+        QFileInfo info(path);
+        if (!info.exists()) {
+            m_valid = false;
+            return *this;
+        }
+        return add(name, QString("%1@%2").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch()));
+    }
+
+    void invalidate() { m_valid = false; }
+    bool isValid() const { return m_valid && !m_fields.empty(); }
+
+    QString canonical() const {
+        QString text;
+        for (const auto& field : m_fields) {
+            text += field.first + "=" + field.second + "\n";
+        }
+        return text;
+    }
+
+    QString hash() const {
+        return QString::fromLatin1(
+            QCryptographicHash::hash(canonical().toUtf8(), QCryptographicHash::Sha256).toHex());
+    }
+
+private:
+    std::map<QString, QString> m_fields;
+    bool m_valid = true;
+};
+
+// Entries are files named <hash>.<suffix> in one directory, written via
+// QSaveFile so a crashed writer never leaves a truncated hit behind.
+// Safe to share between the event loop and pipeline workers.
+class RenderCache {
+public:
+    explicit RenderCache(const QString& directory, qint64 maxBytes = 1024LL * 1024 * 1024,
+                         const QString& suffix = "png")
+        : m_directory(directory), m_suffix(suffix), m_maxBytes(maxBytes) {
+        QDir().mkpath(m_directory);
+        QMutexLocker locker(&m_mutex);
+        pruneLocked();
+    }
+
+    QString pathFor(const RenderKey& key) const {
+        return QString("%1/%2.%3").arg(m_directory).arg(key.hash()).arg(m_suffix);
+    }
+
+    // Path of the cached output, or empty on a miss. Hits are touched so
+    // pruning drops the least recently used entries first.
+    QString lookup(const RenderKey& key) {
+        if (!key.isValid()) {
+            m_misses++;
+            return QString();
+        }
+        QString path = pathFor(key);
+        QFile file(path);
+        if (!file.exists()) {
+            m_misses++;
+            return QString();
+        }
+        if (file.open(QIODevice::ReadWrite)) {
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+        m_hits++;
+        return path;
+    }
+
+    QByteArray lookupData(const RenderKey& key) {
+        QString path = lookup(key);
+        if (path.isEmpty()) return QByteArray();
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+    QImage lookupImage(const RenderKey& key) {
+        QString path = lookup(key);
+        return path.isEmpty() ? QImage() : QImage(path);
+    }
+
+    bool store(const RenderKey& key, const QByteArray& data) {
+        if (!key.isValid() || data.isEmpty()) return false;
+        QSaveFile file(pathFor(key));
+        if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+            qDebug() << "Failed to store render cache entry:" << file.fileName();
+            return false;
+        }
+        if (m_bytes.fetch_add(data.size()) + data.size() > m_maxBytes) {
+            QMutexLocker locker(&m_mutex);
+            pruneLocked();
+        }
+        return true;
+    }
+
+    bool storeImage(const RenderKey& key, const QImage& image) {
+        if (!key.isValid() || image.isNull()) return false;
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        if (!image.save(&buffer, m_suffix.toUpper().toLatin1().constData())) return false;
+        return store(key, data);
+    }
+
+    // Cache an output already written elsewhere without re-encoding it
+    bool storeFile(const RenderKey& key, const QString& path) {
+        QFile file(path);
+        if (!key.isValid() || !file.open(QIODevice::ReadOnly)) return false;
+        return store(key, file.readAll());
+    }
+
+    void printStats() const {
+        qint64 hits = m_hits.load(), misses = m_misses.load();
+        qDebug() << QString("Render cache: %1 hits, %2 misses, %3 MB in %4")
+                    .arg(hits).arg(misses)
+                    .arg(m_bytes.load() / (1024.0 * 1024.0), 0, 'f', 1)
+                    .arg(m_directory);
+    }
+
+private:
+    QString m_directory;
+    QString m_suffix;
+    qint64 m_maxBytes;
+    std::atomic<qint64> m_bytes{0};
+    std::atomic<qint64> m_hits{0};
+    std::atomic<qint64> m_misses{0};
+    QMutex m_mutex;
+
+    // Recount from disk and drop least recently used entries over the cap
+    void pruneLocked() {
+        QFileInfoList entries = QDir(m_directory).entryInfoList(
+            QStringList() << QString("*.%1").arg(m_suffix), QDir::Files, QDir::Time);
+        qint64 total = 0;
+        for (const QFileInfo& entry : entries) total += entry.size();
+
+        // Newest first, so evict from the back
+        while (total > m_maxBytes && !entries.isEmpty()) {
+            QFileInfo oldest = entries.takeLast();
+            if (QFile::remove(oldest.absoluteFilePath())) total -= oldest.size();
+        }
+        m_bytes = total;
+    }
+};
+
+#endif // RENDERCACHE_H
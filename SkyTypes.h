@@ -0,0 +1,84 @@
+// SkyTypes.h - Plain value types for sky coordinates, tiles and tile grids
+// Trivially copyable, so per-tile work (grid planning, distances, cache
+// keys) never allocates or touches QString. Names and descriptions live
+// with the objects that own them, e.g. SkyPosition or MessierObject.
+#ifndef SKYTYPES_H
+#define SKYTYPES_H
+
+#include <QtGlobal>
+#include <QHash>
+#include <cmath>
+#include <type_traits>
+#include "pointing.h"
+
+// Direction on the sky as both a unit vector and RA/Dec in degrees
+struct SkyCoord {
+    double x, y, z;
+    double ra_deg;
+    double dec_deg;
+
+    static SkyCoord fromRaDec(double ra_deg, double dec_deg) {
+        double ra = ra_deg * M_PI / 180.0;
+        double dec = dec_deg * M_PI / 180.0;
+        double c = std::cos(dec);
+        return SkyCoord{c * std::cos(ra), c * std::sin(ra), std::sin(dec), ra_deg, dec_deg};
+    }
+
+    static SkyCoord fromPointing(const pointing& pt) {
+        return fromRaDec(pt.phi * 180.0 / M_PI, 90.0 - pt.theta * 180.0 / M_PI);
+    }
+
+    // Convert to HEALPix pointing
+    pointing toPointing() const {
+        return pointing((90.0 - dec_deg) * M_PI / 180.0, ra_deg * M_PI / 180.0);
+    }
+
+    // Angular separation in radians; atan2 of cross and dot products stays
+    // accurate at arcsecond separations where acos loses precision
+    double distanceTo(const SkyCoord& other) const {
+        double cx = y * other.z - z * other.y;
+        double cy = z * other.x - x * other.z;
+        double cz = x * other.y - y * other.x;
+        double dot = x * other.x + y * other.y + z * other.z;
+        return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot);
+    }
+};
+
+// One HiPS tile: survey id (index into the client's survey table), order, pixel
+struct TileKey {
+    qint64 pixel;
+    quint16 survey;
+    quint8 order;
+
+    bool isValid() const { return pixel >= 0; }
+    bool operator==(const TileKey& other) const {
+        return pixel == other.pixel && survey == other.survey && order == other.order;
+    }
+    bool operator!=(const TileKey& other) const { return !(*this == other); }
+};
+
+inline uint qHash(const TileKey& key, uint seed = 0) {
+    return qHash(quint64(key.pixel) ^ (quint64(key.survey) << 40) ^ (quint64(key.order) << 58), seed);
+}
+
+// 3x3 neighbourhood of an order; row 0 is the southern row (SW, S, SE),
+// row 2 the northern one. Missing neighbours are -1.
+struct TileGrid {
+    static constexpr int kSize = 3;
+    int order;
+    qint64 pixels[kSize][kSize];
+
+    const qint64* operator[](int row) const { return pixels[row]; }
+    qint64* operator[](int row) { return pixels[row]; }
+    qint64 center() const { return pixels[1][1]; }
+
+    TileKey key(int x, int y, quint16 survey = 0) const {
+        return TileKey{pixels[y][x], survey, quint8(order)};
+    }
+};
+
+static_assert(std::is_trivially_copyable<SkyCoord>::value, "SkyCoord must stay a plain value");
+static_assert(std::is_trivially_copyable<TileKey>::value, "TileKey must stay a plain value");
+static_assert(std::is_trivially_copyable<TileGrid>::value, "TileGrid must stay a plain value");
+
+#endif // SKYTYPES_H
@@ -0,0 +1,196 @@
+// Snapshot.h - Versioned, memory-mapped snapshots of in-memory indices
+// A snapshot is one file of named sections written atomically. Readers
+// map it and get zero-copy views of each section: MOC range arrays are
+// copied out with one memcpy and other indices decode from memory instead
+// of being rebuilt from JSON or directory scans.
+//
+// Each snapshot carries a stamp of the data it was taken from (e.g. the
+// size and mtime of metadata.json); a snapshot with another format
+// version or stamp is ignored and the owner falls back to a full load.
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QDebug>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "Moc.h"
+
+namespace SnapshotFormat {
+    static constexpr char kMagic[8] = {'D', 'S', 'S', 'S', 'N', 'A', 'P', '\0'};
+    static constexpr int kNameBytes = 48;
+
+    struct Header {
+        char magic[8];
+        quint32 version;        // Owner's layout version
+        quint32 sections;
+    };
+
+    struct Section {
+        char name[kNameBytes];
+        quint64 offset;         // From file start, 8-byte aligned
+        quint64 size;
+    };
+
+    inline QDataStream::Version streamVersion() { return QDataStream::Qt_5_12; }
+}
+
+class SnapshotWriter {
+public:
+    SnapshotWriter(quint32 version, const QByteArray& stamp) : m_version(version) {
+        add("stamp", stamp);
+    }
+
+    void add(const QString& name, const QByteArray& data) {
+        m_sections.push_back({name, data});
+    }
+
+    void addMoc(const QString& name, const Moc& moc) {
+        const std::vector<Moc::Range>& ranges = moc.ranges();
+        add(name, QByteArray(reinterpret_cast<const char*>(ranges.data()),
+                             int(ranges.size() * sizeof(Moc::Range))));
+    }
+
+    template <typename T>
+    void addStream(const QString& name, const T& value) {
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(SnapshotFormat::streamVersion());
+        stream << value;
+        add(name, data);
+    }
+
+    bool write(const QString& path) const {
+        using namespace SnapshotFormat;
+        QByteArray table(int(m_sections.size() * sizeof(Section)), '\0');
+        quint64 offset = align(sizeof(Header) + table.size());
+        for (size_t i = 0; i < m_sections.size(); ++i) {
+            Section section{};
+            QByteArray name = m_sections[i].first.toUtf8().left(kNameBytes - 1);
+            std::memcpy(section.name, name.constData(), name.size());
+            section.offset = offset;
+            section.size = quint64(m_sections[i].second.size());
+            std::memcpy(table.data() + i * sizeof(Section), &section, sizeof(Section));
+            offset = align(offset + section.size);
+        }
+
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = m_version;
+        header.sections = quint32(m_sections.size());
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(table);
+        for (const auto& section : m_sections) {
+            pad(file);
+            file.write(section.second);
+        }
+        if (!file.commit()) {
+            qDebug() << "Failed to write snapshot:" << path;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    quint32 m_version;
+    std::vector<std::pair<QString, QByteArray>> m_sections;
+
+    static quint64 align(quint64 offset) { return (offset + 7) & ~quint64(7); }
+
+    static void pad(QSaveFile& file) {
+        static const char zeros[8] = {};
+        qint64 at = file.pos();
+        if (at % 8) file.write(zeros, 8 - at % 8);
+    }
+};
+
+class Snapshot {
+public:
+    // Version and stamp describing the data; see fileStamp()
+    Snapshot(const QString& path, quint32 version, const QByteArray& stamp) : m_file(path) {
+        using namespace SnapshotFormat;
+        if (!m_file.open(QIODevice::ReadOnly) || m_file.size() < qint64(sizeof(Header))) return;
+        m_size = m_file.size();
+        m_base = m_file.map(0, m_size);
+        if (!m_base) return;
+
+        const Header* header = reinterpret_cast<const Header*>(m_base);
+        if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != version) return;
+        if (sizeof(Header) + quint64(header->sections) * sizeof(Section) > quint64(m_size)) return;
+        m_table = reinterpret_cast<const Section*>(m_base + sizeof(Header));
+        m_count = int(header->sections);
+        for (int i = 0; i < m_count; ++i) {
+            if (m_table[i].offset + m_table[i].size > quint64(m_size)) {
+                m_count = 0;
+                return;
+            }
+        }
+        m_valid = !stamp.isEmpty() && section("stamp") == stamp;
+    }
+
+    bool isValid() const { return m_valid; }
+
+    // Zero-copy view, valid while this Snapshot lives; empty if absent
+    QByteArray section(const QString& name) const {
+        QByteArray wanted = name.toUtf8();
+        for (int i = 0; i < m_count; ++i) {
+            const SnapshotFormat::Section& entry = m_table[i];
+            if (qstrncmp(entry.name, wanted.constData(), SnapshotFormat::kNameBytes) == 0) {
+                return QByteArray::fromRawData(reinterpret_cast<const char*>(m_base + entry.offset),
+                                               int(entry.size));
+            }
+        }
+        return QByteArray();
+    }
+
+    QStringList sectionNames() const {
+        QStringList names;
+        for (int i = 0; i < m_count; ++i) names << QString::fromUtf8(m_table[i].name);
+        return names;
+    }
+
+    bool readMoc(const QString& name, Moc& moc) const {
+        QByteArray data = section(name);
+        if (data.size() % int(sizeof(Moc::Range)) != 0) return false;
+        moc = Moc::fromRanges(reinterpret_cast<const Moc::Range*>(data.constData()),
+                              size_t(data.size()) / sizeof(Moc::Range));
+        return true;
+    }
+
+    template <typename T>
+    bool readStream(const QString& name, T& value) const {
+        QByteArray data = section(name);
+        QDataStream stream(data);
+        stream.setVersion(SnapshotFormat::streamVersion());
+        stream >> value;
+        return stream.status() == QDataStream::Ok;
+    }
+
+    // Stamp for a file or directory the snapshot was derived from
+    static QByteArray fileStamp(const QString& path) {
+        QFileInfo info(path);
+        if (!info.exists()) return "missing";
+        return QString("%1@%2").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch()).toLatin1();
+    }
+
+private:
+    QFile m_file;
+    const uchar* m_base = nullptr;
+    qint64 m_size = 0;
+    const SnapshotFormat::Section* m_table = nullptr;
+    int m_count = 0;
+    bool m_valid = false;
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,258 @@
+// SurveyRegistry.h - HiPS surveys by integer handle with compiled tile URLs
+// Each survey carries its own tile width, format and max order, taken from
+// a built-in default, a JSON config (DSS_SURVEYS) or a HiPS `properties`
+// file. Its URL template is split once into literals and fields, so a tile
+// URL is written into a fixed buffer with integer formatting only and
+// copied out once.
+//
+// DSS_SURVEYS names a JSON array of surveys:
+//   [{"key": "DSS2_Red", "url": "http://alasky.u-strasbg.fr/DSS/DSS2-red",
+//     "format": "jpg", "maxOrder": 11, "tileWidth": 512,
+//     "properties": "dss2red.properties",
+//     "template": "{base}/Norder{order}/Dir{dir}/Npix{pixel}.{format}"}]
+// Fields missing from an entry come from its properties file, then defaults.
+#ifndef SURVEYREGISTRY_H
+#define SURVEYREGISTRY_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using SurveyId = quint16;       // TileKey::survey
+
+struct HipsSurveyInfo {
+    QString name;
+    QString baseUrl;
+    QString format;
+    QString description;
+    bool available;
+    int maxOrder;
+    QStringList regions;
+    int tileWidth = 512;
+};
+
+class SurveyRegistry {
+public:
+    static constexpr SurveyId kInvalid = 0xffff;
+    static constexpr int kMaxUrl = 512;
+    static constexpr const char* kDefaultTemplate = "{base}/Norder{order}/Dir{dir}/Npix{pixel}.{format}";
+
+    // Add or replace a survey; returns its handle
+    SurveyId add(const QString& key, const HipsSurveyInfo& info,
+                 const QString& urlTemplate = kDefaultTemplate) {
+        auto it = m_ids.constFind(key);
+        SurveyId id = it != m_ids.constEnd() ? *it : SurveyId(m_surveys.size());
+        if (size_t(id) == m_surveys.size()) {
+            if (id == kInvalid) return kInvalid;
+            m_surveys.emplace_back();
+            m_ids.insert(key, id);
+        }
+        Survey& survey = m_surveys[id];
+        survey.key = key;
+        survey.info = info;
+        survey.segments = compile(urlTemplate, info);
+        QByteArray source = (urlTemplate + '|' + info.baseUrl + '|' + info.format).toUtf8();
+        survey.cacheName = key + "-" + QString::fromLatin1(
+            QCryptographicHash::hash(source, QCryptographicHash::Sha1).toHex().left(8));
+        return id;
+    }
+
+    // Surveys from the JSON file named by DSS_SURVEYS, if set
+    int loadFromEnvironment() {
+        const char* path = std::getenv("DSS_SURVEYS");
+        return path ? loadConfig(QString::fromLocal8Bit(path)) : 0;
+    }
+
+    // Surveys from a JSON config; relative properties paths are resolved
+    // against the config's directory. Returns the number loaded.
+    int loadConfig(const QString& path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qDebug() << "Survey config unavailable:" << path;
+            return 0;
+        }
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+        if (!doc.isArray()) {
+            qDebug() << "Survey config is not a JSON array:" << path << error.errorString();
+            return 0;
+        }
+
+        QDir base = QFileInfo(path).absoluteDir();
+        int loaded = 0;
+        for (const QJsonValue& value : doc.array()) {
+            QJsonObject entry = value.toObject();
+            QString key = entry["key"].toString();
+            if (key.isEmpty()) continue;
+
+            HipsSurveyInfo info = defaults(key);
+            if (entry.contains("properties")) {
+                QFile properties(base.absoluteFilePath(entry["properties"].toString()));
+                if (properties.open(QIODevice::ReadOnly)) applyProperties(info, properties.readAll());
+            }
+            info.name = entry["name"].toString(info.name);
+            info.baseUrl = entry["url"].toString(info.baseUrl);
+            info.format = entry["format"].toString(info.format);
+            info.description = entry["description"].toString(info.description);
+            info.available = entry["available"].toBool(info.available);
+            info.maxOrder = entry["maxOrder"].toInt(info.maxOrder);
+            info.tileWidth = entry["tileWidth"].toInt(info.tileWidth);
+            if (info.baseUrl.isEmpty()) {
+                qDebug() << "Survey" << key << "has no URL, skipped";
+                continue;
+            }
+            if (add(key, info, entry["template"].toString(kDefaultTemplate)) != kInvalid) loaded++;
+        }
+        qDebug() << QString("Loaded %1 surveys from %2").arg(loaded).arg(path);
+        return loaded;
+    }
+
+    SurveyId id(const QString& key) const { return m_ids.value(key, kInvalid); }
+    bool contains(const QString& key) const { return m_ids.contains(key); }
+    int size() const { return int(m_surveys.size()); }
+
+    // Keys in handle order
+    QStringList keys() const {
+        QStringList keys;
+        for (const Survey& survey : m_surveys) keys << survey.key;
+        return keys;
+    }
+
+    const QString& key(SurveyId id) const { return m_surveys[id].key; }
+    const HipsSurveyInfo& info(SurveyId id) const { return m_surveys[id].info; }
+
+    // Key plus a digest of the URL template, base URL and format, e.g.
+    // "DSS2_Color-1a2b3c4d": names the survey's tiles in caches, so a key
+    // redefined with another source never reads the old source's tiles
+    const QString& cacheName(SurveyId id) const { return m_surveys[id].cacheName; }
+
+    // Tile URL for QNetworkRequest and logging; empty if the handle, order
+    // or pixel is invalid or the URL does not fit
+    QString tileUrl(SurveyId id, int order, qint64 pixel) const {
+        TileUrl url;
+        return writeTileUrl(id, order, pixel, url) ? url.toString() : QString();
+    }
+
+private:
+    enum class Field { Literal, Order, Dir, Pixel };
+
+    struct Segment {
+        Field field;
+        QByteArray literal;
+    };
+
+    struct Survey {
+        QString key;
+        QString cacheName;
+        HipsSurveyInfo info;
+        std::vector<Segment> segments;
+    };
+
+    // Fixed-size URL; data is NUL-terminated
+    struct TileUrl {
+        char data[kMaxUrl];
+        int size = 0;
+        QString toString() const { return QString::fromLatin1(data, size); }
+    };
+
+    std::vector<Survey> m_surveys;
+    QHash<QString, SurveyId> m_ids;
+
+    // Integer formatting into `out` only; false on an invalid handle,
+    // order or pixel, or a URL that does not fit
+    bool writeTileUrl(SurveyId id, int order, qint64 pixel, TileUrl& out) const {
+        out.size = 0;
+        if (size_t(id) >= m_surveys.size() || pixel < 0) return false;
+        const Survey& survey = m_surveys[id];
+        if (order < 0 || order > survey.info.maxOrder) return false;
+
+        char* at = out.data;
+        char* end = out.data + kMaxUrl - 1;
+        for (const Segment& segment : survey.segments) {
+            if (segment.field == Field::Literal) {
+                if (end - at < segment.literal.size()) return false;
+                std::memcpy(at, segment.literal.constData(), size_t(segment.literal.size()));
+                at += segment.literal.size();
+                continue;
+            }
+            qint64 number = segment.field == Field::Order ? order
+                          : segment.field == Field::Dir ? (pixel / 10000) * 10000
+                          : pixel;
+            std::to_chars_result result = std::to_chars(at, end, number);
+            if (result.ec != std::errc()) return false;
+            at = result.ptr;
+        }
+        *at = '\0';
+        out.size = int(at - out.data);
+        return true;
+    }
+
+    static HipsSurveyInfo defaults(const QString& key) {
+        return HipsSurveyInfo{key, QString(), "jpg", QString(), true, 11, {"full_sky"}, 512};
+    }
+
+    // {base} and {format} are fixed per survey and folded into literals;
+    // {order}, {dir} and {pixel} stay fields
+    static std::vector<Segment> compile(const QString& urlTemplate, const HipsSurveyInfo& info) {
+        QString text = urlTemplate;
+        text.replace("{base}", info.baseUrl).replace("{format}", info.format);
+        QByteArray bytes = text.toUtf8();
+
+        std::vector<Segment> segments;
+        QByteArray literal;
+        int i = 0;
+        while (i < bytes.size()) {
+            Field field = Field::Literal;
+            int length = 0;
+            if (bytes.mid(i, 7) == "{order}") { field = Field::Order; length = 7; }
+            else if (bytes.mid(i, 5) == "{dir}") { field = Field::Dir; length = 5; }
+            else if (bytes.mid(i, 7) == "{pixel}") { field = Field::Pixel; length = 7; }
+            if (field == Field::Literal) {
+                literal += bytes[i++];
+                continue;
+            }
+            if (!literal.isEmpty()) segments.push_back({Field::Literal, literal});
+            literal.clear();
+            segments.push_back({field, QByteArray()});
+            i += length;
+        }
+        if (!literal.isEmpty()) segments.push_back({Field::Literal, literal});
+        return segments;
+    }
+
+    // key = value lines; the first listed tile format is used
+    static void applyProperties(HipsSurveyInfo& info, const QByteArray& properties) {
+        for (const QByteArray& raw : properties.split('\n')) {
+            QByteArray line = raw.trimmed();
+            int eq = line.indexOf('=');
+            if (line.isEmpty() || line.startsWith('#') || eq < 0) continue;
+            QByteArray name = line.left(eq).trimmed();
+            QString value = QString::fromUtf8(line.mid(eq + 1).trimmed());
+
+            if (name == "obs_title") info.name = value;
+            else if (name == "obs_description") info.description = value;
+            else if (name == "hips_order") info.maxOrder = value.toInt();
+            else if (name == "hips_tile_width") info.tileWidth = value.toInt();
+            else if (name == "hips_service_url" && info.baseUrl.isEmpty()) info.baseUrl = value;
+            else if (name == "hips_tile_format") {
+                QString format = value.section(' ', 0, 0, QString::SectionSkipEmpty);
+                info.format = format == "jpeg" ? "jpg" : format;
+            }
+        }
+    }
+};
+
+#endif // SURVEYREGISTRY_H
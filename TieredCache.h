@@ -0,0 +1,564 @@
+// TieredCache.h - Read-through cache over RAM, local disk and shared tiers
+// Tiers are ordered fastest first. A hit in a slower tier is promoted into
+// every faster private tier, so hot data ends up in RAM and on local NVMe.
+// New data goes into RAM at once; local directory writes are batched
+// behind the caller through BatchIO and served from memory until they
+// land, and shared tiers (e.g. a team NFS archive) are written back on a
+// background thread. Each tier with a capacity evicts least recently used
+// entries down to 90%.
+//
+// standardTiers() reads the hierarchy from the environment:
+//   DSS_CACHE_RAM_MB      RAM tier size (default 64, 0 disables it)
+//   DSS_CACHE_LOCAL_GB    Local directory capacity (default 0 = unbounded)
+//   DSS_CACHE_SHARED      Shared cache roots, ';'-separated, fastest first
+//   DSS_CACHE_SHARED_GB   Shared tier capacity (default 0 = never evict)
+#ifndef TIEREDCACHE_H
+#define TIEREDCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QThreadPool>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "MemoryBudget.h"
+#include "BatchIO.h"
+
+struct CacheTier {
+    enum Kind { Memory, Disk, Shared };
+    Kind kind = Disk;
+    QString path;           // Directory for Disk and Shared tiers
+    qint64 capacity = 0;    // Bytes; 0 = unbounded, never evicted
+
+    QString label() const {
+        switch (kind) {
+            case Memory: return "ram";
+            case Disk:   return "local " + path;
+            default:     return "shared " + path;
+        }
+    }
+};
+
+class TieredCache {
+public:
+    struct TierStats {
+        QString label;
+        int entries;            // -1 when the tier is not indexed
+        qint64 bytes;
+        qint64 capacity;
+        qint64 hits;
+    };
+
+    // nameFilters select the files a directory tier owns, so a tier can
+    // share its directory with other outputs without evicting them
+    explicit TieredCache(const QList<CacheTier>& tiers,
+                         const QStringList& nameFilters = QStringList())
+        : m_nameFilters(nameFilters) {
+        m_writeBack.setMaxThreadCount(1);
+        m_writeBehind.setMaxThreadCount(1);
+        for (const CacheTier& config : tiers) {
+            auto tier = std::make_unique<Tier>();
+            tier->config = config;
+            if (config.kind != CacheTier::Memory) {
+                QDir().mkpath(config.path);
+                if (config.capacity > 0) scan(*tier);
+            }
+            m_tiers.push_back(std::move(tier));
+        }
+    }
+
+    ~TieredCache() {
+        flush();
+    }
+
+    // RAM, then `localDir`, then `<shared root>/<sharedName>` for each
+    // configured shared root
+    static QList<CacheTier> standardTiers(const QString& localDir, const QString& sharedName) {
+        QList<CacheTier> tiers;
+        qint64 ramMB = envNumber("DSS_CACHE_RAM_MB", 64);
+        if (ramMB > 0) {
+            CacheTier ram;
+            ram.kind = CacheTier::Memory;
+            ram.capacity = ramMB * 1024 * 1024;
+            tiers << ram;
+        }
+
+        CacheTier local;
+        local.path = localDir;
+        local.capacity = envNumber("DSS_CACHE_LOCAL_GB", 0) * 1024 * 1024 * 1024;
+        tiers << local;
+
+        const char* shared = std::getenv("DSS_CACHE_SHARED");
+        qint64 sharedCapacity = envNumber("DSS_CACHE_SHARED_GB", 0) * 1024 * 1024 * 1024;
+        if (shared) {
+            for (const QString& root : QString::fromLocal8Bit(shared).split(';', Qt::SkipEmptyParts)) {
+                CacheTier tier;
+                tier.kind = CacheTier::Shared;
+                tier.path = QDir(root.trimmed()).filePath(sharedName);
+                tier.capacity = sharedCapacity;
+                tiers << tier;
+            }
+        }
+        return tiers;
+    }
+
+    // Fastest copy of `key`, promoted into the faster private tiers;
+    // empty if no tier has it
+    QByteArray get(const QString& key) {
+        for (size_t i = 0; i < m_tiers.size(); ++i) {
+            Tier& tier = *m_tiers[i];
+            QByteArray data = read(tier, key);
+            if (data.isEmpty()) continue;
+
+            promote(i, key, data);
+            return data;
+        }
+        return QByteArray();
+    }
+
+    // get() for many keys, reading each directory tier's misses as one
+    // batch; entries are empty where no tier has the key
+    QList<QByteArray> getMany(const QStringList& keys) {
+        QList<QByteArray> result;
+        QList<int> missing;
+        for (int k = 0; k < keys.size(); ++k) {
+            result << QByteArray();
+            missing << k;
+        }
+        for (size_t i = 0; i < m_tiers.size() && !missing.isEmpty(); ++i) {
+            QList<int> still = readBatch(*m_tiers[i], keys, missing, result);
+            for (int k : missing) {
+                if (!result[k].isEmpty()) promote(i, keys[k], result[k]);
+            }
+            missing = still;
+        }
+        return result;
+    }
+
+    // Warm the private tiers for `keys` ahead of use: with a RAM tier,
+    // getMany() into it; without one, only shared hits are worth a read,
+    // copied to the local tier, since local hits would be read and dropped
+    void prefetch(const QStringList& keys) {
+        if (hasTier(CacheTier::Memory)) {
+            getMany(keys);
+            return;
+        }
+        QStringList remote;
+        for (const QString& key : keys) {
+            int found = tierOf(key);
+            if (found < 0 || m_tiers[size_t(found)]->config.kind == CacheTier::Shared) remote << key;
+        }
+        getMany(remote);
+    }
+
+    // Copy of `key` in the tiers of one kind, without promotion, for data
+    // kept in a different form per tier (packed on disk, plain in RAM)
+    QByteArray peek(const QString& key, CacheTier::Kind kind) {
+        return peekMany(QStringList() << key, kind).first();
+    }
+
+    // peek() for many keys; each directory tier is read as one batch
+    QList<QByteArray> peekMany(const QStringList& keys, CacheTier::Kind kind) {
+        QList<QByteArray> result;
+        QList<int> missing;
+        for (int k = 0; k < keys.size(); ++k) {
+            result << QByteArray();
+            missing << k;
+        }
+        for (const std::unique_ptr<Tier>& tier : m_tiers) {
+            if (tier->config.kind != kind || missing.isEmpty()) continue;
+            QList<int> still = readBatch(*tier, keys, missing, result);
+            tier->hits += missing.size() - still.size();
+            missing = still;
+        }
+        return result;
+    }
+
+    bool hasTier(CacheTier::Kind kind) const {
+        for (const std::unique_ptr<Tier>& tier : m_tiers) {
+            if (tier->config.kind == kind) return true;
+        }
+        return false;
+    }
+
+    bool contains(const QString& key) const {
+        return tierOf(key) >= 0;
+    }
+
+    // Index of the fastest tier holding `key`, or -1
+    int tierOf(const QString& key) const {
+        for (size_t i = 0; i < m_tiers.size(); ++i) {
+            const Tier& tier = *m_tiers[i];
+            if (tier.config.kind == CacheTier::Memory) {
+                QMutexLocker locker(&m_mutex);
+                if (tier.memory.contains(key)) return int(i);
+            } else if (isPending(filePath(tier, key)) || QFile::exists(filePath(tier, key))) {
+                return int(i);
+            }
+        }
+        return -1;
+    }
+
+    // Store in every private tier now and queue write-back to shared
+    // tiers (unless writeBack is false); false if no private tier took it
+    bool put(const QString& key, const QByteArray& data, bool writeBack = true) {
+        if (data.isEmpty()) return false;
+        bool stored = false;
+        for (const std::unique_ptr<Tier>& tier : m_tiers) {
+            if (tier->config.kind == CacheTier::Shared) {
+                if (!writeBack) continue;
+                Tier* shared = tier.get();
+                m_writeBack.start([this, shared, key, data]() {
+                    if (!QFile::exists(filePath(*shared, key))) write(*shared, key, data);
+                });
+            } else if (write(*tier, key, data)) {
+                stored = true;
+            }
+        }
+        return stored;
+    }
+
+    // Store in the tiers of one kind only, written through at once;
+    // false if none of them took it
+    bool putTo(CacheTier::Kind kind, const QString& key, const QByteArray& data) {
+        if (data.isEmpty()) return false;
+        bool stored = false;
+        for (const std::unique_ptr<Tier>& tier : m_tiers) {
+            if (tier->config.kind == kind && write(*tier, key, data)) stored = true;
+        }
+        return stored;
+    }
+
+    // Drop `key` from the private tiers (shared copies stay for the team)
+    void remove(const QString& key) {
+        removeFrom(CacheTier::Memory, key);
+        removeFrom(CacheTier::Disk, key);
+    }
+
+    void removeFrom(CacheTier::Kind kind, const QString& key) {
+        if (kind == CacheTier::Disk) flushLocal();
+        for (const std::unique_ptr<Tier>& tier : m_tiers) {
+            if (tier->config.kind != kind) continue;
+            if (kind != CacheTier::Memory) QFile::remove(filePath(*tier, key));
+            QMutexLocker locker(&m_mutex);
+            forget(*tier, key);
+        }
+    }
+
+    void clearLocal() {
+        flushLocal();
+        for (const std::unique_ptr<Tier>& tier : m_tiers) {
+            if (tier->config.kind == CacheTier::Shared) continue;
+            if (tier->config.kind == CacheTier::Disk) {
+                QDirIterator it(tier->config.path, m_nameFilters, QDir::Files,
+                                QDirIterator::Subdirectories);
+                while (it.hasNext()) QFile::remove(it.next());
+            }
+            QMutexLocker locker(&m_mutex);
+            tier->memory.clear();
+            tier->index.clear();
+            tier->bytes = 0;
+            if (tier->config.kind == CacheTier::Memory) m_ramCharge.reset();
+        }
+    }
+
+    // Wait for queued local writes and shared write-backs to land
+    void flush() {
+        flushLocal();
+        m_writeBack.waitForDone();
+    }
+
+    // Wait for queued writes to the local directory tiers only
+    void flushLocal() {
+        m_writeBehind.waitForDone();
+    }
+
+    // Path of `key` in the first local directory tier
+    QString localPath(const QString& key) const {
+        for (const std::unique_ptr<Tier>& tier : m_tiers) {
+            if (tier->config.kind == CacheTier::Disk) return filePath(*tier, key);
+        }
+        return QString();
+    }
+
+    // Local writes that failed after put() had accepted them; those
+    // entries were dropped from the local tier (RAM keeps its copy)
+    qint64 failedWrites() const { return m_failedWrites.load(); }
+
+    QList<TierStats> stats() const {
+        QList<TierStats> result;
+        QMutexLocker locker(&m_mutex);
+        for (const std::unique_ptr<Tier>& tier : m_tiers) {
+            bool indexed = tier->config.kind == CacheTier::Memory || tier->config.capacity > 0;
+            result << TierStats{tier->config.label(), indexed ? int(tier->index.size()) : -1,
+                                tier->bytes, tier->config.capacity, tier->hits.load()};
+        }
+        return result;
+    }
+
+    void printStats() const {
+        for (const TierStats& s : stats()) {
+            QString size = s.entries < 0 ? QString("unindexed")
+                : QString("%1 entries, %2 MB").arg(s.entries).arg(s.bytes / (1024.0 * 1024.0), 0, 'f', 1);
+            QString cap = s.capacity > 0
+                ? QString("%1 MB").arg(s.capacity / (1024.0 * 1024.0), 0, 'f', 0) : QString("unbounded");
+            qDebug() << QString("  Cache tier %1: %2 of %3, %4 hits")
+                        .arg(s.label).arg(size).arg(cap).arg(s.hits);
+        }
+        if (m_failedWrites > 0) {
+            qDebug() << QString("  Cache: %1 local writes failed").arg(m_failedWrites.load());
+        }
+    }
+
+private:
+    struct Entry {
+        qint64 size;
+        qint64 lastAccess;      // msecs since epoch
+    };
+
+    struct Tier {
+        CacheTier config;
+        QHash<QString, QByteArray> memory;      // Memory tier payloads
+        QHash<QString, Entry> index;            // Memory, or bounded directory tiers
+        qint64 bytes = 0;
+        std::atomic<qint64> hits{0};
+    };
+
+    std::vector<std::unique_ptr<Tier>> m_tiers;
+    QStringList m_nameFilters;
+    QThreadPool m_writeBack;
+    QThreadPool m_writeBehind;
+    QHash<QString, QByteArray> m_pending;   // Local writes not yet on disk, by path
+    bool m_drainQueued = false;
+    std::atomic<qint64> m_failedWrites{0};
+    mutable QMutex m_mutex;
+    MemoryCharge m_ramCharge{MemoryStage::CacheRam};
+
+    static qint64 envNumber(const char* name, qint64 fallback) {
+        const char* env = std::getenv(name);
+        return env ? qint64(std::atoll(env)) : fallback;
+    }
+
+    static QString filePath(const Tier& tier, const QString& key) {
+        return tier.config.path + "/" + key;
+    }
+
+    static bool tracked(const Tier& tier) {
+        return tier.config.kind == CacheTier::Memory || tier.config.capacity > 0;
+    }
+
+    void scan(Tier& tier) {
+        QDirIterator it(tier.config.path, m_nameFilters, QDir::Files, QDirIterator::Subdirectories);
+        QDir root(tier.config.path);
+        while (it.hasNext()) {
+            it.next();
+            QFileInfo info = it.fileInfo();
+            tier.index.insert(root.relativeFilePath(info.absoluteFilePath()),
+                              Entry{info.size(), info.lastModified().toMSecsSinceEpoch()});
+            tier.bytes += info.size();
+        }
+    }
+
+    // RAM payload, a queued local write, or (if fromDisk) the file itself
+    QByteArray read(Tier& tier, const QString& key, bool fromDisk = true) {
+        QByteArray data;
+        if (tier.config.kind == CacheTier::Memory) {
+            QMutexLocker locker(&m_mutex);
+            auto it = tier.index.find(key);
+            if (it == tier.index.end()) return QByteArray();
+            it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+            return tier.memory.value(key);
+        }
+
+        if (tier.config.kind == CacheTier::Disk) {
+            QMutexLocker locker(&m_mutex);
+            data = m_pending.value(filePath(tier, key));
+        }
+        if (data.isEmpty() && fromDisk) {
+            QFile file(filePath(tier, key));
+            if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+            data = file.readAll();
+        }
+        if (!data.isEmpty()) touch(tier, key);
+        return data;
+    }
+
+    // Fill result[k] for each k in `missing` from one tier: RAM and queued
+    // writes first, then the tier's files as one batch. Returns the
+    // indices still empty.
+    QList<int> readBatch(Tier& tier, const QStringList& keys, const QList<int>& missing,
+                         QList<QByteArray>& result) {
+        QList<int> wanted;
+        QStringList paths;
+        for (int k : missing) {
+            result[k] = read(tier, keys[k], false);
+            if (result[k].isEmpty() && tier.config.kind != CacheTier::Memory) {
+                wanted << k;
+                paths << filePath(tier, keys[k]);
+            }
+        }
+        QList<QByteArray> loaded = BatchIO::readFiles(paths);
+        for (int n = 0; n < wanted.size(); ++n) {
+            result[wanted[n]] = loaded[n];
+            if (!loaded[n].isEmpty()) touch(tier, keys[wanted[n]]);
+        }
+
+        QList<int> still;
+        for (int k : missing) {
+            if (result[k].isEmpty()) still << k;
+        }
+        return still;
+    }
+
+    // Record a directory tier hit for LRU
+    void touch(Tier& tier, const QString& key) {
+        if (tier.config.kind == CacheTier::Memory || !tracked(tier)) return;
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        // Persist recency in the mtime so a rescan keeps the LRU order
+        QFile file(filePath(tier, key));
+        if (file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly)) {
+            file.setFileTime(QDateTime::fromMSecsSinceEpoch(now), QFileDevice::FileModificationTime);
+        }
+        QMutexLocker locker(&m_mutex);
+        auto it = tier.index.find(key);
+        if (it != tier.index.end()) it->lastAccess = now;
+    }
+
+    void promote(size_t found, const QString& key, const QByteArray& data) {
+        m_tiers[found]->hits++;
+        for (size_t j = 0; j < found; ++j) {
+            if (m_tiers[j]->config.kind != CacheTier::Shared) write(*m_tiers[j], key, data);
+        }
+    }
+
+    bool isPending(const QString& path) const {
+        QMutexLocker locker(&m_mutex);
+        return m_pending.contains(path);
+    }
+
+    // Write-behind for local directory tiers: one drain task at a time
+    // takes everything queued and writes it as a single batch. An entry
+    // stays pending until the bytes that were written are still current.
+    void queueWrite(const QString& path, const QByteArray& data) {
+        QMutexLocker locker(&m_mutex);
+        m_pending.insert(path, data);
+        if (m_drainQueued) return;
+        m_drainQueued = true;
+        m_writeBehind.start([this]() { drainWrites(); });
+    }
+
+    void drainWrites() {
+        QList<BatchIO::FileData> batch;
+        {
+            QMutexLocker locker(&m_mutex);
+            for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+                batch << BatchIO::FileData(it.key(), it.value());
+            }
+            m_drainQueued = false;
+        }
+        QList<bool> written = BatchIO::writeFiles(batch);
+        QList<QPair<QString, QByteArray>> lost;     // key, bytes
+        {
+            QMutexLocker locker(&m_mutex);
+            for (int i = 0; i < batch.size(); ++i) {
+                auto it = m_pending.find(batch[i].first);
+                bool current = it != m_pending.end() && it->constData() == batch[i].second.constData();
+                if (current) m_pending.erase(it);
+                if (written[i] || !current) continue;
+
+                // put() already reported success: stop claiming the entry
+                // locally and keep it readable from RAM
+                qDebug() << "Cache tier failed to write" << batch[i].first;
+                m_failedWrites++;
+                for (const std::unique_ptr<Tier>& tier : m_tiers) {
+                    QString root = tier->config.path + "/";
+                    if (tier->config.kind != CacheTier::Disk || !batch[i].first.startsWith(root)) continue;
+                    QString key = batch[i].first.mid(root.size());
+                    forget(*tier, key);
+                    lost << qMakePair(key, batch[i].second);
+                }
+            }
+        }
+        for (const auto& entry : lost) {
+            for (const std::unique_ptr<Tier>& tier : m_tiers) {
+                if (tier->config.kind == CacheTier::Memory && read(*tier, entry.first).isEmpty()) {
+                    write(*tier, entry.first, entry.second);
+                }
+            }
+        }
+    }
+
+    bool write(Tier& tier, const QString& key, const QByteArray& data) {
+        if (tier.config.capacity > 0 && data.size() > tier.config.capacity) return false;
+
+        if (tier.config.kind == CacheTier::Disk) {
+            queueWrite(filePath(tier, key), data);
+            if (!tracked(tier)) return true;
+        } else if (tier.config.kind == CacheTier::Shared) {
+            QString path = filePath(tier, key);
+            if (key.contains('/')) QDir().mkpath(QFileInfo(path).absolutePath());
+            QSaveFile file(path);
+            if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+                qDebug() << "Cache tier" << tier.config.label() << "failed to write" << key;
+                return false;
+            }
+            if (!tracked(tier)) return true;
+        }
+
+        QMutexLocker locker(&m_mutex);
+        forget(tier, key);
+        if (tier.config.kind == CacheTier::Memory) tier.memory.insert(key, data);
+        tier.index.insert(key, Entry{data.size(), QDateTime::currentMSecsSinceEpoch()});
+        tier.bytes += data.size();
+        if (tier.config.capacity > 0 && tier.bytes > tier.config.capacity) evict(tier);
+        if (tier.config.kind == CacheTier::Memory) m_ramCharge.resize(tier.bytes);
+        return true;
+    }
+
+    // Caller holds m_mutex
+    void forget(Tier& tier, const QString& key) {
+        auto it = tier.index.find(key);
+        if (it == tier.index.end()) return;
+        tier.bytes -= it->size;
+        tier.index.erase(it);
+        tier.memory.remove(key);
+        if (tier.config.kind == CacheTier::Memory) m_ramCharge.resize(tier.bytes);
+    }
+
+    // Least recently used first, down to 90% so eviction is amortised;
+    // caller holds m_mutex
+    void evict(Tier& tier) {
+        std::vector<std::pair<qint64, QString>> byAge;
+        byAge.reserve(tier.index.size());
+        for (auto it = tier.index.constBegin(); it != tier.index.constEnd(); ++it) {
+            byAge.emplace_back(it->lastAccess, it.key());
+        }
+        std::sort(byAge.begin(), byAge.end());
+
+        const qint64 target = tier.config.capacity - tier.config.capacity / 10;
+        for (const auto& victim : byAge) {
+            if (tier.bytes <= target) break;
+            if (tier.config.kind != CacheTier::Memory) {
+                m_pending.remove(filePath(tier, victim.second));
+                QFile::remove(filePath(tier, victim.second));
+            }
+            forget(tier, victim.second);
+        }
+    }
+};
+
+#endif // TIEREDCACHE_H
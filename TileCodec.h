@@ -0,0 +1,114 @@
+// TileCodec.h - Lossless recompression of cached JPEG tiles
+// JPEG XL can transcode a JPEG into a ~20% smaller file from which the
+// original bytes are restored exactly, so decoded pixels never change.
+// Built only with libjxl (DSS_HAVE_JXL); otherwise available() is false
+// and the tile store keeps plain JPEGs.
+#ifndef TILECODEC_H
+#define TILECODEC_H
+
+#include <QByteArray>
+#include <QString>
+
+#ifdef DSS_HAVE_JXL
+#include <jxl/encode.h>
+#include <jxl/decode.h>
+#endif
+
+class TileCodec {
+public:
+    static bool available() {
+#ifdef DSS_HAVE_JXL
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static QString extension() { return "jxl"; }
+
+    // JPEG -> JXL with the reconstruction data kept; empty on failure
+    static QByteArray pack(const QByteArray& jpeg) {
+#ifdef DSS_HAVE_JXL
+        JxlEncoder* encoder = JxlEncoderCreate(nullptr);
+        if (!encoder) return QByteArray();
+
+        QByteArray packed;
+        JxlEncoderFrameSettings* settings = JxlEncoderFrameSettingsCreate(encoder, nullptr);
+        bool ok = JxlEncoderUseContainer(encoder, JXL_TRUE) == JXL_ENC_SUCCESS
+               && JxlEncoderStoreJPEGMetadata(encoder, JXL_TRUE) == JXL_ENC_SUCCESS
+               && JxlEncoderFrameSettingsSetOption(settings, JXL_ENC_FRAME_SETTING_EFFORT, 7) == JXL_ENC_SUCCESS
+               && JxlEncoderAddJPEGFrame(settings, reinterpret_cast<const uint8_t*>(jpeg.constData()),
+                                         size_t(jpeg.size())) == JXL_ENC_SUCCESS;
+        if (ok) {
+            JxlEncoderCloseInput(encoder);
+            packed.resize(jpeg.size());
+            size_t written = 0;
+            JxlEncoderStatus status = JXL_ENC_NEED_MORE_OUTPUT;
+            while (status == JXL_ENC_NEED_MORE_OUTPUT) {
+                if (written == size_t(packed.size())) packed.resize(packed.size() * 2);
+                uint8_t* next = reinterpret_cast<uint8_t*>(packed.data()) + written;
+                size_t avail = size_t(packed.size()) - written;
+                status = JxlEncoderProcessOutput(encoder, &next, &avail);
+                written = size_t(packed.size()) - avail;
+            }
+            ok = status == JXL_ENC_SUCCESS;
+            packed.resize(int(written));
+        }
+        JxlEncoderDestroy(encoder);
+        return ok ? packed : QByteArray();
+#else
+        Q_UNUSED(jpeg);
+        return QByteArray();
+#endif
+    }
+
+    // JXL -> the original JPEG bytes; empty on failure or if the file
+    // carries no JPEG reconstruction data
+    static QByteArray unpack(const QByteArray& packed) {
+#ifdef DSS_HAVE_JXL
+        JxlDecoder* decoder = JxlDecoderCreate(nullptr);
+        if (!decoder) return QByteArray();
+
+        QByteArray jpeg;
+        bool ok = JxlDecoderSubscribeEvents(decoder, JXL_DEC_JPEG_RECONSTRUCTION | JXL_DEC_FULL_IMAGE)
+                  == JXL_DEC_SUCCESS
+               && JxlDecoderSetInput(decoder, reinterpret_cast<const uint8_t*>(packed.constData()),
+                                     size_t(packed.size())) == JXL_DEC_SUCCESS;
+        if (ok) {
+            JxlDecoderCloseInput(decoder);
+            bool reconstructing = false;
+            size_t written = 0;
+            for (;;) {
+                JxlDecoderStatus status = JxlDecoderProcessInput(decoder);
+                if (status == JXL_DEC_JPEG_RECONSTRUCTION) {
+                    reconstructing = true;
+                    jpeg.resize(packed.size() * 2);
+                    JxlDecoderSetJPEGBuffer(decoder, reinterpret_cast<uint8_t*>(jpeg.data()), size_t(jpeg.size()));
+                } else if (status == JXL_DEC_JPEG_NEED_MORE_OUTPUT) {
+                    written = size_t(jpeg.size()) - JxlDecoderReleaseJPEGBuffer(decoder);
+                    jpeg.resize(jpeg.size() * 2);
+                    JxlDecoderSetJPEGBuffer(decoder, reinterpret_cast<uint8_t*>(jpeg.data()) + written,
+                                            size_t(jpeg.size()) - written);
+                } else if (status == JXL_DEC_FULL_IMAGE) {
+                    // The JPEG is complete once its frame is
+                    if (!reconstructing) ok = false;
+                    else written = size_t(jpeg.size()) - JxlDecoderReleaseJPEGBuffer(decoder);
+                    break;
+                } else {
+                    // Pixel output requested or error: not a transcoded JPEG
+                    ok = false;
+                    break;
+                }
+            }
+            jpeg.resize(ok ? int(written) : 0);
+        }
+        JxlDecoderDestroy(decoder);
+        return ok ? jpeg : QByteArray();
+#else
+        Q_UNUSED(packed);
+        return QByteArray();
+#endif
+    }
+};
+
+#endif // TILECODEC_H
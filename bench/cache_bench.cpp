@@ -0,0 +1,611 @@
+// cache_bench.cpp - Concurrent load generator for ImageCache and the tile store
+// Populates synthetic entries at a chosen scale, then replays Zipfian,
+// sequential-scan or mixed access from many threads (and optionally many
+// processes sharing the directory) and reports throughput, latency
+// percentiles and index memory, so cache back ends can be compared.
+//
+//   cache_bench --target imagecache --entries 1000000 --threads 16 --pattern zipf
+//   cache_bench --target tilestore --processes 4 --write-ratio 0.2
+//   cache_bench --target codec --tiles ~/hips/DSS2/Norder8 --sample 500
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QBuffer>
+#include <QImage>
+#include <QProcess>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "ImageCache.h"
+#include "ContentStore.h"
+#include "TileCodec.h"
+#include "MemoryBudget.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Log-scale latency histogram: 8 buckets per power of two (~9% resolution)
+struct LatencyHistogram {
+    static constexpr int kSub = 8;
+    static constexpr int kBuckets = 48 * kSub;
+    std::vector<quint64> counts = std::vector<quint64>(kBuckets, 0);
+
+    void add(qint64 ns) {
+        int bucket = int(std::log2(double(std::max<qint64>(1, ns))) * kSub);
+        counts[std::min(kBuckets - 1, bucket)]++;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < kBuckets; ++i) counts[i] += other.counts[i];
+    }
+
+    quint64 total() const {
+        quint64 sum = 0;
+        for (quint64 c : counts) sum += c;
+        return sum;
+    }
+
+    // Upper edge of the bucket holding the p-th percentile, in ns
+    double percentile(double p) const {
+        quint64 rank = quint64(std::ceil(p / 100.0 * total()));
+        quint64 seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank && counts[i] > 0) return std::exp2(double(i + 1) / kSub);
+        }
+        return 0.0;
+    }
+
+    QString serialize() const {
+        QStringList parts;
+        for (quint64 c : counts) parts << QString::number(c);
+        return parts.join(',');
+    }
+
+    static LatencyHistogram parse(const QString& text) {
+        LatencyHistogram histogram;
+        QStringList parts = text.split(',');
+        for (int i = 0; i < std::min(kBuckets, int(parts.size())); ++i) {
+            histogram.counts[i] = parts[i].toULongLong();
+        }
+        return histogram;
+    }
+};
+
+struct RunResult {
+    quint64 reads = 0;
+    quint64 hits = 0;
+    quint64 writes = 0;
+    qint64 elapsedNs = 0;
+    LatencyHistogram readLatency;
+    LatencyHistogram writeLatency;
+};
+
+// Distinct bytes per id, so content addressing cannot collapse entries
+static QByteArray payloadFor(qint64 id, int size) {
+    QByteArray data(size, char(id & 0xff));
+    QByteArray tag = QByteArray::number(id);
+    std::copy(tag.begin(), tag.end(), data.begin());
+    return data;
+}
+
+class BenchTarget {
+public:
+    virtual ~BenchTarget() = default;
+    virtual QString name() const = 0;
+    virtual void populate(qint64 count, int payload) = 0;
+    virtual bool read(qint64 id) = 0;
+    virtual void write(qint64 id, const QByteArray& data) = 0;
+    virtual qint64 indexBytes() const = 0;
+};
+
+// ImageCache is not thread-safe, so calls are serialised the way a
+// multi-threaded caller has to; the lock wait is part of the latency.
+// Entries go under a survey key no real cutout uses.
+class ImageCacheTarget : public BenchTarget {
+public:
+    ImageCacheTarget(const QString& dir, bool holdMetadata) : cache(dir + "/imagecache") {
+        if (holdMetadata) cache.holdMetadata(true);
+    }
+
+    QString name() const override { return "ImageCache"; }
+
+    void populate(qint64 count, int payload) override {
+        cache.holdMetadata(true);
+        for (qint64 id = 0; id < count; ++id) write(id, payloadFor(id, payload));
+        cache.holdMetadata(false);
+    }
+
+    bool read(qint64 id) override {
+        double ra, dec;
+        position(id, ra, dec);
+        QMutexLocker locker(&mutex);
+        return cache.isCached(ra, dec, 15.0, 15.0, kSurvey, "gif")
+            && !cache.getCachedImage(ra, dec, 15.0, 15.0, kSurvey, "gif").isEmpty();
+    }
+
+    void write(qint64 id, const QByteArray& data) override {
+        double ra, dec;
+        position(id, ra, dec);
+        QMutexLocker locker(&mutex);
+        cache.cacheImage(data, ra, dec, 15.0, 15.0, kSurvey, "gif");
+    }
+
+    qint64 indexBytes() const override {
+        return MemoryAccounting::instance().currentBytes(MemoryStage::ImageCacheIndex);
+    }
+
+private:
+    static constexpr const char* kSurvey = "cache_bench";
+    ImageCache cache;
+    QMutex mutex;
+
+    // Unique sky position per id on a 0.01° grid
+    static void position(qint64 id, double& ra, double& dec) {
+        ra = double(id % 36000) * 0.01;
+        dec = -85.0 + double(id / 36000) * 0.01;
+    }
+};
+
+class TileStoreTarget : public BenchTarget {
+public:
+    explicit TileStoreTarget(const QString& dir) : store(dir + "/tilestore", "dss_cache_bench", "bin") {}
+
+    QString name() const override { return "ContentStore"; }
+
+    void populate(qint64 count, int payload) override {
+        std::atomic<qint64> next{0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < std::max(1, QThread::idealThreadCount()); ++t) {
+            workers.emplace_back([&]() {
+                for (qint64 id = next++; id < count; id = next++) write(id, payloadFor(id, payload));
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+        store.flushLocal();
+    }
+
+    bool read(qint64 id) override {
+        return !store.get(QString("tile_pixel%1").arg(id)).isEmpty();
+    }
+
+    void write(qint64 id, const QByteArray& data) override {
+        store.put(QString("tile_pixel%1").arg(id), data);
+    }
+
+    qint64 indexBytes() const override {
+        return store.indexBytes();
+    }
+
+private:
+    ContentStore store;
+};
+
+// Ranks drawn with P(k) ~ 1/k^s, mapped through a fixed permutation so
+// the popular entries are spread over the key space
+class ZipfSampler {
+public:
+    ZipfSampler(qint64 n, double s) : cdf(size_t(n)), ids(size_t(n)) {
+        double sum = 0.0;
+        for (qint64 k = 0; k < n; ++k) {
+            sum += 1.0 / std::pow(double(k + 1), s);
+            cdf[size_t(k)] = sum;
+        }
+        for (double& c : cdf) c /= sum;
+        for (qint64 k = 0; k < n; ++k) ids[size_t(k)] = k;
+        std::mt19937_64 shuffle(12345);     // Same order in every process
+        std::shuffle(ids.begin(), ids.end(), shuffle);
+    }
+
+    qint64 sample(std::mt19937_64& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        size_t rank = size_t(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+        return ids[std::min(rank, ids.size() - 1)];
+    }
+
+private:
+    std::vector<double> cdf;
+    std::vector<qint64> ids;
+};
+
+struct RunOptions {
+    qint64 entries = 100000;
+    int payload = 4096;
+    int threads = 8;
+    qint64 ops = 100000;
+    QString pattern = "zipf";
+    double zipfS = 0.99;
+    double writeRatio = 0.05;
+    int processIndex = 0;
+};
+
+static RunResult runWorkload(BenchTarget& target, const RunOptions& options) {
+    ZipfSampler zipf(options.entries, options.zipfS);
+    std::atomic<qint64> nextWrite{options.entries + qint64(options.processIndex) * 1000000000LL};
+    std::vector<RunResult> perThread(size_t(options.threads));
+    qint64 opsPerThread = options.ops / options.threads;
+
+    QElapsedTimer wall;
+    wall.start();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options.threads; ++t) {
+        workers.emplace_back([&, t]() {
+            RunResult& result = perThread[size_t(t)];
+            std::mt19937_64 rng(quint64(options.processIndex) * 7919 + quint64(t));
+            std::uniform_real_distribution<double> coin(0.0, 1.0);
+            qint64 cursor = options.entries * t / options.threads;
+            QElapsedTimer timer;
+
+            for (qint64 op = 0; op < opsPerThread; ++op) {
+                if (coin(rng) < options.writeRatio) {
+                    qint64 id = nextWrite++;
+                    QByteArray data = payloadFor(id, options.payload);
+                    timer.start();
+                    target.write(id, data);
+                    result.writeLatency.add(timer.nsecsElapsed());
+                    result.writes++;
+                    continue;
+                }
+                bool scan = options.pattern == "scan" || (options.pattern == "mixed" && coin(rng) < 0.2);
+                qint64 id = scan ? (cursor++ % options.entries) : zipf.sample(rng);
+                timer.start();
+                bool hit = target.read(id);
+                result.readLatency.add(timer.nsecsElapsed());
+                result.reads++;
+                if (hit) result.hits++;
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    RunResult total;
+    total.elapsedNs = wall.nsecsElapsed();
+    for (const RunResult& r : perThread) {
+        total.reads += r.reads;
+        total.hits += r.hits;
+        total.writes += r.writes;
+        total.readLatency.merge(r.readLatency);
+        total.writeLatency.merge(r.writeLatency);
+    }
+    return total;
+}
+
+// Resident set size from /proc, -1 where unavailable
+static qint64 residentBytes() {
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) return -1;
+    for (const QByteArray& line : status.readAll().split('\n')) {
+        if (line.startsWith("VmRSS:")) return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+    }
+    return -1;
+}
+
+// Reports go to stdout; the caches' per-operation qDebug lines are muted
+static QTextStream& out() {
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+static QString formatNs(double ns) {
+    if (ns >= 1e6) return QString("%1 ms").arg(ns / 1e6, 0, 'f', 2);
+    return QString("%1 us").arg(ns / 1e3, 0, 'f', 1);
+}
+
+static void report(const QString& label, const RunResult& result, int processes, qint64 indexBytes) {
+    double seconds = result.elapsedNs / 1e9;
+    quint64 ops = result.reads + result.writes;
+    out() << QString("=== %1 ===").arg(label) << '\n';
+    out() << QString("Operations: %1 (%2 reads, %3% hit; %4 writes) by %5 process(es) in %6 s")
+              .arg(ops).arg(result.reads)
+              .arg(result.reads ? 100.0 * result.hits / result.reads : 0.0, 0, 'f', 1)
+              .arg(result.writes).arg(processes).arg(seconds, 0, 'f', 2) << '\n';
+    out() << QString("Throughput: %1 ops/s").arg(seconds > 0 ? ops / seconds : 0.0, 0, 'f', 0) << '\n';
+    for (const auto& entry : {std::make_pair(QString("Read"), &result.readLatency),
+                              std::make_pair(QString("Write"), &result.writeLatency)}) {
+        if (entry.second->total() == 0) continue;
+        out() << QString("%1 latency: p50 %2, p90 %3, p99 %4, p99.9 %5")
+              .arg(entry.first, -5)
+              .arg(formatNs(entry.second->percentile(50)))
+              .arg(formatNs(entry.second->percentile(90)))
+              .arg(formatNs(entry.second->percentile(99)))
+              .arg(formatNs(entry.second->percentile(99.9))) << '\n';
+    }
+    qint64 rss = residentBytes();
+    out() << QString("Index memory: %1 MB; resident: %2")
+              .arg(indexBytes / (1024.0 * 1024.0), 0, 'f', 1)
+              .arg(rss < 0 ? QString("n/a") : QString("%1 MB").arg(rss / (1024.0 * 1024.0), 0, 'f', 1)) << '\n';
+}
+
+// Tiles for --target codec: JPEGs (or packed tiles, unpacked) under
+// `tilesDir`, else synthetic star fields encoded like survey tiles
+static QList<QByteArray> codecSamples(const QString& tilesDir, int count) {
+    QList<QByteArray> jpegs;
+    if (!tilesDir.isEmpty()) {
+        QDirIterator it(tilesDir, QStringList() << "*.jpg" << "*." + TileCodec::extension(),
+                        QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext() && jpegs.size() < count) {
+            QFile file(it.next());
+            if (!file.open(QIODevice::ReadOnly)) continue;
+            QByteArray data = file.readAll();
+            if (it.fileInfo().suffix() == TileCodec::extension()) data = TileCodec::unpack(data);
+            if (!data.isEmpty()) jpegs << data;
+        }
+        return jpegs;
+    }
+
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> noise(0.0, 6.0);
+    std::uniform_int_distribution<int> place(0, 511);
+    for (int i = 0; i < count; ++i) {
+        QImage image(512, 512, QImage::Format_RGB32);
+        for (int y = 0; y < 512; ++y) {
+            QRgb* row = reinterpret_cast<QRgb*>(image.scanLine(y));
+            for (int x = 0; x < 512; ++x) {
+                int sky = std::clamp(int(30 + 10 * (x + y + i) / 1024.0 + noise(rng)), 0, 255);
+                row[x] = qRgb(sky, sky, std::min(255, sky + 4));
+            }
+        }
+        for (int s = 0; s < 60; ++s) {
+            int cx = place(rng), cy = place(rng), r = 1 + s % 4;
+            for (int y = std::max(0, cy - r); y <= std::min(511, cy + r); ++y) {
+                for (int x = std::max(0, cx - r); x <= std::min(511, cx + r); ++x) {
+                    image.setPixel(x, y, qRgb(255, 250, 240));
+                }
+            }
+        }
+        QByteArray jpeg;
+        QBuffer buffer(&jpeg);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "JPEG", 90);
+        jpegs << jpeg;
+    }
+    return jpegs;
+}
+
+// Ask the kernel to forget a file's pages so the next read goes to disk;
+// a hint only, so reads may still be served from the page cache
+static void dropFromPageCache(const QString& path) {
+#ifdef __linux__
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#else
+    Q_UNUSED(path);
+#endif
+}
+
+static qint64 timedRead(const QStringList& paths) {
+    for (const QString& path : paths) dropFromPageCache(path);
+    QElapsedTimer timer;
+    timer.start();
+    for (const QString& path : paths) {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly)) file.readAll();
+    }
+    return timer.nsecsElapsed();
+}
+
+// --target codec: what packing cached tiles as JPEG XL saves and costs.
+// A read that misses RAM then pays a smaller disk read plus an unpack,
+// before the JPEG decode it needed anyway.
+static int runCodecBench(const QString& dir, const QString& tilesDir, int count) {
+    if (!TileCodec::available()) {
+        out() << "codec: built without libjxl, nothing to measure\n";
+        return 1;
+    }
+    QList<QByteArray> jpegs = codecSamples(tilesDir, count);
+    QString codecDir = dir + "/codec";
+    QDir(codecDir).removeRecursively();
+    QDir().mkpath(codecDir);
+
+    QStringList jpegPaths, packedPaths;
+    qint64 jpegBytes = 0, packedBytes = 0, packNs = 0;
+    int rejected = 0;
+    QElapsedTimer timer;
+    for (int i = 0; i < jpegs.size(); ++i) {
+        timer.start();
+        QByteArray packed = TileCodec::pack(jpegs[i]);
+        packNs += timer.nsecsElapsed();
+        if (packed.isEmpty() || packed.size() >= jpegs[i].size()) {
+            rejected++;
+            continue;
+        }
+        QString base = QString("%1/%2").arg(codecDir).arg(i);
+        QList<bool> written = BatchIO::writeFiles(QList<BatchIO::FileData>()
+                                                  << BatchIO::FileData(base + ".jpg", jpegs[i])
+                                                  << BatchIO::FileData(base + "." + TileCodec::extension(), packed));
+        if (!written[0] || !written[1]) {
+            out() << "codec: cannot write to " << codecDir << '\n';
+            return 1;
+        }
+        jpegPaths << base + ".jpg";
+        packedPaths << base + "." + TileCodec::extension();
+        jpegBytes += jpegs[i].size();
+        packedBytes += packed.size();
+    }
+    const int n = jpegPaths.size();
+    if (n == 0) {
+        out() << "codec: no tile packed smaller than its JPEG\n";
+        return 1;
+    }
+
+    qint64 jpegReadNs = timedRead(jpegPaths);
+    qint64 packedReadNs = timedRead(packedPaths);
+    qint64 unpackNs = 0, decodeNs = 0;
+    for (const QString& path : packedPaths) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        QByteArray packed = file.readAll();
+        timer.start();
+        QByteArray jpeg = TileCodec::unpack(packed);
+        unpackNs += timer.nsecsElapsed();
+        timer.start();
+        QImage::fromData(jpeg, "JPEG");
+        decodeNs += timer.nsecsElapsed();
+    }
+    QDir(codecDir).removeRecursively();
+
+    auto perTile = [n](qint64 ns) { return ns / 1e6 / n; };
+    double savedPerTile = double(jpegBytes - packedBytes) / n;
+    double unpackSeconds = unpackNs / 1e9 / n;
+    out() << QString("=== Tile codec (%1), %2 tiles ===").arg(TileCodec::extension()).arg(n) << '\n';
+    out() << QString("Size: JPEG %1 KB, packed %2 KB per tile (%3% smaller); pack %4 ms/tile, %5 rejected")
+              .arg(jpegBytes / 1024.0 / n, 0, 'f', 1).arg(packedBytes / 1024.0 / n, 0, 'f', 1)
+              .arg(100.0 * (jpegBytes - packedBytes) / jpegBytes, 0, 'f', 1)
+              .arg(packNs / 1e6 / std::max(1, int(jpegs.size())), 0, 'f', 2).arg(rejected) << '\n';
+    out() << QString("Disk read: JPEG %1 ms/tile, packed %2 ms/tile")
+              .arg(perTile(jpegReadNs), 0, 'f', 3).arg(perTile(packedReadNs), 0, 'f', 3) << '\n';
+    out() << QString("Unpack %1 ms/tile; JPEG decode %2 ms/tile")
+              .arg(perTile(unpackNs), 0, 'f', 3).arg(perTile(decodeNs), 0, 'f', 3) << '\n';
+    out() << QString("RAM miss: plain %1 ms, packed %2 ms per tile (read + unpack + decode)")
+              .arg(perTile(jpegReadNs + decodeNs), 0, 'f', 3)
+              .arg(perTile(packedReadNs + unpackNs + decodeNs), 0, 'f', 3) << '\n';
+    out() << QString("Break-even: packing reads faster only below %1 MB/s of disk throughput")
+              .arg(unpackSeconds > 0 ? savedPerTile / unpackSeconds / (1024.0 * 1024.0) : 0.0, 0, 'f', 1) << '\n';
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("DSS Cache Bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Concurrent load benchmark for ImageCache and the tile store");
+    parser.addHelpOption();
+
+    QCommandLineOption targetOption("target", "imagecache, tilestore or codec", "target", "imagecache");
+    QCommandLineOption dirOption("dir", "Benchmark cache directory", "dir",
+                                 QDir::tempPath() + "/dss_cache_bench");
+    QCommandLineOption entriesOption("entries", "Synthetic entries to populate", "n", "100000");
+    QCommandLineOption payloadOption("payload", "Bytes per entry", "bytes", "4096");
+    QCommandLineOption threadsOption("threads", "Threads per process", "n",
+                                     QString::number(std::max(1, QThread::idealThreadCount())));
+    QCommandLineOption processesOption("processes", "Processes sharing the directory", "n", "1");
+    QCommandLineOption opsOption("ops", "Operations per process", "n", "100000");
+    QCommandLineOption patternOption("pattern", "zipf, scan or mixed (80% zipf, 20% scan)", "pattern", "zipf");
+    QCommandLineOption zipfOption("zipf-s", "Zipf exponent", "s", "0.99");
+    QCommandLineOption writeOption("write-ratio", "Fraction of operations that insert new entries", "r", "0.05");
+    QCommandLineOption noPopulateOption("no-populate", "Reuse entries already in --dir");
+    QCommandLineOption holdOption("hold-metadata", "Defer ImageCache metadata writes during the run");
+    QCommandLineOption tilesOption("tiles", "codec: directory of JPEG tiles (default synthetic)", "dir");
+    QCommandLineOption sampleOption("sample", "codec: tiles to measure", "n", "200");
+    QCommandLineOption childOption("child", "Internal: run as worker process <index>", "index");
+    for (const QCommandLineOption& option : {targetOption, dirOption, entriesOption, payloadOption,
+                                             threadsOption, processesOption, opsOption, patternOption,
+                                             zipfOption, writeOption, noPopulateOption, holdOption,
+                                             tilesOption, sampleOption, childOption}) {
+        parser.addOption(option);
+    }
+    parser.process(app);
+    QLoggingCategory::setFilterRules("default.debug=false");
+
+    // Keep every tier under --dir: synthetic entries must never reach a
+    // team cache, and shared-tier latency would blur the comparison
+    if (qEnvironmentVariableIsSet("DSS_CACHE_SHARED")) {
+        if (!parser.isSet("child")) out() << "Ignoring DSS_CACHE_SHARED: benchmark tiers stay under --dir\n";
+        qunsetenv("DSS_CACHE_SHARED");
+    }
+
+    RunOptions options;
+    options.entries = std::max<qint64>(1, parser.value(entriesOption).toLongLong());
+    options.payload = std::max(16, parser.value(payloadOption).toInt());
+    options.threads = std::max(1, parser.value(threadsOption).toInt());
+    options.ops = std::max<qint64>(options.threads, parser.value(opsOption).toLongLong());
+    options.pattern = parser.value(patternOption);
+    options.zipfS = parser.value(zipfOption).toDouble();
+    options.writeRatio = std::clamp(parser.value(writeOption).toDouble(), 0.0, 1.0);
+    const QString dir = parser.value(dirOption);
+    const int processes = std::max(1, parser.value(processesOption).toInt());
+    const bool child = parser.isSet(childOption);
+    options.processIndex = child ? parser.value(childOption).toInt() : 0;
+
+    if (parser.value(targetOption) == "codec") {
+        int result = runCodecBench(dir, parser.value(tilesOption),
+                                   std::max(1, parser.value(sampleOption).toInt()));
+        out().flush();
+        return result;
+    }
+
+    auto makeTarget = [&]() -> std::unique_ptr<BenchTarget> {
+        if (parser.value(targetOption) == "tilestore") return std::make_unique<TileStoreTarget>(dir);
+        return std::make_unique<ImageCacheTarget>(dir, parser.isSet(holdOption));
+    };
+
+    if (child) {
+        // One machine-readable line for the parent to merge
+        std::unique_ptr<BenchTarget> target = makeTarget();
+        RunResult result = runWorkload(*target, options);
+        out() << "RESULT " << result.reads << ' ' << result.hits << ' ' << result.writes << ' '
+                            << result.elapsedNs << ' ' << result.readLatency.serialize() << ' '
+                            << result.writeLatency.serialize() << '\n';
+        out().flush();
+        return 0;
+    }
+
+    std::unique_ptr<BenchTarget> target = makeTarget();
+    if (!parser.isSet(noPopulateOption)) {
+        QElapsedTimer timer;
+        timer.start();
+        target->populate(options.entries, options.payload);
+        out() << QString("Populated %1 %2 entries of %3 bytes in %4 s")
+              .arg(options.entries).arg(target->name()).arg(options.payload)
+              .arg(timer.nsecsElapsed() / 1e9, 0, 'f', 2) << '\n';
+    }
+
+    QString label = QString("%1, %2 pattern, %3 threads x %4 processes")
+                    .arg(target->name()).arg(options.pattern).arg(options.threads).arg(processes);
+    if (processes == 1) {
+        RunResult result = runWorkload(*target, options);
+        report(label, result, 1, target->indexBytes());
+        out().flush();
+        return 0;
+    }
+
+    // Release the populated instance so the children start from disk
+    qint64 indexBytes = target->indexBytes();
+    target.reset();
+
+    QStringList baseArgs = app.arguments().mid(1);
+    std::vector<std::unique_ptr<QProcess>> workers;
+    for (int p = 0; p < processes; ++p) {
+        auto worker = std::make_unique<QProcess>();
+        worker->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        worker->start(app.applicationFilePath(), QStringList(baseArgs) << "--no-populate"
+                      << "--child" << QString::number(p));
+        workers.push_back(std::move(worker));
+    }
+
+    RunResult total;
+    for (auto& worker : workers) {
+        worker->waitForFinished(-1);
+        for (const QString& line : QString::fromLatin1(worker->readAllStandardOutput()).split('\n')) {
+            QStringList fields = line.split(' ');
+            if (fields.size() != 7 || fields[0] != "RESULT") continue;
+            total.reads += fields[1].toULongLong();
+            total.hits += fields[2].toULongLong();
+            total.writes += fields[3].toULongLong();
+            total.elapsedNs = std::max(total.elapsedNs, fields[4].toLongLong());
+            total.readLatency.merge(LatencyHistogram::parse(fields[5]));
+            total.writeLatency.merge(LatencyHistogram::parse(fields[6]));
+        }
+    }
+    report(label, total, processes, indexBytes);
+    out().flush();
+    return 0;
+}
@@ -0,0 +1,110 @@
+// parallel_bench.cpp - Scaling of Parallel::forEach with and without NUMA pinning
+// Each item allocates and first-touches a frame-sized buffer, then makes
+// several stencil passes over it, the access pattern of the per-frame
+// pipelines forEach runs in the stacker, scorer and calibrator. For each
+// thread count the same work runs pinned (DSS_NUMA unset) and unpinned
+// (DSS_NUMA=0), reporting frames/s and speedup over one thread.
+//
+//   parallel_bench --frames 128 --size 4096 --passes 4
+//   numactl --cpunodebind=0 parallel_bench      # pinning within a cpuset
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "Parallel.h"
+
+static QTextStream& out() {
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+// One frame: first touch on the worker's node, then 5-point blur passes
+static double processFrame(int index, int size, int passes) {
+    std::vector<float> a(size_t(size) * size), b(size_t(size) * size);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) a[size_t(y) * size + x] = float((x * 7 + y * 13 + index) & 255);
+    }
+    for (int pass = 0; pass < passes; ++pass) {
+        for (int y = 1; y < size - 1; ++y) {
+            const float* up = &a[size_t(y - 1) * size];
+            const float* row = &a[size_t(y) * size];
+            const float* down = &a[size_t(y + 1) * size];
+            float* dst = &b[size_t(y) * size];
+            for (int x = 1; x < size - 1; ++x) {
+                dst[x] = 0.2f * (row[x] + row[x - 1] + row[x + 1] + up[x] + down[x]);
+            }
+        }
+        std::swap(a, b);
+    }
+    return a[size_t(size / 2) * size + size / 2];
+}
+
+// Frames per second for `threads` workers
+static double measure(int threads, int frames, int size, int passes) {
+    std::atomic<long long> checksum{0};
+    QElapsedTimer timer;
+    timer.start();
+    Parallel::forEach(frames, threads, [&](int i) {
+        checksum += (long long)processFrame(i, size, passes);
+    });
+    return frames / (timer.nsecsElapsed() / 1e9);
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("DSS Parallel Bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Thread scaling of Parallel::forEach, NUMA-pinned and unpinned");
+    parser.addHelpOption();
+
+    QCommandLineOption framesOption("frames", "Work items per run", "n", "128");
+    QCommandLineOption sizeOption("size", "Frame side in pixels (float)", "px", "4096");
+    QCommandLineOption passesOption("passes", "Stencil passes per frame", "n", "4");
+    QCommandLineOption threadsOption("max-threads", "Largest thread count", "n",
+                                     QString::number(std::max(1, QThread::idealThreadCount())));
+    for (const QCommandLineOption& option : {framesOption, sizeOption, passesOption, threadsOption}) {
+        parser.addOption(option);
+    }
+    parser.process(app);
+
+    const int frames = std::max(1, parser.value(framesOption).toInt());
+    const int size = std::max(16, parser.value(sizeOption).toInt());
+    const int passes = std::max(1, parser.value(passesOption).toInt());
+    const int maxThreads = std::max(1, parser.value(threadsOption).toInt());
+
+    const Parallel::Topology& topology = Parallel::Topology::system();
+    out() << QString("Topology: %1 NUMA node(s)").arg(topology.nodeCount());
+    for (int n = 0; n < topology.nodeCount(); ++n) {
+        out() << QString(", node %1: %2 CPUs").arg(n).arg(topology.nodes[size_t(n)].size());
+    }
+    out() << '\n';
+    if (topology.nodeCount() < 2) out() << "Single node: pinned and unpinned runs are the same\n";
+
+    std::vector<int> counts;
+    for (int t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    out() << QString("%1 %2 %3 %4 %5\n").arg("threads", 8).arg("pinned/s", 12).arg("speedup", 9)
+                                        .arg("unpinned/s", 12).arg("speedup", 9);
+    double pinnedBase = 0, unpinnedBase = 0;
+    for (int threads : counts) {
+        qunsetenv("DSS_NUMA");
+        double pinned = measure(threads, frames, size, passes);
+        qputenv("DSS_NUMA", "0");
+        double unpinned = measure(threads, frames, size, passes);
+        if (threads == 1) {
+            pinnedBase = pinned;
+            unpinnedBase = unpinned;
+        }
+        out() << QString("%1 %2 %3 %4 %5\n").arg(threads, 8)
+                  .arg(pinned, 12, 'f', 2).arg(pinned / pinnedBase, 9, 'f', 2)
+                  .arg(unpinned, 12, 'f', 2).arg(unpinned / unpinnedBase, 9, 'f', 2);
+        out().flush();
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+// spherical_bench.cpp - Batch spherical kernels against per-point double libm
+// Times each SphericalGeometry.h kernel over the same positions as the
+// scalar code it replaced, reporting ns per point and the speedup. Best
+// of several runs, single thread.
+//
+//   spherical_bench [points] [runs]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "SphericalGeometry.h"
+
+// Best wall time of `runs` calls, in ns per point
+template <typename F>
+static double timeBest(int runs, int points, F fn) {
+    double best = 1e30;
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best * 1e9 / points;
+}
+
+static void report(const char* name, double scalar, double batch) {
+    std::printf("%-20s %10.2f %10.2f %8.1fx\n", name, scalar, batch, scalar / batch);
+}
+
+int main(int argc, char *argv[]) {
+    const int n = argc > 1 ? std::max(16, std::atoi(argv[1])) : 1 << 20;
+    const int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 7;
+
+    // Positions within 10 degrees of a tangent point, the planner's case
+    const double ra0 = 10.6847, dec0 = 41.2687;
+    std::vector<double> ra(n), dec(n), ra2(n), dec2(n);
+    for (int i = 0; i < n; ++i) {
+        ra[i] = ra0 + 10.0 * std::sin(i * 0.0137);
+        dec[i] = dec0 + 10.0 * std::cos(i * 0.0071);
+    }
+    std::vector<float> x(n), y(n), z(n), a(n), b(n);
+    const spherical::Rotation frame = spherical::Rotation::tangentFrame(ra0, dec0);
+    const spherical::Vec3 e{frame.m[0][0], frame.m[0][1], frame.m[0][2]};
+    const spherical::Vec3 u{frame.m[1][0], frame.m[1][1], frame.m[1][2]};
+    const spherical::Vec3 w{frame.m[2][0], frame.m[2][1], frame.m[2][2]};
+
+    std::printf("%d points, best of %d runs\n", n, runs);
+    std::printf("%-20s %10s %10s %9s\n", "kernel", "libm ns", "batch ns", "speedup");
+
+    double scalar = timeBest(runs, n, [&] {
+        for (int i = 0; i < n; ++i) {
+            spherical::Vec3 v = spherical::fromRaDec(ra[i], dec[i]);
+            x[i] = float(v.x);
+            y[i] = float(v.y);
+            z[i] = float(v.z);
+        }
+    });
+    double batch = timeBest(runs, n, [&] {
+        spherical::raDecToVectors(ra.data(), dec.data(), n, x.data(), y.data(), z.data());
+    });
+    report("raDecToVectors", scalar, batch);
+
+    scalar = timeBest(runs, n, [&] {
+        for (int i = 0; i < n; ++i) {
+            double r = std::atan2(double(y[i]), double(x[i])) * 180.0 / M_PI;
+            ra2[i] = r < 0.0 ? r + 360.0 : r;
+            dec2[i] = std::atan2(double(z[i]), std::hypot(double(x[i]), double(y[i]))) * 180.0 / M_PI;
+        }
+    });
+    batch = timeBest(runs, n, [&] {
+        spherical::vectorsToRaDec(x.data(), y.data(), z.data(), n, ra2.data(), dec2.data());
+    });
+    report("vectorsToRaDec", scalar, batch);
+
+    scalar = timeBest(runs, n, [&] {
+        for (int i = 0; i < n; ++i) {
+            double pe = e.x * x[i] + e.y * y[i] + e.z * z[i];
+            double pu = u.x * x[i] + u.y * y[i] + u.z * z[i];
+            double pw = w.x * x[i] + w.y * y[i] + w.z * z[i];
+            a[i] = pw > 0.0 ? float(pe / pw) : NAN;
+            b[i] = pw > 0.0 ? float(pu / pw) : NAN;
+        }
+    });
+    batch = timeBest(runs, n, [&] {
+        spherical::gnomonicForward(frame, x.data(), y.data(), z.data(), n, a.data(), b.data());
+    });
+    report("gnomonicForward", scalar, batch);
+
+    scalar = timeBest(runs, n, [&] {
+        for (int i = 0; i < n; ++i) {
+            double pe = e.x * x[i] + e.y * y[i] + e.z * z[i];
+            double pu = u.x * x[i] + u.y * y[i] + u.z * z[i];
+            double pw = w.x * x[i] + w.y * y[i] + w.z * z[i];
+            a[i] = float(std::atan2(std::hypot(pe, pu), pw));
+            b[i] = float(std::atan2(pe, pu));
+        }
+    });
+    batch = timeBest(runs, n, [&] {
+        spherical::separationAndAngle(frame, x.data(), y.data(), z.data(), n, a.data(), b.data());
+    });
+    report("separationAndAngle", scalar, batch);
+
+    // Keep the outputs live
+    double sink = 0;
+    for (int i = 0; i < n; i += 4096) sink += ra2[i] + dec2[i] + a[i] + b[i];
+    return sink == 12345.0 ? 1 : 0;
+}
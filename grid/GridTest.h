@@ -0,0 +1,43 @@
+// GridTest.h - Check counters and expectations shared by the grid tests
+// Every check counts towards one total per test binary; main() ends with
+// `return testResult();`, which prints the summary and gives the exit code.
+#ifndef GRIDTEST_H
+#define GRIDTEST_H
+
+#include <QDebug>
+#include <QString>
+
+namespace GridTest {
+inline int failures = 0;
+inline int checked = 0;
+}
+
+inline void expectTrue(const QString& what, bool condition) {
+    GridTest::checked++;
+    if (condition) return;
+    GridTest::failures++;
+    qDebug() << "FAIL" << what;
+}
+
+inline void expect(const QString& what, const QString& got, const QString& expected) {
+    GridTest::checked++;
+    if (got == expected) return;
+    GridTest::failures++;
+    qDebug() << QString("FAIL %1:\n  got      '%2'\n  expected '%3'").arg(what, got, expected);
+}
+
+inline void expectWithin(const QString& what, double error, double bound) {
+    GridTest::checked++;
+    if (error <= bound) return;
+    GridTest::failures++;
+    qDebug() << QString("FAIL %1: error %2 exceeds %3").arg(what).arg(error, 0, 'g', 3).arg(bound, 0, 'g', 3);
+}
+
+// Nonzero if any check failed
+inline int testResult() {
+    qDebug() << QString("\n%1 of %2 checks passed").arg(GridTest::checked - GridTest::failures)
+                                                    .arg(GridTest::checked);
+    return GridTest::failures == 0 ? 0 : 1;
+}
+
+#endif // GRIDTEST_H
@@ -0,0 +1,132 @@
+// test_ancestor_fill.cpp - Verify missing tiles are cut from the right part of their ancestor
+// Each order-8 tile near a few targets is treated as missing and cut from a
+// parent (and grandparent) whose sub-squares have distinct colours. The
+// expected sub-square comes from sky geometry, not from the nested bits:
+// a HiPS tile shows its diamond with the north corner top-right and the
+// east corner top-left, so for a child centre at (xi east, eta north) on
+// the tangent plane of the ancestor, eta - xi grows left to right and
+// -(xi + eta) grows top to bottom.
+#include <QCoreApplication>
+#include <QDebug>
+#include <QImage>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "EnhancedMosaicCreator.h"
+#include "GridTest.h"
+#include "ProperHipsClient.h"
+
+static QRgb cellColour(int column, int row) {
+    int index = row * 4 + column;
+    return qRgb(8 + 16 * index, 247 - 16 * index, 128);
+}
+
+// Ancestor tile split into side x side cells, cell (c, r) painted cellColour(c, r)
+static QImage paintAncestor(int side, int width) {
+    QImage image(width, width, QImage::Format_RGB32);
+    int cell = width / side;
+    for (int y = 0; y < width; y++) {
+        for (int x = 0; x < width; x++) {
+            image.setPixel(x, y, cellColour(x / cell, y / cell));
+        }
+    }
+    return image;
+}
+
+static bool near(QRgb a, QRgb b) {
+    return std::abs(qRed(a) - qRed(b)) <= 2 && std::abs(qGreen(a) - qGreen(b)) <= 2 &&
+           std::abs(qBlue(a) - qBlue(b)) <= 2;
+}
+
+static SkyCoord centreOf(long long pixel, int order) {
+    Healpix_Base healpix(1 << order, NEST, SET_NSIDE);
+    return SkyCoord::fromPointing(healpix.pix2ang(int(pixel)));
+}
+
+// Cell of each descendant `levels` orders below `ancestor`, from geometry
+static std::vector<std::pair<int, int>> expectedCells(long long ancestor, int ancestorOrder, int levels) {
+    const int count = 1 << (2 * levels);
+    const int side = 1 << levels;
+    SkyCoord centre = centreOf(ancestor, ancestorOrder);
+    double ra = centre.ra_deg * M_PI / 180.0, dec = centre.dec_deg * M_PI / 180.0;
+    double east[3] = {-std::sin(ra), std::cos(ra), 0};
+    double north[3] = {-std::sin(dec) * std::cos(ra), -std::sin(dec) * std::sin(ra), std::cos(dec)};
+
+    std::vector<double> across(count), down(count);
+    for (int i = 0; i < count; i++) {
+        SkyCoord child = centreOf((ancestor << (2 * levels)) + i, ancestorOrder + levels);
+        double xi = child.x * east[0] + child.y * east[1] + child.z * east[2];
+        double eta = child.x * north[0] + child.y * north[1] + child.z * north[2];
+        across[i] = eta - xi;
+        down[i] = -(xi + eta);
+    }
+
+    // Rank into `side` bands along each axis
+    auto bands = [&](const std::vector<double>& values) {
+        std::vector<int> order(count), band(count);
+        for (int i = 0; i < count; i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return values[a] < values[b]; });
+        for (int rank = 0; rank < count; rank++) band[order[rank]] = rank / side;
+        return band;
+    };
+    std::vector<int> columns = bands(across), rows = bands(down);
+    std::vector<std::pair<int, int>> cells(count);
+    for (int i = 0; i < count; i++) cells[i] = {columns[i], rows[i]};
+    return cells;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    qDebug() << "=== Ancestor Fallback Quadrant Test ===\n";
+
+    ProperHipsClient client;
+    const int order = 8;
+    const int width = 128;
+
+    SkyPosition targets[] = {
+        {10.6847, 41.2687, "M31"},
+        {83.8221, -5.3911, "M42"},
+        {266.4168, -29.0078, "Galactic centre"},
+        {0.0, 0.0, "RA 0 Dec 0"},
+    };
+
+    for (const SkyPosition& target : targets) {
+        long long centerPixel = client.calculateHealPixel(target, order);
+        TileGrid grid = client.createProper3x3Grid(centerPixel, order);
+
+        for (int y = 0; y < 3; y++) {
+            for (int x = 0; x < 3; x++) {
+                long long missing = grid.key(x, y).pixel;
+                if (missing < 0) continue;
+
+                for (int levels = 1; levels <= 2; levels++) {
+                    long long ancestor = missing >> (2 * levels);
+                    int side = 1 << levels;
+                    std::vector<std::pair<int, int>> cells = expectedCells(ancestor, order - levels, levels);
+                    std::pair<int, int> cell = cells[size_t(missing - (ancestor << (2 * levels)))];
+
+                    QImage filled = EnhancedMosaicCreator::cutFromAncestor(paintAncestor(side, 256),
+                                                                           missing, levels, width);
+                    QRgb got = filled.pixel(width / 2, width / 2);
+                    expectTrue(QString("%1 HEALPix %2 from order %3 cut from cell (%4,%5)")
+                               .arg(target.name).arg(missing).arg(order - levels)
+                               .arg(cell.first).arg(cell.second),
+                               filled.size() == QSize(width, width) &&
+                               near(got, cellColour(cell.first, cell.second)));
+                }
+            }
+        }
+        qDebug() << QString("%1: 3x3 grid around HEALPix %2 checked").arg(target.name).arg(centerPixel);
+    }
+
+    // A blank ancestor stands in for all of its children unchanged
+    QImage blank(1, 1, QImage::Format_RGB32);
+    blank.fill(qRgb(3, 3, 3));
+    blank.setText("blank", "1");
+    QImage filled = EnhancedMosaicCreator::cutFromAncestor(blank, 12345, 1, width);
+    expectTrue("blank ancestor passed through uncropped", EnhancedMosaicCreator::blankFill(filled, nullptr));
+
+    return testResult();
+}
@@ -0,0 +1,109 @@
+// test_content_store.cpp - Verify blank-tile marks in the content-addressed tile store
+// A uniform tile is recorded once per content hash as blank/<sha1>.fill;
+// the mark must survive a restart, be shared by every key with the same
+// content, never be confused with other content, and be swept by gc()
+// once no reference points at its hash, also on stores with more
+// references than the process may hold open files.
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTemporaryDir>
+#include <QThread>
+#include <algorithm>
+#include <sys/resource.h>
+#include "ContentStore.h"
+#include "GridTest.h"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    qDebug() << "=== Content Store Blank Tile Test ===\n";
+
+    // Private tiers only, with plain blobs so file names are predictable
+    qunsetenv("DSS_CACHE_SHARED");
+    qputenv("DSS_TILE_CODEC", "none");
+    QTemporaryDir dir;
+    const QString root = dir.path();
+
+    const QByteArray uniform(2048, '\x10');     // Stands in for a uniform JPEG
+    const QByteArray detailed = QByteArray("stars ") + QByteArray(2048, '\x7f');
+    const QRgb black = qRgb(0, 0, 0);
+    QString blankHash, detailedHash;
+
+    {
+        ContentStore store(root, QString(), "jpg");
+        blankHash = store.put("tile_pixel1", uniform);
+        detailedHash = store.put("tile_pixel2", detailed);
+        expectTrue("put returns the content hash", blankHash == ContentStore::hashOf(uniform) &&
+                                                   detailedHash == ContentStore::hashOf(detailed));
+
+        QRgb fill = 0x12345678;
+        expectTrue("unclassified hash is not blank", !store.isBlank(blankHash, &fill));
+        expectTrue("fill untouched when not blank", fill == 0x12345678);
+
+        store.markBlank(blankHash, black);
+        expectTrue("marked hash is blank", store.isBlank(blankHash, &fill) && fill == black);
+        expectTrue("other content stays not blank", !store.isBlank(detailedHash, nullptr));
+        expectTrue("null fill pointer accepted", store.isBlank(blankHash, nullptr));
+
+        // Same content under another key: one blob, one mark
+        expectTrue("deduplicated key shares the hash", store.put("tile_pixel3", uniform) == blankHash);
+        expectTrue("blank bytes still readable", store.get("tile_pixel3") == uniform);
+
+        // markBlank overrides an earlier not-blank verdict in this run
+        store.markNotBlank(detailedHash);
+        store.markBlank(detailedHash, qRgb(255, 255, 255));
+        QRgb white = 0;
+        expectTrue("markBlank after markNotBlank", store.isBlank(detailedHash, &white) &&
+                                                   white == qRgb(255, 255, 255));
+        store.flushLocal();
+    }
+
+    expectTrue("mark stored as a .fill file",
+               QFile::exists(root + "/blank/" + blankHash + ".fill"));
+
+    {
+        // A fresh store reads the marks back from disk
+        ContentStore store(root, QString(), "jpg");
+        QRgb fill = 0;
+        expectTrue("blank mark survives a restart", store.isBlank(blankHash, &fill) && fill == black);
+        expectTrue("reference survives a restart", store.referenceOf("tile_pixel3") == blankHash);
+
+        // Re-point both blank keys; the uniform blob and its mark become garbage
+        store.put("tile_pixel1", QByteArray("replaced one"));
+        store.put("tile_pixel3", QByteArray("replaced three"));
+        expectTrue("re-pointed references counted", store.supersededRefs() == 2);
+        store.flushLocal();
+        QThread::sleep(1);      // gc() keeps files as new as its cutoff
+        int removed = store.gc(0);
+        expectTrue("gc removes the blob and its mark", removed >= 2);
+        expectTrue("blank mark file removed", !QFile::exists(root + "/blank/" + blankHash + ".fill"));
+        expectTrue("live blank mark kept", QFile::exists(root + "/blank/" + detailedHash + ".fill"));
+        expectTrue("collected hash no longer blank", !store.isBlank(blankHash, nullptr));
+    }
+
+    {
+        // gc() reads every reference in one batch; with more references
+        // than the descriptor limit it must still find the garbage
+        QTemporaryDir many;
+        struct rlimit limit;
+        getrlimit(RLIMIT_NOFILE, &limit);
+        struct rlimit lowered = limit;
+        lowered.rlim_cur = std::min<rlim_t>(limit.rlim_cur, 256);
+        setrlimit(RLIMIT_NOFILE, &lowered);
+
+        const int refs = int(lowered.rlim_cur) * 2;
+        ContentStore store(many.path(), QString(), "jpg");
+        for (int i = 0; i < refs; ++i) {
+            store.put(QString("tile_pixel%1").arg(i), QByteArray("tile ") + QByteArray::number(i));
+        }
+        store.put("tile_pixel0", QByteArray("replaced"));
+        store.flushLocal();
+        QThread::sleep(1);
+        expectTrue(QString("gc over %1 references collects the orphan").arg(refs), store.gc(0) == 1);
+        expectTrue("live blobs survive a large gc", store.get(QString("tile_pixel%1").arg(refs - 1)) ==
+                                                    QByteArray("tile ") + QByteArray::number(refs - 1));
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    return testResult();
+}
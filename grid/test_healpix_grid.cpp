@@ -27,7 +27,7 @@ int main(int argc, char *argv[]) {
         qDebug() << "Center pixel:" << centerPixel;
         
         // Get the grid
-        QList<QList<long long>> grid = client.createProper3x3Grid(centerPixel, order);
+        TileGrid grid = client.createProper3x3Grid(centerPixel, order);
         
         // Verify alignment
         client.verifyGridAlignment(centerPixel, order);
@@ -0,0 +1,88 @@
+// test_survey_registry.cpp - Verify compiled tile URLs and survey config loading
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTemporaryDir>
+#include "GridTest.h"
+#include "SurveyRegistry.h"
+
+static HipsSurveyInfo survey(const QString& baseUrl, const QString& format = "jpg") {
+    return HipsSurveyInfo{"Test", baseUrl, format, QString(), true, 11, {"full_sky"}, 512};
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    qDebug() << "=== Survey Registry Tile URL Test ===\n";
+
+    SurveyRegistry registry;
+    SurveyId dss = registry.add("DSS2_Color", survey("http://alasky.u-strasbg.fr/DSS/DSSColor"));
+
+    // Default template: Dir is the pixel rounded down to a multiple of 10000
+    expect("order 8 tile", registry.tileUrl(dss, 8, 123456),
+           "http://alasky.u-strasbg.fr/DSS/DSSColor/Norder8/Dir120000/Npix123456.jpg");
+    expect("pixel below 10000", registry.tileUrl(dss, 3, 42),
+           "http://alasky.u-strasbg.fr/DSS/DSSColor/Norder3/Dir0/Npix42.jpg");
+    expect("pixel 0 of order 0", registry.tileUrl(dss, 0, 0),
+           "http://alasky.u-strasbg.fr/DSS/DSSColor/Norder0/Dir0/Npix0.jpg");
+    expect("largest order-11 pixel", registry.tileUrl(dss, 11, 12LL * (1LL << 22) - 1),
+           "http://alasky.u-strasbg.fr/DSS/DSSColor/Norder11/Dir50330000/Npix50331647.jpg");
+
+    // Invalid requests give an empty URL
+    expect("unknown handle", registry.tileUrl(SurveyId(7), 8, 1), QString());
+    expect("invalid handle", registry.tileUrl(SurveyRegistry::kInvalid, 8, 1), QString());
+    expect("negative pixel", registry.tileUrl(dss, 8, -1), QString());
+    expect("order above maxOrder", registry.tileUrl(dss, 12, 1), QString());
+    expect("negative order", registry.tileUrl(dss, -1, 1), QString());
+
+    // Custom templates: fields may repeat, literal text is kept as is
+    SurveyId custom = registry.add("Custom", survey("https://example.org/hips", "png"),
+                                   "{base}/{order}/{pixel}-{pixel}{dir}.{format}?v={unknown}");
+    expect("custom template", registry.tileUrl(custom, 5, 10001),
+           "https://example.org/hips/5/10001-1000110000.png?v={unknown}");
+
+    // A URL longer than the fixed buffer is refused rather than cut short
+    SurveyId huge = registry.add("Huge", survey("http://example.org/" + QString(SurveyRegistry::kMaxUrl, 'x')));
+    expect("URL over kMaxUrl", registry.tileUrl(huge, 8, 1), QString());
+
+    // Re-adding a key keeps its handle; a new source gets a new cache name
+    QString oldName = registry.cacheName(dss);
+    expectTrue("cache name starts with the key", oldName.startsWith("DSS2_Color-") && oldName.size() == 19);
+    SurveyId again = registry.add("DSS2_Color", survey("http://alasky.cds.unistra.fr/DSS/DSSColor"));
+    expectTrue("same handle on re-add", again == dss && registry.size() == 3);
+    expectTrue("cache name follows the source", registry.cacheName(dss) != oldName);
+    expect("re-added survey URL", registry.tileUrl(dss, 8, 1),
+           "http://alasky.cds.unistra.fr/DSS/DSSColor/Norder8/Dir0/Npix1.jpg");
+
+    // JSON config with a properties file supplying what the entry leaves out
+    QTemporaryDir dir;
+    QFile properties(dir.filePath("red.properties"));
+    properties.open(QIODevice::WriteOnly);
+    properties.write("# HiPS properties\n"
+                     "obs_title = DSS2 Red\n"
+                     "hips_order = 9\n"
+                     "hips_tile_width = 256\n"
+                     "hips_tile_format = jpeg fits\n"
+                     "hips_service_url = http://example.org/DSS2-red\n");
+    properties.close();
+    QFile config(dir.filePath("surveys.json"));
+    config.open(QIODevice::WriteOnly);
+    config.write(R"([{"key": "DSS2_Red", "properties": "red.properties"},
+                     {"key": "NoUrl"},
+                     {"key": "Flat", "url": "http://example.org/flat", "format": "png",
+                      "template": "{base}/{order}_{pixel}.{format}"}])");
+    config.close();
+
+    SurveyRegistry loaded;
+    expectTrue("two surveys loaded", loaded.loadConfig(config.fileName()) == 2);
+    SurveyId red = loaded.id("DSS2_Red");
+    expectTrue("properties applied", red != SurveyRegistry::kInvalid &&
+               loaded.info(red).name == "DSS2 Red" && loaded.info(red).maxOrder == 9 &&
+               loaded.info(red).tileWidth == 256);
+    expect("properties URL", loaded.tileUrl(red, 9, 20000),
+           "http://example.org/DSS2-red/Norder9/Dir20000/Npix20000.jpg");
+    expect("properties maxOrder", loaded.tileUrl(red, 10, 1), QString());
+    expectTrue("entry without URL skipped", !loaded.contains("NoUrl"));
+    expect("config template", loaded.tileUrl(loaded.id("Flat"), 4, 77), "http://example.org/flat/4_77.png");
+
+    return testResult();
+}
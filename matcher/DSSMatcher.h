@@ -10,6 +10,7 @@
 #include <QPixmap>
 #include <QFile>
 #include <QDebug>
+#include <QPointer>
 #include <functional>
 
 // DSS Survey types
@@ -31,6 +32,7 @@ enum class ImageFormat {
 };
 
 #include "ImageCache.h"
+#include "Async.h"
 
 class DSSImageMatcher : public QObject {
     Q_OBJECT
@@ -57,6 +59,24 @@ private:
         return (format == ImageFormat::FITS) ? "fits" : "gif";
     }
 
+    QUrl coordinateUrl(double ra, double dec, double widthArcmin, double heightArcmin,
+                       DSSurvey survey, ImageFormat format) const {
+        QUrl url(baseUrl);
+        QUrlQuery query;
+        
+        query.addQueryItem("r", QString::number(ra, 'f', 6));
+        query.addQueryItem("d", QString::number(dec, 'f', 6));
+        query.addQueryItem("e", "J2000");  // Equinox
+        query.addQueryItem("h", QString::number(heightArcmin, 'f', 2));
+        query.addQueryItem("w", QString::number(widthArcmin, 'f', 2));
+        query.addQueryItem("f", formatToString(format));
+        query.addQueryItem("v", surveyToString(survey));
+        query.addQueryItem("s", "on");  // Save to file
+        
+        url.setQuery(query);
+        return url;
+    }
+
 public:
     explicit DSSImageMatcher(QObject* parent = nullptr) 
         : QObject(parent), 
@@ -96,19 +116,7 @@ public:
             }
         }
               
-        QUrl url(baseUrl);
-        QUrlQuery query;
-        
-        query.addQueryItem("r", QString::number(ra, 'f', 6));
-        query.addQueryItem("d", QString::number(dec, 'f', 6));
-        query.addQueryItem("e", "J2000");  // Equinox
-        query.addQueryItem("h", QString::number(heightArcmin, 'f', 2));
-        query.addQueryItem("w", QString::number(widthArcmin, 'f', 2));
-        query.addQueryItem("f", formatToString(format));
-        query.addQueryItem("v", surveyToString(survey));
-        query.addQueryItem("s", "on");  // Save to file
-        
-        url.setQuery(query);
+        QUrl url = coordinateUrl(ra, dec, widthArcmin, heightArcmin, survey, format);
         
         qDebug() << "Fetching DSS image from:" << url.toString();
         
@@ -120,6 +128,93 @@ public:
         });
     }
 
+    // Future-returning FITS fetch. The cache is consulted and filled under
+    // the requested survey, so concurrent cutouts share no per-call state.
+    Async::Future<QByteArray> fetchCutout(ImageCache* cache,
+                                          double ra, double dec,
+                                          double widthArcmin, double heightArcmin,
+                                          DSSurvey survey,
+                                          const QString& objectName = QString()) {
+        QString surveyKey = cache->surveyKey(survey);
+        if (cache->isCached(ra, dec, widthArcmin, heightArcmin, surveyKey, "fits")) {
+            QByteArray cachedData = cache->getCachedImage(ra, dec, widthArcmin, heightArcmin,
+                                                          surveyKey, "fits");
+            if (!cachedData.isEmpty()) {
+                return Async::makeReady(cachedData);
+            }
+        }
+        
+        QUrl url = coordinateUrl(ra, dec, widthArcmin, heightArcmin, survey, ImageFormat::FITS);
+        qDebug() << "Fetching DSS cutout from:" << url.toString();
+        
+        Async::Promise<QByteArray> promise;
+        QPointer<ImageCache> cacheGuard(cache);
+        QNetworkReply* reply = networkManager->get(QNetworkRequest(url));
+        connect(reply, &QNetworkReply::finished, this,
+                [reply, promise, cacheGuard, ra, dec, widthArcmin, heightArcmin,
+                 surveyKey, objectName]() {
+            if (reply->error() == QNetworkReply::NoError) {
+                QByteArray data = reply->readAll();
+                if (cacheGuard && !data.isEmpty()) {
+                    cacheGuard->cacheImage(data, ra, dec, widthArcmin, heightArcmin,
+                                           surveyKey, "fits", objectName);
+                }
+                promise.setValue(data);
+            } else {
+                promise.setError(QString("Network error: %1").arg(reply->errorString()));
+            }
+            reply->deleteLater();
+        });
+        
+        return promise.future();
+    }
+
+    // Gaia DR3 stars (G, BP-RP) in a cone from VizieR, as TSV for
+    // PhotometricCalibrator::parseCatalog. Cached like cutouts.
+    Async::Future<QByteArray> fetchReferenceCatalog(ImageCache* cache,
+                                                    double ra, double dec,
+                                                    double radiusArcmin,
+                                                    double magLimit = 18.0) {
+        const QString catalogKey = "gaia_dr3";
+        double size = 2.0 * radiusArcmin;
+        if (cache->isCached(ra, dec, size, size, catalogKey, "tsv")) {
+            QByteArray cachedData = cache->getCachedImage(ra, dec, size, size, catalogKey, "tsv");
+            if (!cachedData.isEmpty()) {
+                return Async::makeReady(cachedData);
+            }
+        }
+
+        QUrl url("https://vizier.cds.unistra.fr/viz-bin/asu-tsv");
+        QUrlQuery query;
+        query.addQueryItem("-source", "I/355/gaiadr3");
+        query.addQueryItem("-c", QString("%1 %2").arg(ra, 0, 'f', 6).arg(dec, 0, 'f', 6));
+        query.addQueryItem("-c.rm", QString::number(radiusArcmin, 'f', 2));
+        query.addQueryItem("-out", "RA_ICRS,DE_ICRS,Gmag,BP-RP");
+        query.addQueryItem("Gmag", QString("<%1").arg(magLimit, 0, 'f', 1));
+        query.addQueryItem("-out.max", "20000");
+        url.setQuery(query);
+        qDebug() << "Fetching reference catalog from:" << url.toString();
+
+        Async::Promise<QByteArray> promise;
+        QPointer<ImageCache> cacheGuard(cache);
+        QNetworkReply* reply = networkManager->get(QNetworkRequest(url));
+        connect(reply, &QNetworkReply::finished, this,
+                [reply, promise, cacheGuard, ra, dec, size, catalogKey]() {
+            if (reply->error() == QNetworkReply::NoError) {
+                QByteArray data = reply->readAll();
+                if (cacheGuard && !data.isEmpty()) {
+                    cacheGuard->cacheImage(data, ra, dec, size, size, catalogKey, "tsv");
+                }
+                promise.setValue(data);
+            } else {
+                promise.setError(QString("Network error: %1").arg(reply->errorString()));
+            }
+            reply->deleteLater();
+        });
+
+        return promise.future();
+    }
+
     // Fetch DSS image by object name (uses SIMBAD/NED resolution)
     void fetchByObjectName(const QString& objectName,
                           double widthArcmin = 15.0,
@@ -0,0 +1,407 @@
+#ifndef DEFECTREJECTION_H
+#define DEFECTREJECTION_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include "Parallel.h"
+#include "Simd.h"
+
+struct DefectOptions {
+    // Hot/cold pixels: single-pixel spikes that recur at the same place
+    float spikeSigma = 6.0f;        // Spike height over the brightest neighbour, in sky sigmas
+    float spikeSharpness = 0.25f;   // Brightest neighbour must stay below this fraction of the spike
+    float hotFraction = 0.5f;       // Fraction of observed frames a hot pixel must spike in
+    int minFrames = 5;              // No hot-pixel map before this many frames
+
+    // Cosmic rays: L.A.Cosmic (van Dokkum 2001)
+    float sigmaClip = 4.5f;         // Laplacian significance for a cosmic-ray core
+    float sigmaFrac = 0.3f;         // Fraction of sigmaClip for neighbouring pixels
+    float objectLimit = 5.0f;       // Laplacian / fine-structure contrast separating stars
+    float gain = 1.0f;              // e-/ADU, for the Poisson term of the noise model
+    int iterations = 2;             // Detect/repair rounds
+
+    int threads = 0;                // 0 = one per core
+    int stripeRows = 64;
+};
+
+// Sorted flat pixel indices (y * width + x)
+using DefectList = std::vector<uint32_t>;
+
+// Finds detector defects before star detection and stacking, so hot pixels
+// and cosmic rays neither pass as stars nor leak into the combined image.
+// Every full-frame pass is a 3x3 stencil in SIMD over row stripes; the
+// expensive tests (medians, fine structure) only run at the few candidate
+// pixels that survive the stencil.
+class DefectRejector {
+public:
+    explicit DefectRejector(const DefectOptions& options = DefectOptions()) : options(options) {}
+
+    // Record this frame's isolated spikes and dips. Hot pixels are the ones
+    // recurring at the same sensor position; cosmic rays and stars move
+    // (or are not single-pixel) and never reach the fraction. Thread-safe.
+    void observe(const float* data, int width, int height, float sky, float sigma) {
+        if (width < 3 || height < 3) return;
+        {
+            // The first frame in claims the geometry. frames only counts
+            // finished frames, so it cannot tell concurrent first frames apart.
+            QMutexLocker locker(&mutex);
+            if (mapWidth == 0) {
+                mapWidth = width;
+                mapHeight = height;
+            } else if (width != mapWidth || height != mapHeight) {
+                return;     // different sensor geometry
+            }
+        }
+
+        const int stripeCount = (height - 2 + options.stripeRows - 1) / options.stripeRows;
+        std::vector<DefectList> hotStripes(stripeCount), coldStripes(stripeCount);
+        Parallel::forEach(stripeCount, Parallel::threadCount(options.threads), [&](int s) {
+            int y0 = 1 + s * options.stripeRows;
+            int y1 = std::min(height - 1, y0 + options.stripeRows);
+            findSpikes(data, width, y0, y1, sky, sigma, hotStripes[s], coldStripes[s]);
+        });
+
+        QMutexLocker locker(&mutex);
+        if (width != mapWidth || height != mapHeight) return;     // reset() meanwhile
+        for (const DefectList& list : hotStripes) {
+            for (uint32_t p : list) hotCounts[p]++;
+        }
+        for (const DefectList& list : coldStripes) {
+            for (uint32_t p : list) coldCounts[p]++;
+        }
+        frames++;
+    }
+
+    // Forget the hot-pixel statistics (e.g. camera or binning changed)
+    void reset() {
+        QMutexLocker locker(&mutex);
+        frames = 0;
+        mapWidth = mapHeight = 0;
+        hotCounts.clear();
+        coldCounts.clear();
+    }
+
+    int observedFrames() const {
+        QMutexLocker locker(&mutex);
+        return frames;
+    }
+
+    // Whether hotPixels() applies to frames of this size
+    bool mapMatches(int width, int height) const {
+        QMutexLocker locker(&mutex);
+        return frames > 0 && width == mapWidth && height == mapHeight;
+    }
+
+    // Pixels that spiked (or dipped) in at least hotFraction of the frames
+    DefectList hotPixels() const {
+        QMutexLocker locker(&mutex);
+        DefectList result;
+        if (frames < options.minFrames) return result;
+        int needed = std::max(2, int(std::ceil(options.hotFraction * frames)));
+        for (const auto& entry : hotCounts) {
+            if (entry.second >= needed) result.push_back(entry.first);
+        }
+        for (const auto& entry : coldCounts) {
+            if (entry.second >= needed) result.push_back(entry.first);
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    // Single-frame L.A.Cosmic: significance of the (2x subsampled, clipped)
+    // Laplacian against a Poisson + sky noise model, minus its 5x5 median;
+    // cores must also stand out from the fine structure that stars have.
+    // Neighbours of cores are added at a lower threshold.
+    DefectList detectCosmicRays(const float* data, int width, int height,
+                                float sky, float sigma) const {
+        DefectList result;
+        if (width < 2 * kBorder + 1 || height < 2 * kBorder + 1) return result;
+
+        const int first = kBorder;
+        const int last = height - kBorder;
+        const int stripeCount = (last - first + options.stripeRows - 1) / options.stripeRows;
+        std::vector<DefectList> stripes(stripeCount);
+        Parallel::forEach(stripeCount, Parallel::threadCount(options.threads), [&](int s) {
+            int y0 = first + s * options.stripeRows;
+            int y1 = std::min(last, y0 + options.stripeRows);
+            stripes[s] = cosmicsInStripe(data, width, height, y0, y1, sky, sigma);
+        });
+
+        for (const DefectList& list : stripes) {
+            result.insert(result.end(), list.begin(), list.end());
+        }
+        return result;
+    }
+
+    // Repair known hot pixels, then detect and repair cosmic rays for the
+    // configured number of rounds. Returns every pixel that was replaced.
+    DefectList clean(float* data, int width, int height, float sky, float sigma) const {
+        DefectList defects = mapMatches(width, height) ? hotPixels() : DefectList();
+        repair(data, width, height, 0, 0, width, defects);
+
+        for (int round = 0; round < options.iterations; ++round) {
+            DefectList found = detectCosmicRays(data, width, height, sky, sigma);
+            DefectList added;
+            std::set_difference(found.begin(), found.end(), defects.begin(), defects.end(),
+                                std::back_inserter(added));
+            if (added.empty()) break;
+            repair(data, width, height, 0, 0, width, added);
+            defects = merge(defects, added);
+        }
+        return defects;
+    }
+
+    // Replace each defect inside a window of a frame with the median of its
+    // good 5x5 neighbours. The window covers frame columns [x0, x0 + w) and
+    // rows [y0, y0 + h); defects use frame indices (frameWidth wide), so the
+    // same list serves full frames and the sub-rectangles read per strip.
+    static void repair(float* window, int w, int h, int x0, int y0, int frameWidth,
+                       const DefectList& defects) {
+        auto begin = std::lower_bound(defects.begin(), defects.end(), uint32_t(y0) * frameWidth);
+        auto end = std::lower_bound(begin, defects.end(), uint32_t(y0 + h) * frameWidth);
+        float values[25];
+        for (auto it = begin; it != end; ++it) {
+            int x = int(*it % frameWidth) - x0;
+            int y = int(*it / frameWidth) - y0;
+            if (x < 0 || x >= w) continue;
+
+            int count = 0;
+            for (int dy = -2; dy <= 2; ++dy) {
+                int ny = y + dy;
+                if (ny < 0 || ny >= h) continue;
+                for (int dx = -2; dx <= 2; ++dx) {
+                    int nx = x + dx;
+                    if (nx < 0 || nx >= w || (dx == 0 && dy == 0)) continue;
+                    uint32_t index = uint32_t(ny + y0) * frameWidth + uint32_t(nx + x0);
+                    if (std::binary_search(defects.begin(), defects.end(), index)) continue;
+                    float v = window[size_t(ny) * w + nx];
+                    if (std::isfinite(v)) values[count++] = v;
+                }
+            }
+            if (count == 0) continue;
+            std::nth_element(values, values + count / 2, values + count);
+            window[size_t(y) * w + x] = values[count / 2];
+        }
+    }
+
+    static DefectList merge(const DefectList& a, const DefectList& b) {
+        DefectList result;
+        result.reserve(a.size() + b.size());
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+        return result;
+    }
+
+private:
+    // Rows/columns kept clear of the edge: med7 of med3 reaches 4 pixels out
+    static constexpr int kBorder = 4;
+
+    DefectOptions options;
+
+    mutable QMutex mutex;
+    int frames = 0;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    std::unordered_map<uint32_t, int> hotCounts;
+    std::unordered_map<uint32_t, int> coldCounts;
+
+    // Pixels above all 8 neighbours by spikeSigma while the brightest
+    // neighbour stays near the sky (hot), or below all of them (cold)
+    void findSpikes(const float* data, int width, int y0, int y1, float sky, float sigma,
+                    DefectList& hot, DefectList& cold) const {
+        const simd::f4 skyV = simd::splat(sky);
+        const simd::f4 threshold = simd::splat(options.spikeSigma * sigma);
+        const simd::f4 sharpness = simd::splat(options.spikeSharpness);
+
+        for (int y = y0; y < y1; ++y) {
+            const float* up = data + size_t(y - 1) * width;
+            const float* row = data + size_t(y) * width;
+            const float* down = data + size_t(y + 1) * width;
+
+            int x = 1;
+            for (; x + 4 <= width - 1; x += 4) {
+                simd::f4 v = simd::load(row + x);
+                simd::f4 a = simd::load(up + x - 1), b = simd::load(up + x), c = simd::load(up + x + 1);
+                simd::f4 d = simd::load(row + x - 1), e = simd::load(row + x + 1);
+                simd::f4 f = simd::load(down + x - 1), g = simd::load(down + x), h = simd::load(down + x + 1);
+                simd::f4 hi = simd::max(simd::max(simd::max(a, b), simd::max(c, d)),
+                                        simd::max(simd::max(e, f), simd::max(g, h)));
+                simd::f4 lo = simd::min(simd::min(simd::min(a, b), simd::min(c, d)),
+                                        simd::min(simd::min(e, f), simd::min(g, h)));
+
+                simd::f4 isHot = simd::maskAnd(simd::greater(v - hi, threshold),
+                                               simd::less(hi - skyV, sharpness * (v - skyV)));
+                simd::f4 isCold = simd::greater(lo - v, threshold);
+                int hotBits = simd::movemask(isHot);
+                int coldBits = simd::movemask(isCold);
+                for (int lane = 0; lane < 4; ++lane) {
+                    if (hotBits & (1 << lane)) hot.push_back(uint32_t(y) * width + x + lane);
+                    if (coldBits & (1 << lane)) cold.push_back(uint32_t(y) * width + x + lane);
+                }
+            }
+            for (; x < width - 1; ++x) {
+                float v = row[x];
+                float hi = -INFINITY, lo = INFINITY;
+                for (int dx = -1; dx <= 1; ++dx) {
+                    hi = std::max({hi, up[x + dx], down[x + dx]});
+                    lo = std::min({lo, up[x + dx], down[x + dx]});
+                }
+                hi = std::max({hi, row[x - 1], row[x + 1]});
+                lo = std::min({lo, row[x - 1], row[x + 1]});
+                float spike = options.spikeSigma * sigma;
+                if (v - hi > spike && hi - sky < options.spikeSharpness * (v - sky)) {
+                    hot.push_back(uint32_t(y) * width + x);
+                }
+                if (lo - v > spike) cold.push_back(uint32_t(y) * width + x);
+            }
+        }
+    }
+
+    // L+ of one pixel: the Laplacian of the image block-replicated 2x,
+    // clipped at zero per sub-pixel and averaged back. Each sub-pixel sees
+    // the pixel itself twice and two of its four direct neighbours.
+    static float laplacianPlus(const float* data, int width, int x, int y) {
+        const float* row = data + size_t(y) * width;
+        float v2 = 2.0f * row[x];
+        float l = row[x - 1], r = row[x + 1], u = row[x - width], d = row[x + width];
+        return 0.25f * (std::max(0.0f, v2 - l - u) + std::max(0.0f, v2 - r - u) +
+                        std::max(0.0f, v2 - l - d) + std::max(0.0f, v2 - r - d));
+    }
+
+    // S = L+ / (2 N) for rows [ya, yb), N from sky noise plus the Poisson
+    // noise of the local (3x3 mean) signal. out holds (yb - ya) rows.
+    void significanceRows(const float* data, int width, int ya, int yb,
+                          float sky, float sigma, float* out) const {
+        const simd::f4 zero = simd::splat(0.0f);
+        const simd::f4 quarter = simd::splat(0.25f);
+        const simd::f4 ninth = simd::splat(1.0f / 9.0f);
+        const simd::f4 skyV = simd::splat(sky);
+        const simd::f4 variance = simd::splat(sigma * sigma);
+        const simd::f4 invGain = simd::splat(1.0f / std::max(options.gain, 1e-3f));
+        const simd::f4 half = simd::splat(0.5f);
+        const float invGainScalar = 1.0f / std::max(options.gain, 1e-3f);
+
+        for (int y = ya; y < yb; ++y) {
+            const float* up = data + size_t(y - 1) * width;
+            const float* row = data + size_t(y) * width;
+            const float* down = data + size_t(y + 1) * width;
+            float* dst = out + size_t(y - ya) * width;
+            dst[0] = dst[width - 1] = 0.0f;
+
+            int x = 1;
+            for (; x + 4 <= width - 1; x += 4) {
+                simd::f4 v = simd::load(row + x);
+                simd::f4 l = simd::load(row + x - 1), r = simd::load(row + x + 1);
+                simd::f4 u = simd::load(up + x), d = simd::load(down + x);
+                simd::f4 v2 = v + v;
+                simd::f4 lap = quarter * (simd::max(zero, v2 - l - u) + simd::max(zero, v2 - r - u) +
+                                          simd::max(zero, v2 - l - d) + simd::max(zero, v2 - r - d));
+
+                simd::f4 mean = ninth * (v + l + r + u + d +
+                                         simd::load(up + x - 1) + simd::load(up + x + 1) +
+                                         simd::load(down + x - 1) + simd::load(down + x + 1));
+                simd::f4 noise = simd::sqrt(variance + simd::max(zero, mean - skyV) * invGain);
+                simd::store(dst + x, half * lap / noise);
+            }
+            for (; x < width - 1; ++x) {
+                float mean = 0;
+                for (int dx = -1; dx <= 1; ++dx) mean += up[x + dx] + row[x + dx] + down[x + dx];
+                mean /= 9.0f;
+                float noise = std::sqrt(sigma * sigma + std::max(0.0f, mean - sky) * invGainScalar);
+                dst[x] = 0.5f * laplacianPlus(data, width, x, y) / noise;
+            }
+        }
+    }
+
+    static float median3x3(const float* data, int width, int x, int y) {
+        float values[9];
+        int n = 0;
+        for (int dy = -1; dy <= 1; ++dy) {
+            const float* row = data + size_t(y + dy) * width;
+            for (int dx = -1; dx <= 1; ++dx) values[n++] = row[x + dx];
+        }
+        std::nth_element(values, values + 4, values + 9);
+        return values[4];
+    }
+
+    DefectList cosmicsInStripe(const float* data, int width, int height, int y0, int y1,
+                               float sky, float sigma) const {
+        // Cores are also found one row beyond the stripe on each side, so
+        // growth into this stripe's rows sees cores owned by its neighbours.
+        // S is needed two rows further out again for the 5x5 median.
+        const int coreLo = std::max(kBorder, y0 - 1);
+        const int coreHi = std::min(height - kBorder, y1 + 1);
+        const int sLo = coreLo - 2;
+        const int sHi = coreHi + 2;
+        std::vector<float> s(size_t(sHi - sLo) * width);
+        significanceRows(data, width, sLo, sHi, sky, sigma, s.data());
+
+        auto sAt = [&](int x, int y) { return s[size_t(y - sLo) * width + x]; };
+        auto sharpness = [&](int x, int y) {
+            // S minus its 5x5 median removes smooth large-scale structure
+            float values[25];
+            int n = 0;
+            for (int dy = -2; dy <= 2; ++dy) {
+                for (int dx = -2; dx <= 2; ++dx) values[n++] = sAt(x + dx, y + dy);
+            }
+            std::nth_element(values, values + 12, values + 25);
+            return sAt(x, y) - values[12];
+        };
+
+        const float clip = options.sigmaClip;
+        std::vector<uint32_t> cores;
+        for (int y = coreLo; y < coreHi; ++y) {
+            const float* srow = s.data() + size_t(y - sLo) * width;
+            for (int x = kBorder; x < width - kBorder; ++x) {
+                if (!(srow[x] > clip)) continue;
+                if (!(sharpness(x, y) > clip)) continue;
+
+                // Fine structure: med3 minus med7 of med3. Stars are smooth
+                // at the 3-pixel scale and have a large F; cosmic rays do not.
+                float center = median3x3(data, width, x, y);
+                float around[49];
+                int n = 0;
+                for (int dy = -3; dy <= 3; ++dy) {
+                    for (int dx = -3; dx <= 3; ++dx) {
+                        around[n++] = median3x3(data, width, x + dx, y + dy);
+                    }
+                }
+                std::nth_element(around, around + 24, around + 49);
+                float fine = std::max(center - around[24], 0.01f);
+                if (laplacianPlus(data, width, x, y) / fine > options.objectLimit) {
+                    cores.push_back(uint32_t(y) * width + x);
+                }
+            }
+        }
+
+        DefectList result;
+        const float growClip = clip * options.sigmaFrac;
+        for (uint32_t core : cores) {
+            int cx = int(core % width);
+            int cy = int(core / width);
+            for (int dy = -1; dy <= 1; ++dy) {
+                int y = cy + dy;
+                if (y < y0 || y >= y1) continue;
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int x = cx + dx;
+                    if (x < kBorder || x >= width - kBorder) continue;
+                    uint32_t index = uint32_t(y) * width + x;
+                    bool isCore = (dx == 0 && dy == 0) ||
+                                  std::binary_search(cores.begin(), cores.end(), index);
+                    if (isCore || sharpness(x, y) > growClip) result.push_back(index);
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+};
+
+#endif // DEFECTREJECTION_H
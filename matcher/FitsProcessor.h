@@ -7,6 +7,12 @@
 #include <fitsio.h>
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include "MemoryBudget.h"
+#include "Async.h"
+#include "StarMatcher.h"
+#include "DefectRejection.h"
+#include "SphericalGeometry.h"
 
 // WCS coordinate structure
 struct WCSInfo {
@@ -59,6 +65,29 @@ struct WCSInfo {
         while (ra >= 360.0) ra -= 360.0;
     }
     
+    // pixelToWorld for many positions at once with the batch kernels of
+    // SphericalGeometry.h (~0.1"). Uses the exact gnomonic inverse, so it
+    // round-trips with worldToPixel.
+    void pixelsToWorld(const std::vector<double>& x, const std::vector<double>& y,
+                       std::vector<double>& ra, std::vector<double>& dec) const {
+        const int n = int(x.size());
+        ra.assign(x.size(), 0.0);
+        dec.assign(x.size(), 0.0);
+        if (!isValid || n == 0) return;
+        
+        double theta = crota2 * M_PI / 180.0;
+        std::vector<float> xi(n), eta(n), vx(n), vy(n), vz(n);
+        for (int i = 0; i < n; ++i) {
+            double dx = (x[i] - crpix1) * cdelt1;
+            double dy = (y[i] - crpix2) * cdelt2;
+            xi[i] = float((dx * cos(theta) - dy * sin(theta)) * M_PI / 180.0);
+            eta[i] = float((dx * sin(theta) + dy * cos(theta)) * M_PI / 180.0);
+        }
+        spherical::gnomonicInverse(spherical::Rotation::tangentFrame(crval1, crval2),
+                                   xi.data(), eta.data(), n, vx.data(), vy.data(), vz.data());
+        spherical::vectorsToRaDec(vx.data(), vy.data(), vz.data(), n, ra.data(), dec.data());
+    }
+    
     // Convert RA/Dec to pixel coordinates
     void worldToPixel(double ra, double dec, double& x, double& y) const {
         if (!isValid) return;
@@ -116,6 +145,17 @@ struct PSFModel {
                  beta(2.5), modelType("gaussian") {}
 };
 
+// Pixels and WCS decoded from an in-memory FITS file
+struct DecodedFits {
+    std::vector<float> data;
+    int width;
+    int height;
+    WCSInfo wcs;
+    bool ok;
+    
+    DecodedFits() : width(0), height(0), ok(false) {}
+};
+
 class FitsProcessor : public QObject {
     Q_OBJECT
 
@@ -169,8 +209,94 @@ public:
         return true;
     }
     
+    // Decode FITS bytes (e.g. a DSS cutout) into float pixels and WCS
+    static DecodedFits decodeFitsData(const QByteArray& fitsData) {
+        DecodedFits result;
+        if (fitsData.isEmpty()) return result;
+        
+        fitsfile* fptr = nullptr;
+        int status = 0;
+        
+        // CFITSIO requires a non-const memory pointer
+        QByteArray mutableData = fitsData;
+        size_t memsize = mutableData.size();
+        void* (*mem_realloc)(void*, size_t) = nullptr;
+        char* data = mutableData.data();
+        
+        if (fits_open_memfile(&fptr, "memory.fits", READONLY,
+                             (void**)&data, &memsize, 0, mem_realloc, &status)) {
+            fits_report_error(stderr, status);
+            return result;
+        }
+        
+        int naxis = 0;
+        long naxes[3] = {1, 1, 1};
+        fits_get_img_dim(fptr, &naxis, &status);
+        fits_get_img_size(fptr, 3, naxes, &status);
+        
+        if (naxis < 2) {
+            fits_close_file(fptr, &status);
+            return result;
+        }
+        
+        result.width = naxes[0];
+        result.height = naxes[1];
+        result.wcs = readWCS(fptr);
+        
+        long npixels = long(result.width) * result.height;
+        result.data.resize(npixels);
+        
+        long fpixel[3] = {1, 1, 1};
+        if (fits_read_pix(fptr, TFLOAT, fpixel, npixels, nullptr,
+                         result.data.data(), nullptr, &status)) {
+            fits_report_error(stderr, status);
+            fits_close_file(fptr, &status);
+            result.data.clear();
+            return result;
+        }
+        
+        fits_close_file(fptr, &status);
+        result.ok = true;
+        return result;
+    }
+    
+    // Decode on the thread pool (CFITSIO must be built reentrant, the default
+    // for current releases); fails if the bytes are not a 2D FITS image
+    static Async::Future<DecodedFits> decodeFits(const QByteArray& fitsData) {
+        return Async::run([fitsData]() {
+            return decodeFitsData(fitsData);
+        }).then(nullptr, [](const DecodedFits& decoded) {
+            if (!decoded.ok) {
+                return Async::makeFailed<DecodedFits>("Failed to decode FITS data");
+            }
+            return Async::makeReady(decoded);
+        });
+    }
+    
+    // Min/max stretch to 8-bit grayscale, in FITS row order (not mirrored)
+    static QImage toGrayscaleImage(const DecodedFits& decoded) {
+        if (!decoded.ok || decoded.data.empty()) return QImage();
+        
+        auto [minIt, maxIt] = std::minmax_element(decoded.data.begin(), decoded.data.end());
+        float minVal = *minIt;
+        float maxVal = *maxIt;
+        if (minVal == maxVal) maxVal = minVal + 1.0f;
+        const float scale = 255.0f / (maxVal - minVal);
+        
+        QImage img(decoded.width, decoded.height, QImage::Format_Grayscale8);
+        for (int y = 0; y < decoded.height; ++y) {
+            uchar* scan = img.scanLine(y);
+            const float* row = decoded.data.data() + size_t(y) * decoded.width;
+            for (int x = 0; x < decoded.width; ++x) {
+                int scaled = int((row[x] - minVal) * scale + 0.5f);
+                scan[x] = uchar(qBound(0, scaled, 255));
+            }
+        }
+        return img;
+    }
+    
     // Extract WCS from FITS header
-    WCSInfo readWCS(fitsfile* fptr) {
+    static WCSInfo readWCS(fitsfile* fptr) {
         WCSInfo wcs;
         int status = 0;
         char comment[FLEN_COMMENT];
@@ -225,7 +351,8 @@ public:
         std::vector<double> xSamples, ySamples, zSamples;
         
         // Calculate median and MAD for outlier rejection
-        std::vector<float> sortedData = data;
+        std::vector<float> sortedData = sampleForStatistics(data);
+        MemoryCharge scratch(MemoryStage::FitsProcessing, sortedData.size() * sizeof(float));
         std::nth_element(sortedData.begin(), 
                         sortedData.begin() + sortedData.size()/2, 
                         sortedData.end());
@@ -300,8 +427,21 @@ public:
     PSFModel estimatePSF(const std::vector<float>& data, int width, int height) {
         PSFModel psf;
         
+        // Hot pixels and cosmic rays are sharper than any star and would win
+        // the peak search below, so they are skipped as peaks and repaired
+        // in a small window around each star before its profile is measured
+        DefectList defects;
+        float sky, noise;
+        if (StarMatcher::estimateBackground(data.data(), data.size(), sky, noise)) {
+            defects = DefectRejector().detectCosmicRays(data.data(), width, height, sky, noise);
+        }
+        auto isDefect = [&defects](int idx) {
+            return std::binary_search(defects.begin(), defects.end(), uint32_t(idx));
+        };
+        
         // Find bright, isolated stars
-        std::vector<float> sortedData = data;
+        std::vector<float> sortedData = sampleForStatistics(data);
+        MemoryCharge scratch(MemoryStage::FitsProcessing, sortedData.size() * sizeof(float));
         std::nth_element(sortedData.begin(), 
                         sortedData.begin() + sortedData.size()*99/100,
                         sortedData.end());
@@ -313,14 +453,14 @@ public:
         for (int y = 20; y < height - 20; ++y) {
             for (int x = 20; x < width - 20; ++x) {
                 int idx = y * width + x;
-                if (data[idx] > threshold) {
+                if (data[idx] > threshold && !isDefect(idx)) {
                     // Check if local maximum
                     bool isMax = true;
                     for (int dy = -2; dy <= 2 && isMax; ++dy) {
                         for (int dx = -2; dx <= 2; ++dx) {
                             if (dx == 0 && dy == 0) continue;
                             int nidx = (y+dy)*width + (x+dx);
-                            if (data[nidx] > data[idx]) {
+                            if (data[nidx] > data[idx] && !isDefect(nidx)) {
                                 isMax = false;
                                 break;
                             }
@@ -335,13 +475,25 @@ public:
         
         // Measure FWHM from radial profiles
         std::vector<double> fwhms;
+        const int radius = 20;
+        const int side = 2 * radius + 1;
+        std::vector<float> window(size_t(side) * side);
         
         for (const auto& center : starCenters) {
             if (fwhms.size() >= 50) break;  // Use up to 50 stars
             
-            int cx = center.first;
-            int cy = center.second;
-            float peak = data[cy * width + cx];
+            // Peaks are at least 20 pixels from the edges, so the window fits
+            int x0 = center.first - radius;
+            int y0 = center.second - radius;
+            for (int wy = 0; wy < side; ++wy) {
+                std::copy_n(data.data() + size_t(y0 + wy) * width + x0, side,
+                            window.data() + size_t(wy) * side);
+            }
+            DefectRejector::repair(window.data(), side, side, x0, y0, width, defects);
+            
+            int cx = radius;
+            int cy = radius;
+            float peak = window[cy * side + cx];
             float half = peak / 2.0f;
             
             // Measure radius at half maximum
@@ -356,8 +508,8 @@ public:
                 for (double r = 1; r < 20; r += 0.5) {
                     int x = cx + r * dx;
                     int y = cy + r * dy;
-                    if (x >= 0 && x < width && y >= 0 && y < height) {
-                        float val = data[y * width + x];
+                    if (x >= 0 && x < side && y >= 0 && y < side) {
+                        float val = window[y * side + x];
                         if (val < half) {
                             fwhm += r * 2.0;
                             count++;
@@ -384,6 +536,24 @@ public:
     }
     
 private:
+    // Copy of the pixels for order statistics. When the memory budget is
+    // tight, take every 16th pixel instead of a full-frame copy; median, MAD
+    // and the 99th percentile are barely affected by the subsampling.
+    std::vector<float> sampleForStatistics(const std::vector<float>& data) const {
+        size_t bytes = data.size() * sizeof(float);
+        if (!MemoryAccounting::instance().shouldStream(bytes)) {
+            return data;
+        }
+        
+        const size_t stride = 16;
+        std::vector<float> sample;
+        sample.reserve(data.size() / stride + 1);
+        for (size_t i = 0; i < data.size(); i += stride) {
+            sample.push_back(data[i]);
+        }
+        return sample;
+    }
+    
     // Solve linear system using normal equations
     std::vector<double> solveLinearSystem(const std::vector<std::vector<double>>& A,
                                          const std::vector<double>& b) {
@@ -0,0 +1,313 @@
+#ifndef FRAMEQUALITYSCORER_H
+#define FRAMEQUALITYSCORER_H
+
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QTextStream>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDebug>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include "FitsProcessor.h"
+#include "MemoryBudget.h"
+#include "StarMatcher.h"
+#include "DefectRejection.h"
+#include "Parallel.h"
+
+struct QualityOptions {
+    int tileSize = 128;             // Background/noise statistics per tile of this size
+    int tileStride = 4;             // Sample every Nth pixel and row inside a tile
+    int maxStars = 100;             // Brightest stars measured for FWHM/eccentricity
+    int measureRadius = 7;          // Moment window half-size in pixels
+    bool rejectDefects = true;      // Repair cosmic rays/hot pixels before detection
+    int threads = 0;                // Frames in flight; 0 = one per core
+
+    // Rejection against the set: median + kappa * MAD (robust sigma)
+    float kappa = 3.0f;
+    double maxEccentricity = 0.6;   // Elongated stars: trailing or wind shake
+    double minStarFraction = 0.5;   // Of the median star count: cloud, dew
+};
+
+// One compact record per frame
+struct FrameQuality {
+    QString path;
+    bool ok = false;
+    int width = 0;
+    int height = 0;
+    float background = 0.0f;    // Median of tile medians (ADU)
+    float gradient = 0.0f;      // Spread of tile medians, max - min (ADU)
+    float noise = 0.0f;         // Median of tile MADs, as sigma (ADU)
+    int stars = 0;
+    double fwhm = 0.0;          // Median over measured stars (pixels)
+    double eccentricity = 0.0;  // Median over measured stars, 0 = round
+    double score = 0.0;         // Relative to the best frame of the set, 0..1
+    bool rejected = false;
+    QString reason;
+};
+
+// Ranks a large set of frames (a night's worth) by seeing, tracking,
+// transparency and sky. Frames are streamed through a fixed number of
+// workers, one frame in memory per worker, and each costs one read, one
+// strided statistics pass and one detection pass. Call rank() on the
+// records afterwards to score and reject against the whole set.
+class FrameQualityScorer {
+public:
+    using RecordCallback = std::function<void(const FrameQuality& record, int done, int total)>;
+
+    explicit FrameQualityScorer(const QualityOptions& options = QualityOptions()) : options(options) {}
+
+    // Records come back in input order; onRecord fires as each frame
+    // finishes (on a worker thread, serialised)
+    std::vector<FrameQuality> score(const QStringList& files, RecordCallback onRecord = nullptr) const {
+        std::vector<FrameQuality> records(files.size());
+        QMutex callbackMutex;
+        std::atomic<int> done{0};
+
+        Parallel::forEach(files.size(), Parallel::threadCount(options.threads), [&](int i) {
+            records[i] = scoreFile(files[i]);
+            if (onRecord) {
+                QMutexLocker locker(&callbackMutex);
+                onRecord(records[i], ++done, files.size());
+            }
+        });
+        return records;
+    }
+
+    FrameQuality scoreFile(const QString& path) const {
+        FrameQuality record;
+        record.path = path;
+
+        std::vector<float> data;
+        WCSInfo wcs;
+        FitsProcessor reader;
+        if (!reader.loadFits(path, data, record.width, record.height, wcs)) {
+            record.reason = "unreadable";
+            return record;
+        }
+        MemoryCharge frameCharge(MemoryStage::FitsDecode, data.size() * sizeof(float));
+        return scoreData(std::move(data), record.width, record.height, path);
+    }
+
+    // Takes the frame by value: defects are repaired in place
+    FrameQuality scoreData(std::vector<float> data, int width, int height,
+                           const QString& path = QString()) const {
+        FrameQuality record;
+        record.path = path;
+        record.width = width;
+        record.height = height;
+
+        if (!tileStatistics(data.data(), width, height, record)) {
+            record.reason = "empty";
+            return record;
+        }
+
+        if (options.rejectDefects) {
+            DefectOptions defectOptions;
+            defectOptions.threads = 1;      // parallel over frames already
+            defectOptions.iterations = 1;
+            DefectList defects = DefectRejector(defectOptions)
+                .detectCosmicRays(data.data(), width, height, record.background, record.noise);
+            DefectRejector::repair(data.data(), width, height, 0, 0, width, defects);
+        }
+
+        // Count every detection (transparency), measure only the brightest
+        StarMatcher detector;
+        detector.maxStars = std::numeric_limits<int>::max();
+        std::vector<StarMatcher::Star> stars =
+            detector.detectStars(data.data(), width, height, record.background,
+                                 record.background + 5.0f * record.noise);
+        record.stars = stars.size();
+        if (int(stars.size()) > options.maxStars) stars.resize(options.maxStars);
+        measureStars(data.data(), width, height, record.background, stars, record);
+        record.ok = true;
+        return record;
+    }
+
+    // Score every readable frame against the set and flag outliers
+    static void rank(std::vector<FrameQuality>& records,
+                     const QualityOptions& options = QualityOptions()) {
+        std::vector<double> fwhm, noise, background, stars;
+        for (const FrameQuality& r : records) {
+            if (!r.ok) continue;
+            if (r.fwhm > 0) fwhm.push_back(r.fwhm);
+            noise.push_back(r.noise);
+            background.push_back(r.background);
+            stars.push_back(r.stars);
+        }
+        if (stars.empty()) return;
+
+        double fwhmMedian, fwhmSigma, noiseMedian, noiseSigma, bgMedian, bgSigma, starsMedian, starsSigma;
+        robustStats(fwhm, fwhmMedian, fwhmSigma);
+        robustStats(noise, noiseMedian, noiseSigma);
+        robustStats(background, bgMedian, bgSigma);
+        robustStats(stars, starsMedian, starsSigma);
+
+        // Higher is better: more detected stars, sharper, less noise
+        double best = 0;
+        for (FrameQuality& r : records) {
+            if (!r.ok || r.fwhm <= 0 || r.noise <= 0) continue;
+            r.score = r.stars / (r.fwhm * r.fwhm * r.noise);
+            best = std::max(best, r.score);
+        }
+
+        for (FrameQuality& r : records) {
+            if (!r.ok) {
+                r.rejected = true;
+                if (r.reason.isEmpty()) r.reason = "unreadable";
+                continue;
+            }
+            if (best > 0) r.score /= best;
+
+            QStringList reasons;
+            if (r.stars < 3 || r.fwhm <= 0) reasons << "no stars";
+            else if (r.stars < options.minStarFraction * starsMedian) reasons << "few stars";
+            if (r.fwhm > fwhmMedian + options.kappa * fwhmSigma) reasons << "soft";
+            if (r.eccentricity > options.maxEccentricity) reasons << "elongated";
+            if (r.background > bgMedian + options.kappa * bgSigma) reasons << "bright sky";
+            if (r.noise > noiseMedian + options.kappa * noiseSigma) reasons << "noisy";
+            r.rejected = !reasons.isEmpty();
+            r.reason = reasons.join(", ");
+        }
+    }
+
+    static bool writeCsv(const QString& filename, const std::vector<FrameQuality>& records) {
+        QFile file(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qDebug() << "Failed to write quality report:" << filename;
+            return false;
+        }
+        QTextStream out(&file);
+        out << "path,width,height,background,gradient,noise,stars,fwhm,eccentricity,score,rejected,reason\n";
+        for (const FrameQuality& r : records) {
+            out << quoted(r.path) << ','
+                << r.width << ',' << r.height << ','
+                << QString::number(r.background, 'f', 2) << ','
+                << QString::number(r.gradient, 'f', 2) << ','
+                << QString::number(r.noise, 'f', 3) << ','
+                << r.stars << ','
+                << QString::number(r.fwhm, 'f', 2) << ','
+                << QString::number(r.eccentricity, 'f', 3) << ','
+                << QString::number(r.score, 'f', 4) << ','
+                << (r.rejected ? 1 : 0) << ','
+                << quoted(r.reason) << '\n';
+        }
+        return true;
+    }
+
+private:
+    QualityOptions options;
+
+    // CSV field in quotes, embedded quotes doubled (RFC 4180)
+    static QString quoted(QString text) {
+        return "\"" + text.replace('"', "\"\"") + "\"";
+    }
+
+    // Median and MAD per tile on a strided sample, then medians across
+    // tiles: stars and gradients barely move either number
+    bool tileStatistics(const float* data, int width, int height, FrameQuality& record) const {
+        const int tile = std::max(16, options.tileSize);
+        const int stride = std::max(1, options.tileStride);
+        std::vector<float> medians, mads, sample;
+        sample.reserve(size_t(tile / stride + 1) * (tile / stride + 1));
+
+        for (int ty = 0; ty + tile / 2 <= height; ty += tile) {
+            for (int tx = 0; tx + tile / 2 <= width; tx += tile) {
+                sample.clear();
+                int yEnd = std::min(height, ty + tile);
+                int xEnd = std::min(width, tx + tile);
+                for (int y = ty; y < yEnd; y += stride) {
+                    const float* row = data + size_t(y) * width;
+                    for (int x = tx; x < xEnd; x += stride) {
+                        if (std::isfinite(row[x])) sample.push_back(row[x]);
+                    }
+                }
+                if (sample.size() < 16) continue;
+                size_t mid = sample.size() / 2;
+                std::nth_element(sample.begin(), sample.begin() + mid, sample.end());
+                float median = sample[mid];
+                for (float& v : sample) v = std::abs(v - median);
+                std::nth_element(sample.begin(), sample.begin() + mid, sample.end());
+                medians.push_back(median);
+                mads.push_back(sample[mid] * 1.4826f);
+            }
+        }
+        if (medians.empty()) return false;
+
+        auto [lo, hi] = std::minmax_element(medians.begin(), medians.end());
+        record.gradient = *hi - *lo;
+        std::nth_element(medians.begin(), medians.begin() + medians.size() / 2, medians.end());
+        std::nth_element(mads.begin(), mads.begin() + mads.size() / 2, mads.end());
+        record.background = medians[medians.size() / 2];
+        record.noise = std::max(mads[mads.size() / 2], 1e-6f);
+        return true;
+    }
+
+    // Background-subtracted second moments in a window around each star:
+    // FWHM from the mean Gaussian sigma, eccentricity from the axis ratio
+    void measureStars(const float* data, int width, int height, float background,
+                      const std::vector<StarMatcher::Star>& stars, FrameQuality& record) const {
+        const int r = options.measureRadius;
+        std::vector<double> fwhms, eccentricities;
+        for (const StarMatcher::Star& star : stars) {
+            int cx = int(std::lround(star.x));
+            int cy = int(std::lround(star.y));
+            if (cx < r || cy < r || cx >= width - r || cy >= height - r) continue;
+
+            double sum = 0, sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+            for (int dy = -r; dy <= r; ++dy) {
+                const float* row = data + size_t(cy + dy) * width;
+                for (int dx = -r; dx <= r; ++dx) {
+                    double w = row[cx + dx] - background;
+                    if (!(w > 0)) continue;
+                    double px = cx + dx - star.x;
+                    double py = cy + dy - star.y;
+                    sum += w;
+                    sx += w * px;
+                    sy += w * py;
+                    sxx += w * px * px;
+                    syy += w * py * py;
+                    sxy += w * px * py;
+                }
+            }
+            if (sum <= 0) continue;
+            double mx = sx / sum, my = sy / sum;
+            double mxx = sxx / sum - mx * mx;
+            double myy = syy / sum - my * my;
+            double mxy = sxy / sum - mx * my;
+
+            double half = 0.5 * (mxx + myy);
+            double diff = std::sqrt(0.25 * (mxx - myy) * (mxx - myy) + mxy * mxy);
+            double major = half + diff, minor = half - diff;
+            if (minor <= 0) continue;
+
+            fwhms.push_back(2.3548 * std::sqrt(half));
+            eccentricities.push_back(std::sqrt(1.0 - minor / major));
+        }
+        if (fwhms.empty()) return;
+
+        std::nth_element(fwhms.begin(), fwhms.begin() + fwhms.size() / 2, fwhms.end());
+        std::nth_element(eccentricities.begin(), eccentricities.begin() + eccentricities.size() / 2,
+                         eccentricities.end());
+        record.fwhm = fwhms[fwhms.size() / 2];
+        record.eccentricity = eccentricities[eccentricities.size() / 2];
+    }
+
+    static void robustStats(std::vector<double> values, double& median, double& sigma) {
+        median = sigma = 0;
+        if (values.empty()) return;
+        size_t mid = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + mid, values.end());
+        median = values[mid];
+        for (double& v : values) v = std::abs(v - median);
+        std::nth_element(values.begin(), values.begin() + mid, values.end());
+        sigma = values[mid] * 1.4826;
+    }
+};
+
+#endif // FRAMEQUALITYSCORER_H
@@ -0,0 +1,476 @@
+#ifndef FRAMESTACKER_H
+#define FRAMESTACKER_H
+
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+#include <fitsio.h>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <sys/resource.h>
+#include "FitsProcessor.h"
+#include "MemoryBudget.h"
+#include "StarMatcher.h"
+#include "DefectRejection.h"
+#include "Parallel.h"
+
+// How the registered frames are combined per output pixel
+enum class StackMethod {
+    Mean,           // Plain average of all valid samples
+    SigmaClip,      // Iteratively reject samples beyond kappa * sigma, then average
+    Winsorized      // Iteratively clamp samples to median +/- kappa * sigma, then average
+};
+
+struct StackOptions {
+    StackMethod method = StackMethod::SigmaClip;
+    float kappaLow = 3.0f;
+    float kappaHigh = 3.0f;
+    int maxIterations = 5;
+    int referenceIndex = 0;         // Frame whose pixel grid and WCS the stack uses
+    int maxStars = 40;              // Brightest stars kept per frame for matching
+    int matchStars = 25;            // Stars used to build triangles
+    int threads = 0;                // 0 = QThread::idealThreadCount()
+    qint64 memoryLimitBytes = 0;    // Strip working set; 0 = budget or 1 GB
+    bool matchBackground = true;    // Shift each frame's sky level to the reference
+    bool rejectDefects = true;      // Repair hot pixels and cosmic rays before detection and combining
+};
+
+struct StackResult {
+    bool ok = false;
+    QString error;
+    Parallel::Buffer<float> data;   // Rows first touched by the worker that combines them
+    int width = 0;
+    int height = 0;
+    WCSInfo wcs;
+    int framesUsed = 0;
+    QStringList rejectedFrames;
+    QStringList failedFrames;       // Registered but unreadable while combining: "path: error"
+};
+
+// Registers frames of one field by star-triangle matching and combines them
+// onto the reference frame's grid. Pixels are processed in row strips across
+// all frames, so memory is O(frames x strip) rather than O(frames x image),
+// and strips are spread over worker threads. CFITSIO must be built reentrant.
+class FrameStacker {
+public:
+    using ProgressCallback = std::function<void(int done, int total)>;
+
+    explicit FrameStacker(const StackOptions& options = StackOptions()) : options(options) {}
+
+    StackResult stack(const QStringList& files, ProgressCallback progress = nullptr) {
+        StackResult result;
+        if (files.isEmpty()) {
+            result.error = "No frames to stack";
+            return result;
+        }
+
+        int refIndex = qBound(0, options.referenceIndex, int(files.size()) - 1);
+        int threadCount = Parallel::threadCount(options.threads);
+
+        // Pass 1: detect stars in every frame (one frame per worker in memory)
+        std::vector<FrameInfo> frames(files.size());
+        for (int i = 0; i < files.size(); ++i) frames[i].path = files[i];
+
+        // Frames are already spread over the workers; defect passes run
+        // single-threaded inside each
+        DefectOptions defectOptions;
+        defectOptions.threads = 1;
+        DefectRejector rejector(defectOptions);
+
+        std::atomic<int> done{0};
+        int totalSteps = files.size();
+        Parallel::forEach(frames.size(), threadCount, [&](int i) {
+            analyseFrame(frames[i], rejector);
+            if (progress) progress(++done, totalSteps);
+        });
+
+        // Hot pixels are only known once every frame has been seen
+        DefectList hotPixels = rejector.hotPixels();
+        if (!hotPixels.empty()) {
+            qDebug() << QString("Hot-pixel map: %1 pixels").arg(hotPixels.size());
+            for (FrameInfo& frame : frames) {
+                if (frame.ok && rejector.mapMatches(frame.width, frame.height)) {
+                    frame.defects = DefectRejector::merge(frame.defects, hotPixels);
+                }
+            }
+        }
+
+        FrameInfo& ref = frames[refIndex];
+        if (!ref.ok || ref.stars.size() < 3) {
+            result.error = QString("Reference frame %1 has too few stars").arg(ref.path);
+            return result;
+        }
+        result.width = ref.width;
+        result.height = ref.height;
+        result.wcs = ref.wcs;
+
+        // Register every frame against the reference
+        StarMatcher matcher = starMatcher();
+        StarMatcher::Reference reference = matcher.makeReference(ref.stars);
+        std::vector<int> used;
+        for (int i = 0; i < int(frames.size()); ++i) {
+            FrameInfo& frame = frames[i];
+            if (i == refIndex) {
+                frame.registered = true;
+            } else if (frame.ok) {
+                frame.registered = matcher.match(reference, frame.stars, frame.transform);
+            }
+            if (frame.registered) {
+                frame.offset = options.matchBackground ? ref.background - frame.background : 0.0f;
+                used.push_back(i);
+                qDebug() << QString("Frame %1: scale %2, rotation %3°, shift (%4,%5), %6 stars, rms %7 px")
+                            .arg(frame.path)
+                            .arg(frame.transform.scale(), 0, 'f', 4)
+                            .arg(frame.transform.rotationDeg(), 0, 'f', 3)
+                            .arg(frame.transform.tx, 0, 'f', 1)
+                            .arg(frame.transform.ty, 0, 'f', 1)
+                            .arg(frame.transform.matchedStars)
+                            .arg(frame.transform.rms, 0, 'f', 2);
+            } else {
+                result.rejectedFrames << frame.path;
+                qDebug() << "Frame rejected (no registration):" << frame.path;
+            }
+        }
+
+        // Pass 2: reproject and combine strip by strip
+        const int width = ref.width;
+        const int height = ref.height;
+        const int n = used.size();
+        qint64 limit = options.memoryLimitBytes;
+        if (limit <= 0) {
+            limit = MemoryAccounting::instance().budget() > 0
+                    ? MemoryAccounting::instance().budget() / 2
+                    : 1024LL * 1024 * 1024;
+        }
+        // Slab rows for every frame plus the source rows being read
+        qint64 bytesPerRow = qint64(n + 1) * width * sizeof(float);
+        int stripRows = int(std::min<qint64>(256, limit / std::max<qint64>(1, bytesPerRow * threadCount)));
+        stripRows = std::max(stripRows, 4);
+        int stripCount = (height + stripRows - 1) / stripRows;
+
+        qDebug() << QString("Stacking %1 frames (%2x%3) in %4 strips of %5 rows on %6 threads, %7 NUMA nodes")
+                    .arg(n).arg(width).arg(height).arg(stripCount).arg(stripRows).arg(threadCount)
+                    .arg(Parallel::numaPinning() ? Parallel::Topology::system().nodeCount() : 1);
+
+        // Left unwritten here: every strip's rows are written, NaN where no
+        // frame covers them, by the worker that combines the strip
+        result.data.resize(size_t(width) * height);
+        MemoryCharge outputCharge(MemoryStage::FitsProcessing, result.data.size() * sizeof(float));
+
+        // A frame that fails to open or read is dropped from the rest of
+        // the stack; the first failure's CFITSIO status is kept for the result
+        std::vector<std::atomic<bool>> failed(n);
+        std::vector<int> failStatus(n, 0);
+        for (std::atomic<bool>& flag : failed) flag = false;
+
+        // Every strip visits the frames in order, which defeats an LRU: each
+        // worker keeps its first `keepOpen` frames open for the whole stack
+        // and opens the rest per strip, so threads x frames never exceeds
+        // the descriptor limit
+        const int keepOpen = std::min(n, std::max(1, openFileBudget() / threadCount));
+
+        std::atomic<int> nextStrip{0};
+        done = 0;
+        totalSteps = stripCount;
+        auto stripWorker = [&]() {
+            std::vector<float> slab;
+            std::vector<float> source;
+            std::vector<float> samples(n);
+            std::vector<fitsfile*> handles(keepOpen, nullptr);
+            for (int s = nextStrip++; s < stripCount; s = nextStrip++) {
+                int y0 = s * stripRows;
+                int y1 = std::min(height, y0 + stripRows);
+                size_t stripPixels = size_t(y1 - y0) * width;
+                slab.assign(stripPixels * n, std::numeric_limits<float>::quiet_NaN());
+                MemoryCharge slabCharge(MemoryStage::FitsProcessing, slab.size() * sizeof(float));
+
+                for (int f = 0; f < n; ++f) {
+                    if (failed[f]) continue;
+                    fitsfile* transient = nullptr;
+                    fitsfile*& fptr = f < keepOpen ? handles[f] : transient;
+                    int status = reprojectStrip(frames[used[f]], fptr, width, y0, y1, source,
+                                                slab.data() + size_t(f) * stripPixels);
+                    if (status) {
+                        std::fill_n(slab.data() + size_t(f) * stripPixels, stripPixels,
+                                    std::numeric_limits<float>::quiet_NaN());
+                        if (!failed[f].exchange(true)) failStatus[f] = status;
+                    }
+                    if (fptr && (f >= keepOpen || status)) closeFits(fptr);
+                }
+                combineStrip(slab, n, stripPixels, samples,
+                             result.data.data() + size_t(y0) * width);
+                if (progress) progress(++done, totalSteps);
+            }
+            for (fitsfile*& fptr : handles) {
+                if (fptr) closeFits(fptr);
+            }
+        };
+        Parallel::run(threadCount, stripWorker);
+
+        result.framesUsed = n;
+        for (int f = 0; f < n; ++f) {
+            if (!failed[f]) continue;
+            char text[FLEN_STATUS];
+            fits_get_errstatus(failStatus[f], text);
+            result.failedFrames << QString("%1: %2").arg(frames[used[f]].path, text);
+            result.framesUsed--;
+            qDebug() << "Frame dropped while combining:" << result.failedFrames.last();
+        }
+        result.ok = result.framesUsed > 0;
+        if (!result.ok) result.error = "No frame could be read while combining";
+        return result;
+    }
+
+    // Write a stack as a 2D float FITS image carrying the reference WCS
+    static bool writeFits(const QString& filename, const StackResult& result,
+                          StackMethod method = StackMethod::SigmaClip) {
+        if (!result.ok || result.data.empty()) return false;
+
+        fitsfile* fptr = nullptr;
+        int status = 0;
+        QString path = "!" + filename;  // ! prefix forces overwrite
+        if (fits_create_file(&fptr, path.toLocal8Bit().constData(), &status)) {
+            fits_report_error(stderr, status);
+            return false;
+        }
+
+        long naxes[2] = {result.width, result.height};
+        fits_create_img(fptr, FLOAT_IMG, 2, naxes, &status);
+
+        if (result.wcs.isValid) {
+            WCSInfo wcs = result.wcs;
+            QByteArray ctype1 = wcs.ctype1.toLatin1();
+            QByteArray ctype2 = wcs.ctype2.toLatin1();
+            fits_update_key(fptr, TSTRING, "CTYPE1", ctype1.data(), nullptr, &status);
+            fits_update_key(fptr, TSTRING, "CTYPE2", ctype2.data(), nullptr, &status);
+            fits_update_key(fptr, TDOUBLE, "CRVAL1", &wcs.crval1, nullptr, &status);
+            fits_update_key(fptr, TDOUBLE, "CRVAL2", &wcs.crval2, nullptr, &status);
+            fits_update_key(fptr, TDOUBLE, "CRPIX1", &wcs.crpix1, nullptr, &status);
+            fits_update_key(fptr, TDOUBLE, "CRPIX2", &wcs.crpix2, nullptr, &status);
+            fits_update_key(fptr, TDOUBLE, "CDELT1", &wcs.cdelt1, nullptr, &status);
+            fits_update_key(fptr, TDOUBLE, "CDELT2", &wcs.cdelt2, nullptr, &status);
+            fits_update_key(fptr, TDOUBLE, "CROTA2", &wcs.crota2, nullptr, &status);
+            fits_update_key(fptr, TDOUBLE, "EQUINOX", &wcs.equinox, nullptr, &status);
+        }
+
+        int frames = result.framesUsed;
+        char methodName[FLEN_VALUE];
+        strcpy(methodName, method == StackMethod::Mean ? "MEAN" :
+                           method == StackMethod::Winsorized ? "WINSOR" : "SIGCLIP");
+        fits_update_key(fptr, TINT, "NCOMBINE", &frames, "Frames combined", &status);
+        fits_update_key(fptr, TSTRING, "STACKMTH", methodName, "Combine method", &status);
+
+        fits_write_img(fptr, TFLOAT, 1, long(result.data.size()),
+                       const_cast<float*>(result.data.data()), &status);
+        fits_close_file(fptr, &status);
+
+        if (status) {
+            fits_report_error(stderr, status);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    StackOptions options;
+
+    struct FrameInfo {
+        QString path;
+        bool ok = false;
+        bool registered = false;
+        int width = 0;
+        int height = 0;
+        WCSInfo wcs;
+        float background = 0.0f;
+        float offset = 0.0f;
+        std::vector<StarMatcher::Star> stars;
+        FrameTransform transform;
+        DefectList defects;     // Repaired again in every strip read from disk
+    };
+
+    void analyseFrame(FrameInfo& frame, DefectRejector& rejector) const {
+        std::vector<float> data;
+        FitsProcessor reader;
+        if (!reader.loadFits(frame.path, data, frame.width, frame.height, frame.wcs)) {
+            qDebug() << "Failed to read frame:" << frame.path;
+            return;
+        }
+        MemoryCharge frameCharge(MemoryStage::FitsDecode, data.size() * sizeof(float));
+
+        float median, sigma;
+        if (!StarMatcher::estimateBackground(data.data(), data.size(), median, sigma)) return;
+
+        if (options.rejectDefects) {
+            rejector.observe(data.data(), frame.width, frame.height, median, sigma);
+            frame.defects = rejector.detectCosmicRays(data.data(), frame.width, frame.height,
+                                                      median, sigma);
+            DefectRejector::repair(data.data(), frame.width, frame.height, 0, 0, frame.width,
+                                   frame.defects);
+        }
+
+        frame.background = median;
+        frame.stars = starMatcher().detectStars(data.data(), frame.width, frame.height,
+                                                median, median + 5.0f * sigma);
+        frame.ok = true;
+    }
+
+    StarMatcher starMatcher() const {
+        StarMatcher matcher;
+        matcher.maxStars = options.maxStars;
+        matcher.matchStars = options.matchStars;
+        return matcher;
+    }
+
+    // Open files for all strip workers together: a quarter of the soft
+    // descriptor limit, leaving the rest to the GUI, caches and network
+    static int openFileBudget() {
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) return 256;
+        return int(std::max<rlim_t>(16, std::min<rlim_t>(limit.rlim_cur / 4, 4096)));
+    }
+
+    static void closeFits(fitsfile*& fptr) {
+        int status = 0;
+        fits_close_file(fptr, &status);
+        fptr = nullptr;
+    }
+
+    // Bilinearly resample the frame onto reference rows [y0, y1). Only the
+    // source rectangle covering the strip is read, via fits_read_subset;
+    // `fptr` is the worker's handle for the frame, opened here if null.
+    // Returns the CFITSIO status, 0 on success or if the strip misses the frame.
+    int reprojectStrip(const FrameInfo& frame, fitsfile*& fptr, int width, int y0, int y1,
+                       std::vector<float>& source, float* out) const {
+        const FrameTransform& t = frame.transform;
+
+        double minU = 1e30, maxU = -1e30, minV = 1e30, maxV = -1e30;
+        const double cornersX[2] = {0.0, double(width - 1)};
+        const double cornersY[2] = {double(y0), double(y1 - 1)};
+        for (double cx : cornersX) {
+            for (double cy : cornersY) {
+                double u, v;
+                t.apply(cx, cy, u, v);
+                minU = std::min(minU, u); maxU = std::max(maxU, u);
+                minV = std::min(minV, v); maxV = std::max(maxV, v);
+            }
+        }
+        long u0 = std::max(0L, long(std::floor(minU)) - 1);
+        long u1 = std::min(long(frame.width - 1), long(std::ceil(maxU)) + 1);
+        long v0 = std::max(0L, long(std::floor(minV)) - 1);
+        long v1 = std::min(long(frame.height - 1), long(std::ceil(maxV)) + 1);
+        if (u0 > u1 || v0 > v1) return 0;   // strip falls outside this frame
+
+        long subWidth = u1 - u0 + 1;
+        long subHeight = v1 - v0 + 1;
+        source.resize(size_t(subWidth) * subHeight);
+
+        int status = 0;
+        if (!fptr && fits_open_file(&fptr, frame.path.toLocal8Bit().constData(), READONLY, &status)) {
+            fptr = nullptr;
+            return status;
+        }
+        long fpixel[2] = {u0 + 1, v0 + 1};
+        long lpixel[2] = {u1 + 1, v1 + 1};
+        long inc[2] = {1, 1};
+        float nullValue = std::numeric_limits<float>::quiet_NaN();
+        int anyNull = 0;
+        fits_read_subset(fptr, TFLOAT, fpixel, lpixel, inc, &nullValue,
+                         source.data(), &anyNull, &status);
+        if (status) return status;
+        DefectRejector::repair(source.data(), subWidth, subHeight, u0, v0, frame.width,
+                               frame.defects);
+
+        const float offset = frame.offset;
+        for (int y = y0; y < y1; ++y) {
+            float* dst = out + size_t(y - y0) * width;
+            // Walk the row incrementally: the transform is affine
+            double u = -t.b * y + t.tx - u0;
+            double v = t.a * y + t.ty - v0;
+            for (int x = 0; x < width; ++x, u += t.a, v += t.b) {
+                if (u < 0 || v < 0 || u > subWidth - 1 || v > subHeight - 1) continue;
+                long iu = long(u);
+                long iv = long(v);
+                long iu1 = std::min(iu + 1, subWidth - 1);
+                long iv1 = std::min(iv + 1, subHeight - 1);
+                float fu = float(u - iu);
+                float fv = float(v - iv);
+                const float* row0 = source.data() + size_t(iv) * subWidth;
+                const float* row1 = source.data() + size_t(iv1) * subWidth;
+                float top = row0[iu] + (row0[iu1] - row0[iu]) * fu;
+                float bottom = row1[iu] + (row1[iu1] - row1[iu]) * fu;
+                dst[x] = top + (bottom - top) * fv + offset;
+            }
+        }
+        return 0;
+    }
+
+    void combineStrip(const std::vector<float>& slab, int frameCount, size_t stripPixels,
+                      std::vector<float>& samples, float* out) const {
+        for (size_t p = 0; p < stripPixels; ++p) {
+            int count = 0;
+            for (int f = 0; f < frameCount; ++f) {
+                float v = slab[size_t(f) * stripPixels + p];
+                if (std::isfinite(v)) samples[count++] = v;
+            }
+            out[p] = count ? combinePixel(samples.data(), count)
+                           : std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+
+    float combinePixel(float* values, int count) const {
+        if (options.method == StackMethod::Mean || count < 3) {
+            double sum = 0;
+            for (int i = 0; i < count; ++i) sum += values[i];
+            return float(sum / count);
+        }
+
+        for (int iteration = 0; iteration < options.maxIterations; ++iteration) {
+            // Median centre and standard deviation of the current set
+            std::nth_element(values, values + count / 2, values + count);
+            float median = values[count / 2];
+            double sum = 0, sumSq = 0;
+            for (int i = 0; i < count; ++i) {
+                sum += values[i];
+                sumSq += double(values[i]) * values[i];
+            }
+            double mean = sum / count;
+            float sigma = float(std::sqrt(std::max(0.0, sumSq / count - mean * mean)));
+            if (sigma <= 0) break;
+
+            float low = median - options.kappaLow * sigma;
+            float high = median + options.kappaHigh * sigma;
+
+            int changed = 0;
+            if (options.method == StackMethod::SigmaClip) {
+                int inside = 0;
+                for (int i = 0; i < count; ++i) {
+                    if (values[i] >= low && values[i] <= high) inside++;
+                }
+                if (inside < 2) break;  // keep the last usable set
+                int kept = 0;
+                for (int i = 0; i < count; ++i) {
+                    if (values[i] >= low && values[i] <= high) values[kept++] = values[i];
+                }
+                changed = count - kept;
+                count = kept;
+            } else {
+                for (int i = 0; i < count; ++i) {
+                    if (values[i] < low) { values[i] = low; changed++; }
+                    else if (values[i] > high) { values[i] = high; changed++; }
+                }
+            }
+            if (changed == 0) break;
+        }
+
+        double sum = 0;
+        for (int i = 0; i < count; ++i) sum += values[i];
+        return float(sum / count);
+    }
+};
+
+#endif // FRAMESTACKER_H
@@ -5,12 +5,23 @@
 #include <QString>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QCryptographicHash>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QCborValue>
+#include <QTimer>
 #include <QDateTime>
 #include <QStandardPaths>
 #include <QDebug>
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include "MemoryBudget.h"
+#include "Moc.h"
+#include "TieredCache.h"
+#include "Snapshot.h"
 
 class ImageCache : public QObject {
     Q_OBJECT
@@ -32,7 +43,37 @@ public:
 private:
     QString cacheDir;
     QString metadataFile;
+    QString snapshotFile;
     QJsonObject metadata;
+    MemoryCharge indexCharge{MemoryStage::ImageCacheIndex};
+    
+    // Cutout bytes: RAM, then cacheDir, then shared tiers. The metadata
+    // and coverage below describe what this machine has fetched or used.
+    std::unique_ptr<TieredCache> store;
+    
+    // Sky held per survey key: the disc through the corners of each cached
+    // cutout, rebuilt from metadata on load and extended as cutouts are
+    // cached. This is what the cache holds, not what it can serve: lookups
+    // only hit on the exact (ra, dec, width, height, survey) of a cutout.
+    // Catalogue tables (TSV) share the store but are not imaged sky.
+    static constexpr int kCoverageOrder = 12;   // ~0.86 arcmin cells
+    QHash<QString, Moc> coverage;
+    
+    void addCoverage(const QJsonObject& entry) {
+        if (entry["format"].toString() == "tsv") return;
+        double radiusArcmin = 0.5 * std::hypot(entry["width"].toDouble(), entry["height"].toDouble());
+        if (radiusArcmin <= 0) return;
+        coverage[entry["survey"].toString()].add(
+            Moc::fromCone(entry["ra"].toDouble(), entry["dec"].toDouble(),
+                          radiusArcmin / 60.0, kCoverageOrder, false));
+    }
+    
+    void rebuildCoverage() {
+        coverage.clear();
+        for (const QString& key : metadata.keys()) {
+            addCoverage(metadata[key].toObject());
+        }
+    }
 
     // Generate cache key from parameters
     QString generateCacheKey(double ra, double dec, double width, double height,
@@ -51,36 +92,93 @@ private:
         return QString(hash.toHex());
     }
     
-    QString getCachePath(const QString& cacheKey, const QString& format) const {
-        QString ext = (format == "fits") ? "fits" : "gif";
-        return cacheDir + "/" + cacheKey + "." + ext;
+    // The format is the extension: .fits and .gif cutouts, .tsv catalogues
+    QString storeKey(const QString& cacheKey, const QString& format) const {
+        QString ext = format.isEmpty() ? "gif" : format;
+        return cacheKey + "." + ext;
+    }
+
+    
+    // Metadata and coverage as of metadata.json's last write; written on
+    // exit and every few minutes so a restart skips parsing and rebuilding
+    static constexpr quint32 kSnapshotVersion = 3;     // 2: discs through the cutout corners, 3: no catalogues
+    QByteArray snapshotStamp;
+    QTimer snapshotTimer;
+    
+    bool loadSnapshot() {
+        QByteArray stamp = Snapshot::fileStamp(metadataFile);
+        Snapshot snapshot(snapshotFile, kSnapshotVersion, stamp);
+        if (!snapshot.isValid()) return false;
+        
+        QStringList surveys;
+        if (!snapshot.readStream("surveys", surveys)) return false;
+        QHash<QString, Moc> restored;
+        for (const QString& survey : surveys) {
+            if (!snapshot.readMoc("coverage." + survey, restored[survey])) return false;
+        }
+        metadata = QCborValue::fromCbor(snapshot.section("metadata")).toJsonValue().toObject();
+        coverage = restored;
+        snapshotStamp = stamp;
+        indexCharge.resize(QFileInfo(metadataFile).size());
+        return true;
+    }
+    
+    void saveSnapshot() {
+        QByteArray stamp = Snapshot::fileStamp(metadataFile);
+        if (stamp == snapshotStamp) return;
+        
+        SnapshotWriter writer(kSnapshotVersion, stamp);
+        writer.add("metadata", QCborValue::fromJsonValue(metadata).toCbor());
+        writer.addStream("surveys", QStringList(coverage.keys()));
+        for (auto it = coverage.constBegin(); it != coverage.constEnd(); ++it) {
+            writer.addMoc("coverage." + it.key(), it.value());
+        }
+        if (writer.write(snapshotFile)) snapshotStamp = stamp;
     }
     
     void loadMetadata() {
+        if (loadSnapshot()) return;
+        
         QFile file(metadataFile);
         if (file.open(QIODevice::ReadOnly)) {
             QByteArray data = file.readAll();
             QJsonDocument doc = QJsonDocument::fromJson(data);
             metadata = doc.object();
             file.close();
+            indexCharge.resize(data.size());
         }
+        rebuildCoverage();
     }
     
+    // Writes are skipped while metadata is held (see holdMetadata)
+    int metadataHolds = 0;
+    bool metadataDirty = false;
+    
     void saveMetadata() {
+        if (metadataHolds > 0) {
+            metadataDirty = true;
+            return;
+        }
+        metadataDirty = false;
         QFile file(metadataFile);
         if (file.open(QIODevice::WriteOnly)) {
             QJsonDocument doc(metadata);
-            file.write(doc.toJson());
+            QByteArray json = doc.toJson();
+            file.write(json);
             file.close();
+            indexCharge.resize(json.size());
         }
     }
 
 public:
-    explicit ImageCache(QObject* parent = nullptr) : QObject(parent) {
-        // Use application cache directory
-        QString appCache = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
-        cacheDir = appCache + "/DSS_Images";
+    // Use the application cache directory
+    explicit ImageCache(QObject* parent = nullptr)
+        : ImageCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/DSS_Images", parent) {}
+    
+    explicit ImageCache(const QString& directory, QObject* parent = nullptr) : QObject(parent) {
+        cacheDir = directory;
         metadataFile = cacheDir + "/metadata.json";
+        snapshotFile = cacheDir + "/index.snapshot";
         
         // Create cache directory if it doesn't exist
         QDir dir;
@@ -89,30 +187,56 @@ public:
             qDebug() << "Created cache directory:" << cacheDir;
         }
         
+        store = std::make_unique<TieredCache>(TieredCache::standardTiers(cacheDir, "DSS_Images"),
+                                              QStringList() << "*.fits" << "*.gif" << "*.tsv");
         loadMetadata();
+        
+        snapshotTimer.setInterval(5 * 60 * 1000);
+        connect(&snapshotTimer, &QTimer::timeout, this, [this]() { saveSnapshot(); });
+        snapshotTimer.start();
+    }
+    
+    ~ImageCache() {
+        metadataHolds = 0;
+        if (metadataDirty) saveMetadata();
+        saveSnapshot();
+    }
+    
+    // Nested holds defer metadata.json rewrites until the last release,
+    // so bulk imports write the index once instead of once per cutout
+    void holdMetadata(bool hold) {
+        metadataHolds = std::max(0, metadataHolds + (hold ? 1 : -1));
+        if (metadataHolds == 0 && metadataDirty) saveMetadata();
     }
     
-    // Check if cached version exists
+    // Check if cached version exists in any tier
     bool isCached(double ra, double dec, double width, double height,
                   const QString& survey, const QString& format) const {
         QString key = generateCacheKey(ra, dec, width, height, survey, format);
-        QString path = getCachePath(key, format);
-        return QFile::exists(path);
+        return store->contains(storeKey(key, format));
     }
     
     // Get cached image data
     QByteArray getCachedImage(double ra, double dec, double width, double height,
                              const QString& survey, const QString& format) {
         QString key = generateCacheKey(ra, dec, width, height, survey, format);
-        QString path = getCachePath(key, format);
         
-        QFile file(path);
-        if (file.open(QIODevice::ReadOnly)) {
-            QByteArray data = file.readAll();
-            file.close();
-            
-            // Update access time in metadata
+        QByteArray data = store->get(storeKey(key, format));
+        if (!data.isEmpty()) {
+            // Update access time in metadata; a cutout first seen in a
+            // shared tier gets its description from the arguments
             QJsonObject entry = metadata[key].toObject();
+            if (!entry.contains("survey")) {
+                entry["ra"] = ra;
+                entry["dec"] = dec;
+                entry["width"] = width;
+                entry["height"] = height;
+                entry["survey"] = survey;
+                entry["format"] = format;
+                entry["created"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+                entry["size"] = data.size();
+                addCoverage(entry);
+            }
             entry["lastAccess"] = QDateTime::currentDateTime().toString(Qt::ISODate);
             entry["accessCount"] = entry["accessCount"].toInt() + 1;
             metadata[key] = entry;
@@ -131,13 +255,8 @@ public:
                    const QString& survey, const QString& format,
                    const QString& objectName = "") {
         QString key = generateCacheKey(ra, dec, width, height, survey, format);
-        QString path = getCachePath(key, format);
         
-        QFile file(path);
-        if (file.open(QIODevice::WriteOnly)) {
-            file.write(data);
-            file.close();
-            
+        if (store->put(storeKey(key, format), data)) {
             // Update metadata
             QJsonObject entry;
             entry["ra"] = ra;
@@ -154,6 +273,7 @@ public:
             
             metadata[key] = entry;
             saveMetadata();
+            addCoverage(entry);
             
             qDebug() << "Cached image:" << key << "Size:" << data.size();
         }
@@ -179,19 +299,13 @@ public:
         return stats;
     }
     
-    // Clear cache
+    // Clear the RAM and local tiers; shared tiers belong to the team
     void clearCache() {
-        QDir dir(cacheDir);
-        QStringList files = dir.entryList(QDir::Files | QDir::NoDotAndDotDot);
-        
-        for (const QString& file : files) {
-            if (file != "metadata.json") {
-                QFile::remove(dir.filePath(file));
-            }
-        }
+        store->clearLocal();
         
         metadata = QJsonObject();
         saveMetadata();
+        coverage.clear();
         
         qDebug() << "Cache cleared";
     }
@@ -210,10 +324,9 @@ public:
             if (lastAccess < cutoff) {
                 keysToRemove.append(key);
                 
-                // Remove file
+                // Remove local copies
                 QString format = entry["format"].toString();
-                QString path = getCachePath(key, format);
-                QFile::remove(path);
+                store->remove(storeKey(key, format));
             }
         }
         
@@ -224,13 +337,24 @@ public:
         
         if (!keysToRemove.isEmpty()) {
             saveMetadata();
+            rebuildCoverage();
             qDebug() << "Removed" << keysToRemove.size() << "old cache entries";
         }
     }
     
+    // Sky held by cached cutouts of one survey; a field inside it is only
+    // available offline if isCached() has its exact cutout
+    Moc surveyCoverage(const QString& survey) const {
+        return coverage.value(survey);
+    }
+    
     QString getCacheDirectory() const {
         return cacheDir;
     }
+    
+    QList<TieredCache::TierStats> tierStats() const {
+        return store->stats();
+    }
 };
 
 #endif // IMAGECACHE_H
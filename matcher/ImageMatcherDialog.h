@@ -13,6 +13,11 @@
 #include <QGroupBox>
 #include <QMessageBox>
 #include "FitsProcessor.h"
+#include "MemoryBudget.h"
+#include "PhotometricCalibrator.h"
+#include <limits>
+#include <memory>
+#include <unordered_map>
 
 class ImageMatcherDialog : public QDialog {
     Q_OBJECT
@@ -35,13 +40,24 @@ private:
     PSFModel userPSF;
     PSFModel libraryPSF;
     
+    // Optional: calibrated photometry of both images against a catalog
+    std::shared_ptr<const CatalogIndex> catalog;
+    PhotometricSolution userPhot;
+    PhotometricSolution libraryPhot;
+    std::vector<PhotometricStar> userStars;
+    std::vector<PhotometricStar> libraryStars;
+    
     FitsProcessor* processor;
+    
+    MemoryCharge userCharge{MemoryStage::MatcherFrames};
+    MemoryCharge libraryCharge{MemoryStage::MatcherFrames};
 
 public:
     ImageMatcherDialog(const QString& userFitsPath, 
                       const QByteArray& libraryFitsData,
-                      QWidget* parent = nullptr) 
-        : QDialog(parent) {
+                      QWidget* parent = nullptr,
+                      std::shared_ptr<const CatalogIndex> referenceCatalog = nullptr) 
+        : QDialog(parent), catalog(std::move(referenceCatalog)) {
         
         setWindowTitle("Image Matcher - WCS Alignment & Analysis");
         resize(1400, 800);
@@ -181,6 +197,7 @@ private:
 	// --- Read pixel data into a float buffer ---
 	const long npixels = width * height;
 	std::vector<float> buffer(npixels);
+	MemoryCharge decodeCharge(MemoryStage::FitsDecode, npixels * sizeof(float) + memsize);
 
 	long fpixel[3] = {1, 1, 1};
 	if (fits_read_pix(fptr, TFLOAT, fpixel, npixels, NULL, buffer.data(), NULL, &status))
@@ -237,6 +254,7 @@ private:
             return;
         }
 
+        userCharge.resize(userData.size() * sizeof(float));
         displayImage(userData, userWidth, userHeight, userImageLabel);
 
         statusLabel->setText("Loading library FITS image...");
@@ -284,6 +302,7 @@ private:
         
         long npixels = libWidth * libHeight;
         libraryData.resize(npixels);
+        libraryCharge.resize(npixels * sizeof(float));
         
         long fpixel[3] = {1, 1, 1};
         if (fits_read_pix(fptr, TFLOAT, fpixel, npixels, nullptr,
@@ -327,6 +346,42 @@ private:
                                       Qt::SmoothTransformation));
     }
     
+    // Streaming variant of the background-corrected display: evaluates the
+    // model on the fly in two passes instead of materialising a float copy
+    void displayCorrectedImage() {
+        if (userData.empty()) return;
+        
+        float minVal = std::numeric_limits<float>::max();
+        float maxVal = std::numeric_limits<float>::lowest();
+        for (int y = 0; y < userHeight; ++y) {
+            for (int x = 0; x < userWidth; ++x) {
+                float val = userData[y * userWidth + x] - userBG.evaluate(x, y);
+                minVal = std::min(minVal, val);
+                maxVal = std::max(maxVal, val);
+            }
+        }
+        if (minVal == maxVal) maxVal = minVal + 1.0f;
+        float scale = 255.0f / (maxVal - minVal);
+        
+        QImage img(userWidth, userHeight, QImage::Format_Grayscale8);
+        for (int y = 0; y < userHeight; ++y) {
+            uchar* scanLine = img.scanLine(y);
+            for (int x = 0; x < userWidth; ++x) {
+                float val = userData[y * userWidth + x] - userBG.evaluate(x, y);
+                int scaled = (val - minVal) * scale;
+                scanLine[x] = qBound(0, scaled, 255);
+            }
+        }
+        
+        // Mirror vertically for FITS orientation
+        img = img.mirrored(false, true);
+        
+        QPixmap pixmap = QPixmap::fromImage(img);
+        userImageLabel->setPixmap(pixmap.scaled(userImageLabel->size(),
+                                                Qt::KeepAspectRatio,
+                                                Qt::SmoothTransformation));
+    }
+    
     void analyzeImages() {
         statusLabel->setText("Analyzing images...");
         progressBar->show();
@@ -338,6 +393,15 @@ private:
         userPSF = processor->estimatePSF(userData, userWidth, userHeight);
         libraryPSF = processor->estimatePSF(libraryData, libWidth, libHeight);
         
+        // Zero points against the reference catalog
+        if (catalog && !catalog->isEmpty()) {
+            PhotometricCalibrator calibrator(*catalog);
+            userPhot = calibrator.calibrate(userData.data(), userWidth, userHeight,
+                                            userWCS, &userStars, userPSF.fwhm);
+            libraryPhot = calibrator.calibrate(libraryData.data(), libWidth, libHeight,
+                                               libraryWCS, &libraryStars, libraryPSF.fwhm);
+        }
+        
         // Populate analysis table
         populateAnalysisTable();
         
@@ -420,27 +484,86 @@ private:
                        QString("%1 px").arg(libraryPSF.sigma, 0, 'f', 2) : "—");
         }
         
+        if (catalog) addPhotometryRows(addRow);
+        
         analysisTable->resizeColumnsToContents();
     }
     
+    template <typename AddRow>
+    void addPhotometryRows(AddRow addRow) {
+        auto value = [](const PhotometricSolution& s, double v, int precision) {
+            return s.ok ? QString::number(v, 'f', precision) : QString("—");
+        };
+        addRow("Photometric Zero Point",
+               userPhot.ok ? QString("%1 ± %2").arg(userPhot.zeroPoint, 0, 'f', 3)
+                                               .arg(userPhot.zeroPointError, 0, 'f', 3)
+                           : "Failed: " + userPhot.error,
+               libraryPhot.ok ? QString("%1 ± %2").arg(libraryPhot.zeroPoint, 0, 'f', 3)
+                                                  .arg(libraryPhot.zeroPointError, 0, 'f', 3)
+                              : "Failed: " + libraryPhot.error);
+        addRow("Colour Term",
+               userPhot.hasColorTerm ? value(userPhot, userPhot.colorTerm, 3) : "—",
+               libraryPhot.hasColorTerm ? value(libraryPhot, libraryPhot.colorTerm, 3) : "—");
+        addRow("Calibration RMS (mag)",
+               value(userPhot, userPhot.rms, 3), value(libraryPhot, libraryPhot.rms, 3));
+        addRow("Calibration Stars (used / matched)",
+               QString("%1 / %2").arg(userPhot.used).arg(userPhot.matched),
+               QString("%1 / %2").arg(libraryPhot.used).arg(libraryPhot.matched));
+        if (!userPhot.ok || !libraryPhot.ok) return;
+        
+        // Same catalog star in both images: brightness offset and outliers
+        std::unordered_map<int, const PhotometricStar*> libraryByCatalog;
+        for (const PhotometricStar& star : libraryStars) {
+            if (star.catalogIndex >= 0) libraryByCatalog[star.catalogIndex] = &star;
+        }
+        std::vector<double> deltas, errors;
+        for (const PhotometricStar& star : userStars) {
+            auto it = libraryByCatalog.find(star.catalogIndex);
+            if (star.catalogIndex < 0 || it == libraryByCatalog.end()) continue;
+            deltas.push_back(star.calibratedMag - it->second->calibratedMag);
+            errors.push_back(std::hypot(star.instError, it->second->instError));
+        }
+        if (deltas.empty()) return;
+        
+        std::vector<double> sorted = deltas;
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        double median = sorted[sorted.size() / 2];
+        double floor = std::hypot(userPhot.rms, libraryPhot.rms);
+        int variable = 0;
+        for (size_t i = 0; i < deltas.size(); ++i) {
+            double limit = 3.0 * std::hypot(errors[i], floor);
+            if (std::abs(deltas[i] - median) > std::max(limit, 0.1)) variable++;
+        }
+        addRow("Median Δmag (yours − DSS)",
+               QString("%1 mag over %2 stars").arg(median, 0, 'f', 3).arg(deltas.size()), "—");
+        addRow("Variability Candidates", QString::number(variable), "—");
+    }
+    
     void applyBackgroundCorrection() {
         statusLabel->setText("Applying background correction...");
         progressBar->show();
         
-        // Create corrected image
-        std::vector<float> correctedData = userData;
-        
-        for (int y = 0; y < userHeight; ++y) {
-            for (int x = 0; x < userWidth; ++x) {
-                int idx = y * userWidth + x;
-                float bgValue = userBG.evaluate(x, y);
-                correctedData[idx] -= bgValue;
+        qint64 frameBytes = qint64(userData.size()) * sizeof(float);
+        if (MemoryAccounting::instance().shouldStream(frameBytes)) {
+            // Not enough headroom for a float copy of the frame
+            displayCorrectedImage();
+        } else {
+            // Create corrected image
+            std::vector<float> correctedData = userData;
+            MemoryCharge correctedCharge(MemoryStage::FitsProcessing, frameBytes);
+            
+            for (int y = 0; y < userHeight; ++y) {
+                for (int x = 0; x < userWidth; ++x) {
+                    int idx = y * userWidth + x;
+                    float bgValue = userBG.evaluate(x, y);
+                    correctedData[idx] -= bgValue;
+                }
             }
+            
+            // Display corrected image
+            displayImage(correctedData, userWidth, userHeight, userImageLabel);
         }
         
-        // Display corrected image
-        displayImage(correctedData, userWidth, userHeight, userImageLabel);
-        
         progressBar->hide();
         statusLabel->setText("Background correction applied");
         
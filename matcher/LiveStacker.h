@@ -0,0 +1,372 @@
+#ifndef LIVESTACKER_H
+#define LIVESTACKER_H
+
+#include <QString>
+#include <QImage>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "FitsProcessor.h"
+#include "StarMatcher.h"
+#include "DefectRejection.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+struct LiveStackOptions {
+    int maxStars = 40;
+    int matchStars = 30;            // Brightness ranks shuffle between short exposures
+    double maxScaleError = 0.02;    // Reject matches that change the plate scale
+    int referenceRefresh = 8;       // Re-detect reference stars on the stack every N frames
+    int threads = 4;                // Accumulation and defect-rejection threads
+    bool rejectDefects = true;      // Repair hot pixels and cosmic rays before detection
+    float stretchStrength = 10.0f;  // asinh display stretch; larger = more midtone lift
+    float stretchSmoothing = 0.3f;  // Weight of the newest frame in the black/white points
+};
+
+// Outcome and per-step timing of one addFrame() call
+struct LiveFrameReport {
+    bool accepted = false;
+    QString reason;
+    FrameTransform transform;
+    int stars = 0;
+    int defects = 0;        // Hot-pixel and cosmic-ray pixels repaired
+    int framesStacked = 0;
+    double defectMs = 0;
+    double detectMs = 0;
+    double matchMs = 0;
+    double accumulateMs = 0;
+    double stretchMs = 0;
+    double totalMs = 0;
+};
+
+// Incremental stacker for frames arriving one at a time (e.g. from a camera
+// or a watched folder). The first frame fixes the output grid; every later
+// frame is registered against the reference stars, warped onto that grid and
+// added to running sum/weight buffers. Hot pixels (learnt over the session)
+// and cosmic rays are repaired first. Display black/white points are
+// refreshed from a sparse sample of the stack after each frame, so the cost
+// per frame is one defect pass, one detection pass, one match and one warp.
+// Not thread-safe: feed frames from one thread at a time.
+class LiveStacker {
+public:
+    explicit LiveStacker(const LiveStackOptions& options = LiveStackOptions())
+        : options(options), defects(defectOptions(options)) {
+        matcher.maxStars = options.maxStars;
+        matcher.matchStars = options.matchStars;
+    }
+
+    void reset() {
+        width = height = 0;
+        frames = 0;
+        sum.clear();
+        weight.clear();
+        samples.clear();
+        reference = StarMatcher::Reference();
+        stretchValid = false;
+        defects.reset();
+    }
+
+    int frameCount() const { return frames; }
+    int stackWidth() const { return width; }
+    int stackHeight() const { return height; }
+    const WCSInfo& referenceWcs() const { return wcs; }
+
+    LiveFrameReport addFile(const QString& path) {
+        std::vector<float> data;
+        int w = 0, h = 0;
+        WCSInfo frameWcs;
+        FitsProcessor reader;
+        if (!reader.loadFits(path, data, w, h, frameWcs)) {
+            LiveFrameReport report;
+            report.reason = "Failed to read " + path;
+            report.framesStacked = frames;
+            return report;
+        }
+        if (frames == 0) wcs = frameWcs;
+        return addFrame(std::move(data), w, h);
+    }
+
+    // Takes the frame by value: defects are repaired in place
+    LiveFrameReport addFrame(std::vector<float> data, int frameWidth, int frameHeight) {
+        LiveFrameReport report;
+        QElapsedTimer total, step;
+        total.start();
+        step.start();
+
+        float median, sigma;
+        if (data.size() < size_t(frameWidth) * frameHeight ||
+            !StarMatcher::estimateBackground(data.data(), data.size(), median, sigma)) {
+            report.reason = "Empty frame";
+            report.framesStacked = frames;
+            return report;
+        }
+        if (options.rejectDefects) {
+            defects.observe(data.data(), frameWidth, frameHeight, median, sigma);
+            report.defects = defects.clean(data.data(), frameWidth, frameHeight, median, sigma).size();
+        }
+        report.defectMs = step.nsecsElapsed() / 1e6;
+
+        step.start();
+        std::vector<StarMatcher::Star> stars =
+            matcher.detectStars(data.data(), frameWidth, frameHeight, median, median + 5.0f * sigma);
+        report.stars = stars.size();
+        report.detectMs = step.nsecsElapsed() / 1e6;
+
+        step.start();
+        FrameTransform transform;
+        if (frames == 0) {
+            if (stars.size() < 3) {
+                report.reason = "Too few stars for a reference";
+                return report;
+            }
+            width = frameWidth;
+            height = frameHeight;
+            referenceBackground = median;
+            referenceSigma = sigma;
+            reference = matcher.makeReference(stars);
+            sum.assign(size_t(width) * height, 0.0f);
+            weight.assign(size_t(width) * height, 0.0f);
+            buildSampleGrid();
+        } else if (!matcher.match(reference, stars, transform)) {
+            report.reason = QString("No star match (%1 stars)").arg(stars.size());
+            report.matchMs = step.nsecsElapsed() / 1e6;
+            report.framesStacked = frames;
+            return report;
+        } else if (std::abs(transform.scale() - 1.0) > options.maxScaleError) {
+            report.reason = QString("Scale mismatch %1").arg(transform.scale(), 0, 'f', 4);
+            report.matchMs = step.nsecsElapsed() / 1e6;
+            report.framesStacked = frames;
+            return report;
+        }
+        report.transform = transform;
+        report.matchMs = step.nsecsElapsed() / 1e6;
+
+        // Inverse-variance weight relative to the reference; sky level
+        // shifted to the reference so gradients do not step between frames
+        step.start();
+        float frameWeight = (referenceSigma * referenceSigma) / (sigma * sigma);
+        accumulate(data.data(), frameWidth, frameHeight, transform,
+                   referenceBackground - median, frameWeight);
+        frames++;
+        report.accumulateMs = step.nsecsElapsed() / 1e6;
+
+        if (options.referenceRefresh > 0 && frames % options.referenceRefresh == 0) {
+            refreshReference();
+        }
+
+        step.start();
+        updateStretch();
+        report.stretchMs = step.nsecsElapsed() / 1e6;
+
+        report.accepted = true;
+        report.framesStacked = frames;
+        report.totalMs = total.nsecsElapsed() / 1e6;
+        return report;
+    }
+
+    // Weighted mean of everything stacked so far; NaN where nothing landed
+    std::vector<float> stackedImage() const {
+        std::vector<float> mean(sum.size());
+        for (size_t i = 0; i < sum.size(); ++i) {
+            mean[i] = weight[i] > 0 ? sum[i] / weight[i] : std::numeric_limits<float>::quiet_NaN();
+        }
+        return mean;
+    }
+
+    // Stretched preview binned down to fit within maxSize pixels
+    QImage renderPreview(int maxSize = 1200) const {
+        if (frames == 0 || !stretchValid) return QImage();
+
+        int bin = std::max(1, (std::max(width, height) + maxSize - 1) / maxSize);
+        int outWidth = width / bin;
+        int outHeight = height / bin;
+        QImage image(outWidth, outHeight, QImage::Format_Grayscale8);
+
+        // Lookup table over [black, white] avoids an asinh per pixel
+        const int lutSize = 4096;
+        uchar lut[lutSize];
+        const float k = options.stretchStrength;
+        const float norm = 1.0f / std::asinh(k);
+        for (int i = 0; i < lutSize; ++i) {
+            float t = float(i) / (lutSize - 1);
+            lut[i] = uchar(std::min(255.0f, 255.0f * std::asinh(k * t) * norm + 0.5f));
+        }
+        const float range = std::max(whitePoint - blackPoint, 1e-6f);
+        const float toLut = (lutSize - 1) / range;
+
+        for (int oy = 0; oy < outHeight; ++oy) {
+            uchar* scan = image.scanLine(oy);
+            for (int ox = 0; ox < outWidth; ++ox) {
+                // Weighted mean of the bin: sum of sums over sum of weights
+                float s = 0, w = 0;
+                for (int dy = 0; dy < bin; ++dy) {
+                    size_t row = size_t(oy * bin + dy) * width + size_t(ox) * bin;
+                    for (int dx = 0; dx < bin; ++dx) {
+                        s += sum[row + dx];
+                        w += weight[row + dx];
+                    }
+                }
+                if (w <= 0) {
+                    scan[ox] = 0;
+                    continue;
+                }
+                float index = (s / w - blackPoint) * toLut;
+                scan[ox] = lut[int(std::clamp(index, 0.0f, float(lutSize - 1)))];
+            }
+        }
+        return image;
+    }
+
+private:
+    LiveStackOptions options;
+    StarMatcher matcher;
+    StarMatcher::Reference reference;
+    DefectRejector defects;
+    WCSInfo wcs;
+
+    int width = 0;
+    int height = 0;
+    int frames = 0;
+    float referenceBackground = 0.0f;
+    float referenceSigma = 1.0f;
+    std::vector<float> sum;
+    std::vector<float> weight;
+
+    // Display stretch state, smoothed across frames
+    std::vector<size_t> samples;
+    bool stretchValid = false;
+    float blackPoint = 0.0f;
+    float whitePoint = 1.0f;
+
+    static DefectOptions defectOptions(const LiveStackOptions& options) {
+        DefectOptions result;
+        result.threads = options.threads;
+        return result;
+    }
+
+    // Warp the frame onto the stack grid and add it, split into row bands
+    void accumulate(const float* data, int frameWidth, int frameHeight,
+                    const FrameTransform& t, float offset, float frameWeight) {
+        const int bandRows = 64;
+        const int bandCount = (height + bandRows - 1) / bandRows;
+        Parallel::forEach(bandCount, std::max(1, options.threads), [&](int band) {
+            std::vector<float> row(width);
+            int y1 = std::min(height, (band + 1) * bandRows);
+            for (int y = band * bandRows; y < y1; ++y) {
+                warpRow(data, frameWidth, frameHeight, t, offset, y, row.data());
+                size_t base = size_t(y) * width;
+                accumulateRow(sum.data() + base, weight.data() + base, row.data(),
+                              frameWeight, width);
+            }
+        });
+    }
+
+    // Bilinear sample of one stack row; NaN where the frame does not cover it
+    void warpRow(const float* data, int frameWidth, int frameHeight, const FrameTransform& t,
+                 float offset, int y, float* out) const {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        double u = -t.b * y + t.tx;
+        double v = t.a * y + t.ty;
+        for (int x = 0; x < width; ++x, u += t.a, v += t.b) {
+            if (u < 0 || v < 0 || u > frameWidth - 1 || v > frameHeight - 1) {
+                out[x] = nan;
+                continue;
+            }
+            int iu = int(u);
+            int iv = int(v);
+            int iu1 = std::min(iu + 1, frameWidth - 1);
+            int iv1 = std::min(iv + 1, frameHeight - 1);
+            float fu = float(u - iu);
+            float fv = float(v - iv);
+            const float* row0 = data + size_t(iv) * frameWidth;
+            const float* row1 = data + size_t(iv1) * frameWidth;
+            float top = row0[iu] + (row0[iu1] - row0[iu]) * fu;
+            float bottom = row1[iu] + (row1[iu1] - row1[iu]) * fu;
+            out[x] = top + (bottom - top) * fv + offset;
+        }
+    }
+
+    // sum += w * v and weight += w for every non-NaN v, four lanes at a time.
+    // NaN lanes are masked out with an ordered-compare (v == v) mask.
+    static void accumulateRow(float* sumRow, float* weightRow, const float* values,
+                              float w, int count) {
+        const simd::f4 wv = simd::splat(w);
+        int x = 0;
+        for (; x + 4 <= count; x += 4) {
+            simd::f4 v = simd::load(values + x);
+            simd::f4 valid = simd::isNumber(v);
+            simd::store(sumRow + x, simd::load(sumRow + x) + simd::maskAnd(valid, v * wv));
+            simd::store(weightRow + x, simd::load(weightRow + x) + simd::maskAnd(valid, wv));
+        }
+        for (; x < count; ++x) {
+            float v = values[x];
+            if (v == v) {
+                sumRow[x] += v * w;
+                weightRow[x] += w;
+            }
+        }
+    }
+
+    // Fixed sparse grid (~64k pixels) the stretch statistics are taken from
+    void buildSampleGrid() {
+        samples.clear();
+        int step = std::max(1, int(std::sqrt(double(width) * height / 65536.0)));
+        for (int y = step / 2; y < height; y += step) {
+            for (int x = step / 2; x < width; x += step) {
+                samples.push_back(size_t(y) * width + x);
+            }
+        }
+    }
+
+    // Black point just below the sky, white point at the 99.9th percentile,
+    // blended with the previous points to keep the display from flickering
+    void updateStretch() {
+        std::vector<float> values;
+        values.reserve(samples.size());
+        for (size_t i : samples) {
+            if (weight[i] > 0) values.push_back(sum[i] / weight[i]);
+        }
+        if (values.size() < 16) return;
+
+        auto nth = [&](double fraction) {
+            size_t k = std::min(values.size() - 1, size_t(fraction * values.size()));
+            std::nth_element(values.begin(), values.begin() + k, values.end());
+            return values[k];
+        };
+        float white = nth(0.999);
+        float median = nth(0.5);
+        std::vector<float> deviations(values.size());
+        for (size_t i = 0; i < values.size(); ++i) deviations[i] = std::abs(values[i] - median);
+        std::nth_element(deviations.begin(), deviations.begin() + deviations.size() / 2, deviations.end());
+        float sigma = deviations[deviations.size() / 2] * 1.4826f;
+        float black = std::max(nth(0.001), median - 2.8f * sigma);
+        if (white <= black) white = black + std::max(sigma, 1e-6f);
+
+        if (!stretchValid) {
+            blackPoint = black;
+            whitePoint = white;
+            stretchValid = true;
+        } else {
+            float alpha = options.stretchSmoothing;
+            blackPoint += alpha * (black - blackPoint);
+            whitePoint += alpha * (white - whitePoint);
+        }
+    }
+
+    // Stars measured on the stack are better centred than on any single
+    // frame, and they are already in stack coordinates
+    void refreshReference() {
+        std::vector<float> mean = stackedImage();
+        float median, sigma;
+        if (!StarMatcher::estimateBackground(mean.data(), mean.size(), median, sigma)) return;
+        std::vector<StarMatcher::Star> stars =
+            matcher.detectStars(mean.data(), width, height, median, median + 5.0f * sigma);
+        if (stars.size() < reference.stars.size() / 2 || stars.size() < 3) return;
+        reference = matcher.makeReference(std::move(stars));
+    }
+};
+
+#endif // LIVESTACKER_H
@@ -0,0 +1,285 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Fork/join helpers for the image kernels. Work items are handed out from a
+// shared counter, so uneven stripes (e.g. ones full of stars) balance out.
+// Workers come from one persistent pool, started on first use; a run()
+// from inside a worker runs inline rather than adding threads.
+//
+// On multi-socket Linux machines pool workers are spread round-robin over
+// the NUMA nodes and stay pinned to their node's CPUs. An item runs start
+// to finish on one worker, so buffers it allocates are placed on that node
+// by first touch. Output shared by all workers must be left untouched
+// until then: allocate it as a Buffer so each worker first-touches the
+// rows it writes. DSS_NUMA=0 turns pinning off.
+namespace Parallel {
+
+// CPUs of each NUMA node, from sysfs; a single node where unavailable
+struct Topology {
+    std::vector<std::vector<int>> nodes;
+
+    int nodeCount() const { return int(nodes.size()); }
+
+    static const Topology& system() {
+        static const Topology topology = discover();
+        return topology;
+    }
+
+    // "0-15,32-47" -> 0..15, 32..47
+    static std::vector<int> parseCpuList(const QString& text) {
+        std::vector<int> cpus;
+        for (const QString& part : text.trimmed().split(',', Qt::SkipEmptyParts)) {
+            QStringList bounds = part.split('-');
+            int first = bounds[0].toInt();
+            int last = bounds.size() > 1 ? bounds[1].toInt() : first;
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+private:
+    static Topology discover() {
+        Topology topology;
+#ifdef __linux__
+        QDir root("/sys/devices/system/node");
+        QStringList names = root.entryList(QStringList() << "node*", QDir::Dirs);
+        std::sort(names.begin(), names.end(), [](const QString& a, const QString& b) {
+            return a.mid(4).toInt() < b.mid(4).toInt();
+        });
+        for (const QString& name : names) {
+            QFile file(root.filePath(name + "/cpulist"));
+            if (!file.open(QIODevice::ReadOnly)) continue;
+            std::vector<int> cpus = parseCpuList(QString::fromLatin1(file.readAll()));
+            if (!cpus.empty()) topology.nodes.push_back(cpus);
+        }
+#endif
+        if (topology.nodes.empty()) {
+            std::vector<int> all;
+            for (int cpu = 0; cpu < std::max(1, QThread::idealThreadCount()); ++cpu) all.push_back(cpu);
+            topology.nodes.push_back(all);
+        }
+        return topology;
+    }
+};
+
+inline bool numaPinning() {
+    const char* env = std::getenv("DSS_NUMA");
+    return Topology::system().nodeCount() > 1 && !(env && QString(env) == "0");
+}
+
+// Binds the current thread to one node's CPUs for its lifetime and
+// restores the previous affinity afterwards. Only CPUs the thread was
+// already allowed are used (taskset, cgroup cpusets); if the node has
+// none of them the thread is left as it was.
+class NodePin {
+public:
+    explicit NodePin(int node) {
+#ifdef __linux__
+        const Topology& topology = Topology::system();
+        if (node < 0 || node >= topology.nodeCount()) return;
+        if (pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) != 0) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : topology.nodes[node]) {
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &previous)) CPU_SET(cpu, &set);
+        }
+        if (CPU_COUNT(&set) == 0) return;
+        pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        Q_UNUSED(node);
+#endif
+    }
+
+    ~NodePin() {
+#ifdef __linux__
+        if (pinned) pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+#endif
+    }
+
+    NodePin(const NodePin&) = delete;
+    NodePin& operator=(const NodePin&) = delete;
+
+private:
+    bool pinned = false;
+#ifdef __linux__
+    cpu_set_t previous;
+#endif
+};
+
+// Leaves elements default-initialised, so resize() does not write the
+// pages of a large float buffer on the allocating thread
+template <typename T>
+struct UninitializedAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind { using other = UninitializedAllocator<U>; };
+
+    UninitializedAllocator() = default;
+    template <typename U>
+    UninitializedAllocator(const UninitializedAllocator<U>&) {}
+
+    template <typename U>
+    void construct(U* p) { ::new (static_cast<void*>(p)) U; }
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+};
+
+template <typename T>
+using Buffer = std::vector<T, UninitializedAllocator<T>>;
+
+// Threads kept for the life of the process. Each run() queues one job
+// with a number of helper slots; idle workers claim slots, and the caller
+// works too, so a job finishes even when every worker is busy elsewhere.
+class Pool {
+public:
+    static Pool& instance() {
+        static Pool pool;
+        return pool;
+    }
+
+    // True on pool workers, and on a caller while it takes part in a run
+    static bool& onWorker() {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    // fn() on the caller and up to `helpers` workers; returns once every
+    // worker that took a slot is done. `nodes` > 0 pins worker i to node
+    // (i + 1) % nodes and the caller to node 0.
+    void run(int helpers, const std::function<void()>& fn, int nodes) {
+        std::shared_ptr<Job> job;
+        if (helpers > 0) {
+            job = std::make_shared<Job>();
+            job->fn = &fn;
+            job->slots = helpers;
+            job->nodes = nodes;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                while (int(workers.size()) < helpers) {
+                    int index = int(workers.size());
+                    workers.emplace_back([this, index]() { loop(index); });
+                }
+                jobs.push_back(job);
+            }
+            wake.notify_all();
+        }
+
+        {
+            NodePin pin(nodes > 0 ? 0 : -1);
+            onWorker() = true;
+            fn();
+            onWorker() = false;
+        }
+        if (!job) return;
+
+        // Items are all claimed once fn() returns; withdraw unclaimed slots
+        std::unique_lock<std::mutex> lock(mutex);
+        jobs.erase(std::remove(jobs.begin(), jobs.end(), job), jobs.end());
+        job->slots = 0;
+        finished.wait(lock, [&job]() { return job->running == 0; });
+    }
+
+    ~Pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : workers) thread.join();
+    }
+
+private:
+    struct Job {
+        const std::function<void()>* fn = nullptr;
+        int slots = 0;
+        int running = 0;
+        int nodes = 0;
+    };
+
+    Pool() = default;
+
+    void loop(int index) {
+        onWorker() = true;
+        std::unique_ptr<NodePin> pin;
+        int pinnedNode = -1;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            std::shared_ptr<Job> job = jobs.front();
+            if (--job->slots == 0) jobs.pop_front();
+            job->running++;
+            lock.unlock();
+
+            // Pinned once; only re-pinned if DSS_NUMA changes between runs
+            int node = job->nodes > 0 ? (index + 1) % job->nodes : -1;
+            if (node != pinnedNode) {
+                pin.reset();
+                if (node >= 0) pin.reset(new NodePin(node));
+                pinnedNode = node;
+            }
+            (*job->fn)();
+
+            lock.lock();
+            if (--job->running == 0) finished.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::deque<std::shared_ptr<Job>> jobs;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+// 0 or less = one thread per core
+inline int threadCount(int requested) {
+    return requested > 0 ? requested : std::max(1, QThread::idealThreadCount());
+}
+
+// Run worker() on `threads` threads (the caller is one of them) and join.
+// Workers pull their own items, which lets them keep per-thread scratch.
+// Nested inside another run() it runs on the current thread only.
+template <typename Worker>
+void run(int threads, Worker&& worker) {
+    if (Pool::onWorker()) {
+        worker();
+        return;
+    }
+    const int nodes = numaPinning() ? Topology::system().nodeCount() : 0;
+    std::function<void()> fn = [&worker]() { worker(); };
+    Pool::instance().run(std::max(0, threads - 1), fn, nodes);
+}
+
+// fn(i) for every i in [0, count)
+template <typename Fn>
+void forEach(int count, int threads, Fn&& fn) {
+    std::atomic<int> next{0};
+    run(std::min(threads, count), [&]() {
+        for (int i = next++; i < count; i = next++) fn(i);
+    });
+}
+
+} // namespace Parallel
+
+#endif // PARALLEL_H
@@ -0,0 +1,578 @@
+#ifndef PHOTOMETRICCALIBRATOR_H
+#define PHOTOMETRICCALIBRATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include <fitsio.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "FitsProcessor.h"
+#include "StarMatcher.h"
+
+// Reference star: position (degrees), magnitude and colour index
+struct CatalogStar {
+    double ra = 0.0;
+    double dec = 0.0;
+    float mag = 0.0f;
+    float color = std::numeric_limits<float>::quiet_NaN();   // NaN = unknown
+};
+
+// Static kd-tree over unit vectors, built once per field. A cone search of
+// radius r is a Euclidean search of chord 2*sin(r/2), so there are no
+// RA wrap or pole special cases.
+class CatalogIndex {
+public:
+    CatalogIndex() = default;
+
+    explicit CatalogIndex(std::vector<CatalogStar> catalog) : stars(std::move(catalog)) {
+        nodes.reserve(stars.size());
+        for (size_t i = 0; i < stars.size(); ++i) {
+            Node node;
+            toVector(stars[i].ra, stars[i].dec, node.p);
+            node.star = int(i);
+            nodes.push_back(node);
+        }
+        build(0, nodes.size(), 0);
+    }
+
+    size_t size() const { return stars.size(); }
+    bool isEmpty() const { return stars.empty(); }
+    const CatalogStar& star(int i) const { return stars[i]; }
+
+    // Closest catalog star within radiusArcsec, or -1
+    int nearest(double ra, double dec, double radiusArcsec) const {
+        if (nodes.empty()) return -1;
+        double q[3];
+        toVector(ra, dec, q);
+        double chord = 2.0 * std::sin(radiusArcsec / 3600.0 * M_PI / 360.0);
+        double best = chord * chord;
+        int bestStar = -1;
+        search(0, nodes.size(), 0, q, best, bestStar);
+        return bestStar;
+    }
+
+private:
+    struct Node {
+        double p[3];
+        int star;
+    };
+
+    std::vector<CatalogStar> stars;
+    std::vector<Node> nodes;    // implicit tree: median of each range is its root
+
+    static void toVector(double ra, double dec, double* p) {
+        double a = ra * M_PI / 180.0, d = dec * M_PI / 180.0;
+        p[0] = std::cos(d) * std::cos(a);
+        p[1] = std::cos(d) * std::sin(a);
+        p[2] = std::sin(d);
+    }
+
+    void build(size_t lo, size_t hi, int axis) {
+        if (hi - lo < 2) return;
+        size_t mid = lo + (hi - lo) / 2;
+        std::nth_element(nodes.begin() + lo, nodes.begin() + mid, nodes.begin() + hi,
+                         [axis](const Node& a, const Node& b) { return a.p[axis] < b.p[axis]; });
+        build(lo, mid, (axis + 1) % 3);
+        build(mid + 1, hi, (axis + 1) % 3);
+    }
+
+    void search(size_t lo, size_t hi, int axis, const double* q, double& best, int& bestStar) const {
+        if (lo >= hi) return;
+        size_t mid = lo + (hi - lo) / 2;
+        const Node& node = nodes[mid];
+        double dx = node.p[0] - q[0], dy = node.p[1] - q[1], dz = node.p[2] - q[2];
+        double d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 < best) {
+            best = d2;
+            bestStar = node.star;
+        }
+        double split = q[axis] - node.p[axis];
+        int next = (axis + 1) % 3;
+        // Near side first; the far side only if the splitting plane is in range
+        if (split < 0) {
+            search(lo, mid, next, q, best, bestStar);
+            if (split * split < best) search(mid + 1, hi, next, q, best, bestStar);
+        } else {
+            search(mid + 1, hi, next, q, best, bestStar);
+            if (split * split < best) search(lo, mid, next, q, best, bestStar);
+        }
+    }
+};
+
+struct PhotometryOptions {
+    int maxStars = 300;                 // Brightest detections measured per frame
+    float detectSigma = 5.0f;           // Detection threshold above sky
+    double matchRadiusArcsec = 3.0;     // Cross-match cone (plus half a pixel)
+    double apertureFwhm = 1.5;          // Aperture radius in units of FWHM
+    double annulusInner = 3.0;          // Sky annulus radii in units of FWHM
+    double annulusOuter = 5.0;
+    double defaultFwhm = 3.0;           // Pixels, when it can't be measured
+    float gain = 1.0f;                  // e-/ADU for the Poisson error term
+
+    // Robust fit: catalog - instrumental = ZP + CT * colour
+    float clipSigma = 3.0f;
+    int iterations = 5;
+    double maxError = 0.1;              // Instrumental mag error cut for the fit
+    int minColorStars = 15;             // Fewer than this: zero point only
+    double minColorRange = 0.5;         // Colour spread (10-90%) needed for a colour term
+    float defaultColor = 0.8f;          // Assumed colour for uncatalogued stars
+};
+
+// One measured star, calibrated once the solution is known
+struct PhotometricStar {
+    double x = 0.0, y = 0.0;            // 0-based pixel centroid
+    double ra = 0.0, dec = 0.0;
+    double instMag = 0.0;               // -2.5 log10(ADU)
+    double instError = 0.0;
+    int catalogIndex = -1;              // -1 = no catalog counterpart
+    float catalogMag = 0.0f;
+    float color = 0.0f;
+    bool used = false;                  // Survived clipping in the fit
+    double calibratedMag = 0.0;
+    double calibratedError = 0.0;
+};
+
+// Catalog query covering one or more frames
+struct CatalogCone {
+    double ra = 0.0;
+    double dec = 0.0;
+    double radiusArcmin = 0.0;      // Covers every member frame
+    double seedRadiusArcmin = 0.0;  // Field of the frame that opened the cone
+};
+
+struct PhotometricSolution {
+    bool ok = false;
+    QString error;
+    double zeroPoint = 0.0;
+    double zeroPointError = 0.0;
+    double colorTerm = 0.0;
+    bool hasColorTerm = false;
+    double rms = 0.0;                   // Of the fit residuals (mag)
+    double fwhm = 0.0;                  // Used for the aperture (pixels)
+    int measured = 0;
+    int matched = 0;
+    int used = 0;
+};
+
+// Per-frame photometric zero point against a reference catalog. Each frame
+// costs one background estimate, one detection pass, a few hundred small
+// apertures and one kd-tree lookup per star, so the batch can calibrate
+// every frame. The catalog index is read-only and can be shared by workers.
+class PhotometricCalibrator {
+public:
+    explicit PhotometricCalibrator(const CatalogIndex& catalog,
+                                   const PhotometryOptions& options = PhotometryOptions())
+        : catalog(catalog), options(options) {}
+
+    // Measure, match and fit. fwhm <= 0 measures it from the stars.
+    PhotometricSolution calibrate(const float* data, int width, int height, const WCSInfo& wcs,
+                                  std::vector<PhotometricStar>* starsOut = nullptr,
+                                  double fwhm = 0.0) const {
+        PhotometricSolution solution;
+        if (!wcs.isValid) {
+            solution.error = "no WCS";
+            return solution;
+        }
+        if (catalog.isEmpty()) {
+            solution.error = "empty catalog";
+            return solution;
+        }
+
+        float sky, noise;
+        if (!StarMatcher::estimateBackground(data, size_t(width) * height, sky, noise)) {
+            solution.error = "empty frame";
+            return solution;
+        }
+
+        StarMatcher detector;
+        detector.maxStars = options.maxStars;
+        std::vector<StarMatcher::Star> detections =
+            detector.detectStars(data, width, height, sky, sky + options.detectSigma * noise);
+
+        if (fwhm <= 0) fwhm = measureFwhm(data, width, height, sky, detections);
+        if (fwhm <= 0) fwhm = options.defaultFwhm;
+        solution.fwhm = fwhm;
+
+        std::vector<PhotometricStar> stars;
+        stars.reserve(detections.size());
+        double pixelArcsec = std::abs(wcs.cdelt1) * 3600.0;
+        double radius = options.matchRadiusArcsec + 0.5 * pixelArcsec;
+        for (const StarMatcher::Star& detection : detections) {
+            PhotometricStar star;
+            star.x = detection.x;
+            star.y = detection.y;
+            if (measureAperture(data, width, height, fwhm, star)) stars.push_back(star);
+        }
+
+        // Sky positions of all measured stars in one batch (FITS pixels are 1-based)
+        std::vector<double> px(stars.size()), py(stars.size()), ra, dec;
+        for (size_t i = 0; i < stars.size(); ++i) {
+            px[i] = stars[i].x + 1.0;
+            py[i] = stars[i].y + 1.0;
+        }
+        wcs.pixelsToWorld(px, py, ra, dec);
+
+        for (size_t i = 0; i < stars.size(); ++i) {
+            PhotometricStar& star = stars[i];
+            star.ra = ra[i];
+            star.dec = dec[i];
+            star.catalogIndex = catalog.nearest(star.ra, star.dec, radius);
+            if (star.catalogIndex >= 0) {
+                const CatalogStar& ref = catalog.star(star.catalogIndex);
+                star.catalogMag = ref.mag;
+                star.color = std::isfinite(ref.color) ? ref.color : options.defaultColor;
+                solution.matched++;
+            } else {
+                star.color = options.defaultColor;
+            }
+        }
+        solution.measured = stars.size();
+
+        fit(stars, solution);
+
+        if (solution.ok) {
+            for (PhotometricStar& star : stars) {
+                star.calibratedMag = star.instMag + solution.zeroPoint + solution.colorTerm * star.color;
+                star.calibratedError = std::hypot(star.instError, solution.zeroPointError);
+            }
+        }
+        if (starsOut) *starsOut = std::move(stars);
+        return solution;
+    }
+
+    // Cone covering a frame (centre and half-diagonal), from its header only
+    static bool fieldOfView(const QString& filename, double& ra, double& dec, double& radiusArcmin) {
+        fitsfile* fptr = nullptr;
+        int status = 0;
+        if (fits_open_file(&fptr, filename.toLocal8Bit().constData(), READONLY, &status)) {
+            fits_report_error(stderr, status);
+            return false;
+        }
+        long naxes[2] = {0, 0};
+        fits_get_img_size(fptr, 2, naxes, &status);
+        WCSInfo wcs = FitsProcessor::readWCS(fptr);
+        fits_close_file(fptr, &status);
+        if (!wcs.isValid || naxes[0] <= 0 || naxes[1] <= 0) return false;
+
+        wcs.pixelToWorld(0.5 * (naxes[0] + 1), 0.5 * (naxes[1] + 1), ra, dec);
+        radiusArcmin = 0.5 * std::hypot(naxes[0] * wcs.cdelt1, naxes[1] * wcs.cdelt2) * 60.0;
+        return true;
+    }
+
+    // Group frames into catalog cones. A frame whose centre falls inside the
+    // field of a cone's first frame joins it and the cone grows to cover it,
+    // so dithered frames of one target share a query while frames pointing
+    // elsewhere get their own. coneOf[i] is -1 for frames without a WCS.
+    static QList<CatalogCone> planCones(const QStringList& files, std::vector<int>& coneOf) {
+        QList<CatalogCone> cones;
+        coneOf.assign(size_t(files.size()), -1);
+        for (int i = 0; i < files.size(); ++i) {
+            double ra, dec, radius;
+            if (!fieldOfView(files[i], ra, dec, radius)) continue;
+            spherical::Vec3 p = spherical::fromRaDec(ra, dec);
+
+            for (int c = 0; c < cones.size() && coneOf[i] < 0; ++c) {
+                spherical::Vec3 q = spherical::fromRaDec(cones[c].ra, cones[c].dec);
+                double dot = std::max(-1.0, std::min(1.0, p.x * q.x + p.y * q.y + p.z * q.z));
+                double separation = std::acos(dot) * 180.0 / M_PI * 60.0;
+                if (separation <= cones[c].seedRadiusArcmin) {
+                    cones[c].radiusArcmin = std::max(cones[c].radiusArcmin, separation + radius);
+                    coneOf[i] = c;
+                }
+            }
+            if (coneOf[i] < 0) {
+                coneOf[i] = cones.size();
+                cones << CatalogCone{ra, dec, radius, radius};
+            }
+        }
+        return cones;
+    }
+
+    // VizieR TSV (comment lines, header, units and dashes) or CSV with a
+    // header row. Columns are found by name; the first of each list wins.
+    static std::vector<CatalogStar> parseCatalog(const QByteArray& text,
+                                                 const QStringList& magColumns = {"Gmag", "mag", "Vmag", "rmag"},
+                                                 const QStringList& colorColumns = {"BP-RP", "color", "B-V", "g-r"}) {
+        std::vector<CatalogStar> stars;
+        QList<QByteArray> lines = text.split('\n');
+        int raCol = -1, decCol = -1, magCol = -1, colorCol = -1;
+        char separator = '\t';
+        bool haveHeader = false;
+
+        for (const QByteArray& rawLine : lines) {
+            QByteArray line = rawLine.trimmed();
+            if (line.isEmpty() || line.startsWith('#')) continue;
+
+            if (!haveHeader) {
+                separator = line.contains('\t') ? '\t' : ',';
+                QStringList names;
+                for (const QByteArray& field : line.split(separator)) {
+                    names << QString::fromLatin1(field.trimmed());
+                }
+                auto find = [&names](const QStringList& candidates) {
+                    for (const QString& candidate : candidates) {
+                        for (int i = 0; i < names.size(); ++i) {
+                            if (names[i].compare(candidate, Qt::CaseInsensitive) == 0) return i;
+                        }
+                    }
+                    return -1;
+                };
+                raCol = find({"RA_ICRS", "RAJ2000", "_RAJ2000", "ra"});
+                decCol = find({"DE_ICRS", "DEJ2000", "_DEJ2000", "dec"});
+                magCol = find(magColumns);
+                colorCol = find(colorColumns);
+                if (raCol < 0 || decCol < 0 || magCol < 0) {
+                    qDebug() << "Catalog header lacks position or magnitude columns:" << line;
+                    return stars;
+                }
+                haveHeader = true;
+                continue;
+            }
+
+            // Units and dashes rows simply fail to parse. Split the untrimmed
+            // line: a blank last column (no colour) is still a column.
+            QList<QByteArray> fields = rawLine.split(separator);
+            if (fields.size() <= std::max({raCol, decCol, magCol})) continue;
+            bool raOk, decOk, magOk, colorOk = false;
+            CatalogStar star;
+            star.ra = fields[raCol].trimmed().toDouble(&raOk);
+            star.dec = fields[decCol].trimmed().toDouble(&decOk);
+            star.mag = fields[magCol].trimmed().toFloat(&magOk);
+            if (colorCol >= 0 && colorCol < fields.size()) {
+                float color = fields[colorCol].trimmed().toFloat(&colorOk);
+                if (colorOk) star.color = color;
+            }
+            if (raOk && decOk && magOk) stars.push_back(star);
+        }
+        return stars;
+    }
+
+    // PHOTZP and friends into the primary header
+    static bool annotateFits(const QString& filename, const PhotometricSolution& solution,
+                             const QString& catalogName = QString()) {
+        fitsfile* fptr = nullptr;
+        int status = 0;
+        if (fits_open_file(&fptr, filename.toLocal8Bit().constData(), READWRITE, &status)) {
+            fits_report_error(stderr, status);
+            return false;
+        }
+        double zp = solution.zeroPoint, zpErr = solution.zeroPointError;
+        double ct = solution.colorTerm, rms = solution.rms;
+        int used = solution.used;
+        fits_update_key(fptr, TDOUBLE, "PHOTZP", &zp, "Photometric zero point (mag)", &status);
+        fits_update_key(fptr, TDOUBLE, "PHOTZPER", &zpErr, "Zero point uncertainty (mag)", &status);
+        fits_update_key(fptr, TDOUBLE, "PHOTCT", &ct, "Colour term", &status);
+        fits_update_key(fptr, TDOUBLE, "PHOTRMS", &rms, "Calibration residual RMS (mag)", &status);
+        fits_update_key(fptr, TINT, "PHOTNSTR", &used, "Stars used in the calibration", &status);
+        if (!catalogName.isEmpty()) {
+            QByteArray name = catalogName.toLatin1();
+            fits_update_key(fptr, TSTRING, "PHOTCAT", name.data(), "Reference catalog", &status);
+        }
+        fits_close_file(fptr, &status);
+        if (status) {
+            fits_report_error(stderr, status);
+            return false;
+        }
+        return true;
+    }
+
+    static bool writeStarsCsv(const QString& filename, const std::vector<PhotometricStar>& stars) {
+        QFile file(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qDebug() << "Failed to write star list:" << filename;
+            return false;
+        }
+        QTextStream out(&file);
+        out << "x,y,ra,dec,inst_mag,inst_err,cal_mag,cal_err,catalog_mag,color,matched,used\n";
+        for (const PhotometricStar& s : stars) {
+            out << QString::number(s.x, 'f', 2) << ',' << QString::number(s.y, 'f', 2) << ','
+                << QString::number(s.ra, 'f', 6) << ',' << QString::number(s.dec, 'f', 6) << ','
+                << QString::number(s.instMag, 'f', 4) << ',' << QString::number(s.instError, 'f', 4) << ','
+                << QString::number(s.calibratedMag, 'f', 4) << ','
+                << QString::number(s.calibratedError, 'f', 4) << ','
+                << (s.catalogIndex >= 0 ? QString::number(s.catalogMag, 'f', 3) : QString()) << ','
+                << QString::number(s.color, 'f', 3) << ','
+                << (s.catalogIndex >= 0 ? 1 : 0) << ',' << (s.used ? 1 : 0) << '\n';
+        }
+        return true;
+    }
+
+private:
+    const CatalogIndex& catalog;
+    PhotometryOptions options;
+
+    // Median second-moment FWHM of the brightest few dozen detections
+    static double measureFwhm(const float* data, int width, int height, float sky,
+                              const std::vector<StarMatcher::Star>& stars) {
+        const int r = 6;
+        std::vector<double> fwhms;
+        for (size_t i = 0; i < stars.size() && fwhms.size() < 50; ++i) {
+            int cx = int(std::lround(stars[i].x));
+            int cy = int(std::lround(stars[i].y));
+            if (cx < r || cy < r || cx >= width - r || cy >= height - r) continue;
+            double sum = 0, sxx = 0, syy = 0;
+            for (int dy = -r; dy <= r; ++dy) {
+                const float* row = data + size_t(cy + dy) * width;
+                for (int dx = -r; dx <= r; ++dx) {
+                    double w = row[cx + dx] - sky;
+                    if (!(w > 0)) continue;
+                    double px = cx + dx - stars[i].x, py = cy + dy - stars[i].y;
+                    sum += w;
+                    sxx += w * px * px;
+                    syy += w * py * py;
+                }
+            }
+            if (sum > 0) fwhms.push_back(2.3548 * std::sqrt(0.5 * (sxx + syy) / sum));
+        }
+        if (fwhms.empty()) return 0.0;
+        std::nth_element(fwhms.begin(), fwhms.begin() + fwhms.size() / 2, fwhms.end());
+        return fwhms[fwhms.size() / 2];
+    }
+
+    // Circular aperture with a local sky median from the annulus. Rejects
+    // stars whose aperture leaves the frame or touches blank (NaN) pixels.
+    bool measureAperture(const float* data, int width, int height, double fwhm,
+                         PhotometricStar& star) const {
+        double rAp = std::max(2.0, options.apertureFwhm * fwhm);
+        double rIn = std::max(rAp + 1.0, options.annulusInner * fwhm);
+        double rOut = std::max(rIn + 2.0, options.annulusOuter * fwhm);
+        int reach = int(std::ceil(rOut));
+        int cx = int(std::lround(star.x));
+        int cy = int(std::lround(star.y));
+        if (cx < reach || cy < reach || cx >= width - reach || cy >= height - reach) return false;
+
+        double sum = 0;
+        int apPixels = 0;
+        std::vector<float> annulus;
+        annulus.reserve(size_t(M_PI * (rOut * rOut - rIn * rIn)) + 8);
+        for (int dy = -reach; dy <= reach; ++dy) {
+            const float* row = data + size_t(cy + dy) * width;
+            double py = cy + dy - star.y;
+            for (int dx = -reach; dx <= reach; ++dx) {
+                double px = cx + dx - star.x;
+                double d2 = px * px + py * py;
+                float v = row[cx + dx];
+                if (d2 <= rAp * rAp) {
+                    if (!std::isfinite(v)) return false;
+                    sum += v;
+                    apPixels++;
+                } else if (d2 >= rIn * rIn && d2 <= rOut * rOut && std::isfinite(v)) {
+                    annulus.push_back(v);
+                }
+            }
+        }
+        if (annulus.size() < 10 || apPixels == 0) return false;
+
+        size_t mid = annulus.size() / 2;
+        std::nth_element(annulus.begin(), annulus.begin() + mid, annulus.end());
+        double skyLevel = annulus[mid];
+        for (float& v : annulus) v = std::abs(v - float(skyLevel));
+        std::nth_element(annulus.begin(), annulus.begin() + mid, annulus.end());
+        double skySigma = annulus[mid] * 1.4826;
+
+        double flux = sum - apPixels * skyLevel;
+        if (!(flux > 0)) return false;
+        double variance = flux / options.gain +
+                          apPixels * skySigma * skySigma * (1.0 + double(apPixels) / annulus.size());
+        star.instMag = -2.5 * std::log10(flux);
+        star.instError = 1.0857 * std::sqrt(variance) / flux;
+        return true;
+    }
+
+    // Weighted least squares of (catalog - instrumental) on colour, with
+    // MAD sigma-clipping. Falls back to a zero point alone when too few
+    // stars or too narrow a colour range would make the slope noise.
+    void fit(std::vector<PhotometricStar>& stars, PhotometricSolution& solution) const {
+        std::vector<int> candidates;
+        std::vector<float> colors;
+        for (int i = 0; i < int(stars.size()); ++i) {
+            const PhotometricStar& s = stars[i];
+            if (s.catalogIndex < 0 || s.instError > options.maxError) continue;
+            candidates.push_back(i);
+            colors.push_back(s.color);
+        }
+        if (candidates.size() < 3) {
+            solution.error = QString("only %1 catalog matches").arg(candidates.size());
+            return;
+        }
+
+        std::sort(colors.begin(), colors.end());
+        double colorRange = colors[colors.size() * 9 / 10] - colors[colors.size() / 10];
+        bool withColor = int(candidates.size()) >= options.minColorStars &&
+                         colorRange >= options.minColorRange;
+
+        std::vector<char> keep(candidates.size(), 1);
+        double zp = 0, ct = 0, zpError = 0, rms = 0;
+        int used = 0;
+        for (int iteration = 0; iteration < options.iterations; ++iteration) {
+            // Weighted normal equations for y = zp + ct * c
+            double sw = 0, swc = 0, swcc = 0, swy = 0, swcy = 0;
+            for (size_t k = 0; k < candidates.size(); ++k) {
+                if (!keep[k]) continue;
+                const PhotometricStar& s = stars[candidates[k]];
+                double w = 1.0 / (s.instError * s.instError + 1e-4);
+                double y = s.catalogMag - s.instMag;
+                sw += w;
+                swc += w * s.color;
+                swcc += w * s.color * s.color;
+                swy += w * y;
+                swcy += w * s.color * y;
+            }
+            double det = sw * swcc - swc * swc;
+            if (withColor && det > 1e-12 * sw * sw) {
+                ct = (sw * swcy - swc * swy) / det;
+                zp = (swy - ct * swc) / sw;
+            } else {
+                ct = 0;
+                zp = swy / sw;
+            }
+
+            std::vector<double> residuals;
+            for (size_t k = 0; k < candidates.size(); ++k) {
+                if (!keep[k]) continue;
+                const PhotometricStar& s = stars[candidates[k]];
+                residuals.push_back(s.catalogMag - s.instMag - zp - ct * s.color);
+            }
+            used = residuals.size();
+            double sumSq = 0;
+            for (double r : residuals) sumSq += r * r;
+            rms = std::sqrt(sumSq / used);
+            zpError = rms / std::sqrt(double(used));
+
+            for (double& r : residuals) r = std::abs(r);
+            std::nth_element(residuals.begin(), residuals.begin() + residuals.size() / 2, residuals.end());
+            double sigma = std::max(residuals[residuals.size() / 2] * 1.4826, 0.005);
+
+            bool changed = false;
+            for (size_t k = 0; k < candidates.size(); ++k) {
+                const PhotometricStar& s = stars[candidates[k]];
+                double r = std::abs(s.catalogMag - s.instMag - zp - ct * s.color);
+                char inside = r <= options.clipSigma * sigma;
+                if (inside != keep[k]) {
+                    keep[k] = inside;
+                    changed = true;
+                }
+            }
+            if (!changed) break;
+            if (std::count(keep.begin(), keep.end(), 1) < 3) break;
+        }
+
+        for (size_t k = 0; k < candidates.size(); ++k) stars[candidates[k]].used = keep[k];
+        solution.zeroPoint = zp;
+        solution.colorTerm = ct;
+        solution.hasColorTerm = withColor;
+        solution.zeroPointError = zpError;
+        solution.rms = rms;
+        solution.used = used;
+        solution.ok = true;
+    }
+};
+
+#endif // PHOTOMETRICCALIBRATOR_H
@@ -0,0 +1,152 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MATCHER_SIMD_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define MATCHER_SIMD_NEON 1
+#endif
+
+// Four-lane float vector over SSE2, NEON (AArch64) or plain arrays, so the
+// image kernels are written once. Comparisons return lane masks (all bits
+// set where true) for use with select()/maskAnd().
+namespace simd {
+
+#if defined(MATCHER_SIMD_SSE2)
+
+struct f4 { __m128 v; };
+
+inline f4 load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline void store(float* p, f4 a) { _mm_storeu_ps(p, a.v); }
+inline f4 splat(float x) { return {_mm_set1_ps(x)}; }
+inline f4 operator+(f4 a, f4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline f4 operator-(f4 a, f4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline f4 operator*(f4 a, f4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline f4 operator/(f4 a, f4 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline f4 max(f4 a, f4 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline f4 min(f4 a, f4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline f4 sqrt(f4 a) { return {_mm_sqrt_ps(a.v)}; }
+inline f4 abs(f4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline f4 greater(f4 a, f4 b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline f4 less(f4 a, f4 b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline f4 isNumber(f4 a) { return {_mm_cmpord_ps(a.v, a.v)}; }
+inline f4 maskAnd(f4 mask, f4 a) { return {_mm_and_ps(mask.v, a.v)}; }
+inline f4 maskOr(f4 a, f4 b) { return {_mm_or_ps(a.v, b.v)}; }
+inline f4 select(f4 mask, f4 a, f4 b) {
+    return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+inline int movemask(f4 mask) { return _mm_movemask_ps(mask.v); }
+
+#elif defined(MATCHER_SIMD_NEON)
+
+struct f4 { float32x4_t v; };
+
+inline f4 load(const float* p) { return {vld1q_f32(p)}; }
+inline void store(float* p, f4 a) { vst1q_f32(p, a.v); }
+inline f4 splat(float x) { return {vdupq_n_f32(x)}; }
+inline f4 operator+(f4 a, f4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline f4 operator-(f4 a, f4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline f4 operator*(f4 a, f4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline f4 operator/(f4 a, f4 b) { return {vdivq_f32(a.v, b.v)}; }
+inline f4 max(f4 a, f4 b) { return {vmaxq_f32(a.v, b.v)}; }
+inline f4 min(f4 a, f4 b) { return {vminq_f32(a.v, b.v)}; }
+inline f4 sqrt(f4 a) { return {vsqrtq_f32(a.v)}; }
+inline f4 abs(f4 a) { return {vabsq_f32(a.v)}; }
+inline f4 greater(f4 a, f4 b) { return {vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v))}; }
+inline f4 less(f4 a, f4 b) { return {vreinterpretq_f32_u32(vcltq_f32(a.v, b.v))}; }
+inline f4 isNumber(f4 a) { return {vreinterpretq_f32_u32(vceqq_f32(a.v, a.v))}; }
+inline f4 maskAnd(f4 mask, f4 a) {
+    return {vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(mask.v), vreinterpretq_u32_f32(a.v)))};
+}
+inline f4 maskOr(f4 a, f4 b) {
+    return {vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))};
+}
+inline f4 select(f4 mask, f4 a, f4 b) {
+    return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)};
+}
+inline int movemask(f4 mask) {
+    uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(mask.v), 31);
+    return int(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) |
+               (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+}
+
+#else
+
+struct f4 { float v[4]; };
+
+namespace detail {
+inline float maskBits(bool on) {
+    uint32_t bits = on ? 0xFFFFFFFFu : 0u;
+    float f;
+    std::memcpy(&f, &bits, sizeof f);
+    return f;
+}
+inline uint32_t bitsOf(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof bits);
+    return bits;
+}
+inline float fromBits(uint32_t bits) {
+    float f;
+    std::memcpy(&f, &bits, sizeof f);
+    return f;
+}
+template <typename Op>
+inline f4 map(f4 a, f4 b, Op op) {
+    f4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = op(a.v[i], b.v[i]);
+    return r;
+}
+} // namespace detail
+
+inline f4 load(const float* p) { f4 r; std::memcpy(r.v, p, sizeof r.v); return r; }
+inline void store(float* p, f4 a) { std::memcpy(p, a.v, sizeof a.v); }
+inline f4 splat(float x) { return {{x, x, x, x}}; }
+inline f4 operator+(f4 a, f4 b) { return detail::map(a, b, [](float x, float y) { return x + y; }); }
+inline f4 operator-(f4 a, f4 b) { return detail::map(a, b, [](float x, float y) { return x - y; }); }
+inline f4 operator*(f4 a, f4 b) { return detail::map(a, b, [](float x, float y) { return x * y; }); }
+inline f4 operator/(f4 a, f4 b) { return detail::map(a, b, [](float x, float y) { return x / y; }); }
+inline f4 max(f4 a, f4 b) { return detail::map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+inline f4 min(f4 a, f4 b) { return detail::map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+inline f4 sqrt(f4 a) { f4 r; for (int i = 0; i < 4; ++i) r.v[i] = std::sqrt(a.v[i]); return r; }
+inline f4 abs(f4 a) { f4 r; for (int i = 0; i < 4; ++i) r.v[i] = std::fabs(a.v[i]); return r; }
+inline f4 greater(f4 a, f4 b) {
+    return detail::map(a, b, [](float x, float y) { return detail::maskBits(x > y); });
+}
+inline f4 less(f4 a, f4 b) {
+    return detail::map(a, b, [](float x, float y) { return detail::maskBits(x < y); });
+}
+inline f4 isNumber(f4 a) { return detail::map(a, a, [](float x, float) { return detail::maskBits(x == x); }); }
+inline f4 maskAnd(f4 mask, f4 a) {
+    return detail::map(mask, a, [](float m, float x) {
+        return detail::fromBits(detail::bitsOf(m) & detail::bitsOf(x));
+    });
+}
+inline f4 maskOr(f4 a, f4 b) {
+    return detail::map(a, b, [](float x, float y) {
+        return detail::fromBits(detail::bitsOf(x) | detail::bitsOf(y));
+    });
+}
+inline f4 select(f4 mask, f4 a, f4 b) {
+    f4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = detail::bitsOf(mask.v[i]) ? a.v[i] : b.v[i];
+    return r;
+}
+inline int movemask(f4 mask) {
+    int bits = 0;
+    for (int i = 0; i < 4; ++i) bits |= (detail::bitsOf(mask.v[i]) >> 31) << i;
+    return bits;
+}
+
+#endif
+
+} // namespace simd
+
+#endif // SIMD_H
@@ -0,0 +1,275 @@
+#ifndef STARMATCHER_H
+#define STARMATCHER_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// Similarity transform mapping reference pixels (x, y) to frame pixels (u, v):
+// u = a*x - b*y + tx,  v = b*x + a*y + ty
+struct FrameTransform {
+    double a = 1.0, b = 0.0, tx = 0.0, ty = 0.0;
+    double rms = 0.0;       // Residual of matched stars in pixels
+    int matchedStars = 0;
+
+    void apply(double x, double y, double& u, double& v) const {
+        u = a * x - b * y + tx;
+        v = b * x + a * y + ty;
+    }
+    double scale() const { return std::sqrt(a * a + b * b); }
+    double rotationDeg() const { return std::atan2(b, a) * 180.0 / M_PI; }
+};
+
+// Star detection and triangle-similarity registration shared by the batch
+// and live stackers. A reference star list is indexed once (triangles sorted
+// by side ratio), after which each frame costs one detection pass plus a
+// binary search per frame triangle.
+class StarMatcher {
+public:
+    struct Star {
+        double x, y;
+        double flux;
+    };
+
+    // Vertices ordered opposite the longest, middle and shortest side, so two
+    // similar triangles pair their vertices in the same order
+    struct Triangle {
+        int v[3];
+        float r1, r2;   // middle/longest and shortest/longest side ratios
+    };
+
+    // Stars plus their triangle index; build once per reference
+    struct Reference {
+        std::vector<Star> stars;
+        std::vector<Triangle> triangles;
+    };
+
+    int maxStars = 40;          // Brightest stars kept per frame
+    int matchStars = 25;        // Stars used to build triangles
+    float tolerance = 0.005f;   // Side-ratio match tolerance
+    double maxResidual = 2.0;   // Pixels; larger residuals are outliers
+
+    // Sky level and noise from every `step`-th pixel (median / MAD).
+    // Returns false when no finite samples exist.
+    static bool estimateBackground(const float* data, size_t count, float& median, float& sigma,
+                                   size_t step = 16) {
+        std::vector<float> sample;
+        sample.reserve(count / step + 1);
+        for (size_t i = 0; i < count; i += step) {
+            if (std::isfinite(data[i])) sample.push_back(data[i]);
+        }
+        if (sample.empty()) return false;
+        std::nth_element(sample.begin(), sample.begin() + sample.size() / 2, sample.end());
+        median = sample[sample.size() / 2];
+        for (float& v : sample) v = std::abs(v - median);
+        std::nth_element(sample.begin(), sample.begin() + sample.size() / 2, sample.end());
+        sigma = std::max(sample[sample.size() / 2] * 1.4826f, 1e-6f);
+        return true;
+    }
+
+    // Brightest round local maxima above `threshold`, sorted by flux
+    std::vector<Star> detectStars(const float* data, int width, int height,
+                                  float background, float threshold) const {
+        std::vector<Star> stars;
+        const int border = 4;
+        for (int y = border; y < height - border; ++y) {
+            const float* row = data + size_t(y) * width;
+            for (int x = border; x < width - border; ++x) {
+                float v = row[x];
+                if (!(v > threshold)) continue;
+
+                // Strict local maximum over 3x3 (ties broken towards the top-left)
+                bool isMax = true;
+                for (int dy = -1; dy <= 1 && isMax; ++dy) {
+                    const float* nrow = row + dy * width;
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        if (dx == 0 && dy == 0) continue;
+                        float nv = nrow[x + dx];
+                        if (nv > v || (nv == v && (dy < 0 || (dy == 0 && dx < 0)))) {
+                            isMax = false;
+                            break;
+                        }
+                    }
+                }
+                if (!isMax) continue;
+
+                // Background-subtracted centroid and second moments over 5x5
+                double sum = 0, sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+                for (int dy = -2; dy <= 2; ++dy) {
+                    const float* nrow = row + dy * width;
+                    for (int dx = -2; dx <= 2; ++dx) {
+                        double w = nrow[x + dx] - background;
+                        if (!(w > 0)) continue;    // also skips NaN
+                        sum += w;
+                        sx += w * dx;
+                        sy += w * dy;
+                        sxx += w * dx * dx;
+                        syy += w * dy * dy;
+                        sxy += w * dx * dy;
+                    }
+                }
+                if (sum <= 0) continue;
+                double cx = sx / sum, cy = sy / sum;
+                double mxx = sxx / sum - cx * cx;
+                double myy = syy / sum - cy * cy;
+                double mxy = sxy / sum - cx * cy;
+
+                // Skip elongated peaks (trails, edges): axis ratio above 2
+                double half = 0.5 * (mxx + myy);
+                double diff = std::sqrt(0.25 * (mxx - myy) * (mxx - myy) + mxy * mxy);
+                double major = half + diff, minor = half - diff;
+                if (minor <= 0 || major > 4.0 * minor) continue;
+
+                stars.push_back({x + cx, y + cy, sum});
+            }
+        }
+
+        std::sort(stars.begin(), stars.end(),
+                  [](const Star& a, const Star& b) { return a.flux > b.flux; });
+        if (int(stars.size()) > maxStars) stars.resize(maxStars);
+        return stars;
+    }
+
+    Reference makeReference(std::vector<Star> stars) const {
+        Reference ref;
+        ref.stars = std::move(stars);
+        ref.triangles = buildTriangles(ref.stars);
+        return ref;
+    }
+
+    // Find the transform taking reference pixels to frame pixels
+    bool match(const Reference& ref, const std::vector<Star>& frameStars,
+               FrameTransform& transform) const {
+        if (ref.stars.size() < 3 || frameStars.size() < 3) return false;
+
+        std::vector<Triangle> frameTriangles = buildTriangles(frameStars);
+
+        // Each similar triangle pair votes for its three vertex correspondences
+        int refCount = ref.stars.size();
+        int frameCount = frameStars.size();
+        std::vector<int> votes(size_t(refCount) * frameCount, 0);
+        for (const Triangle& t : frameTriangles) {
+            auto lo = std::lower_bound(ref.triangles.begin(), ref.triangles.end(), t.r1 - tolerance,
+                                       [](const Triangle& a, float r) { return a.r1 < r; });
+            for (auto it = lo; it != ref.triangles.end() && it->r1 <= t.r1 + tolerance; ++it) {
+                if (std::abs(it->r2 - t.r2) > tolerance) continue;
+                for (int m = 0; m < 3; ++m) {
+                    votes[size_t(it->v[m]) * frameCount + t.v[m]]++;
+                }
+            }
+        }
+
+        // Keep mutually-best correspondences with more than one vote
+        std::vector<std::pair<int, int>> pairs;
+        for (int r = 0; r < refCount; ++r) {
+            int best = -1, bestVotes = 1;
+            for (int f = 0; f < frameCount; ++f) {
+                int v = votes[size_t(r) * frameCount + f];
+                if (v > bestVotes) { bestVotes = v; best = f; }
+            }
+            if (best < 0) continue;
+            bool mutual = true;
+            for (int r2 = 0; r2 < refCount && mutual; ++r2) {
+                if (r2 != r && votes[size_t(r2) * frameCount + best] >= bestVotes) mutual = false;
+            }
+            if (mutual) pairs.push_back({r, best});
+        }
+
+        // Least-squares similarity with iterative outlier rejection
+        for (int iteration = 0; iteration < 5; ++iteration) {
+            if (pairs.size() < 3) return false;
+            FrameTransform t = fitSimilarity(ref.stars, frameStars, pairs);
+
+            std::vector<std::pair<int, int>> kept;
+            double sumSq = 0;
+            for (const auto& p : pairs) {
+                double u, v;
+                t.apply(ref.stars[p.first].x, ref.stars[p.first].y, u, v);
+                double d = std::hypot(u - frameStars[p.second].x, v - frameStars[p.second].y);
+                if (d < maxResidual) {
+                    kept.push_back(p);
+                    sumSq += d * d;
+                }
+            }
+            if (kept.size() == pairs.size()) {
+                t.rms = std::sqrt(sumSq / kept.size());
+                t.matchedStars = kept.size();
+                transform = t;
+                return true;
+            }
+            pairs.swap(kept);
+        }
+        return false;
+    }
+
+private:
+    std::vector<Triangle> buildTriangles(const std::vector<Star>& stars) const {
+        std::vector<Triangle> triangles;
+        int count = std::min<int>(stars.size(), matchStars);
+        for (int i = 0; i < count; ++i) {
+            for (int j = i + 1; j < count; ++j) {
+                for (int k = j + 1; k < count; ++k) {
+                    int idx[3] = {i, j, k};
+                    // side[m] is opposite vertex idx[m]
+                    double side[3];
+                    for (int m = 0; m < 3; ++m) {
+                        const Star& p = stars[idx[(m + 1) % 3]];
+                        const Star& q = stars[idx[(m + 2) % 3]];
+                        side[m] = std::hypot(p.x - q.x, p.y - q.y);
+                    }
+                    int order[3] = {0, 1, 2};
+                    std::sort(order, order + 3, [&](int a, int b) { return side[a] > side[b]; });
+                    double longest = side[order[0]];
+                    if (longest < 10.0) continue;           // too small to be reliable
+
+                    Triangle t;
+                    for (int m = 0; m < 3; ++m) t.v[m] = idx[order[m]];
+                    t.r1 = float(side[order[1]] / longest);
+                    t.r2 = float(side[order[2]] / longest);
+                    if (t.r2 < 0.1f) continue;              // nearly degenerate
+                    triangles.push_back(t);
+                }
+            }
+        }
+        std::sort(triangles.begin(), triangles.end(),
+                  [](const Triangle& a, const Triangle& b) { return a.r1 < b.r1; });
+        return triangles;
+    }
+
+    static FrameTransform fitSimilarity(const std::vector<Star>& refStars,
+                                        const std::vector<Star>& frameStars,
+                                        const std::vector<std::pair<int, int>>& pairs) {
+        double mx = 0, my = 0, mu = 0, mv = 0;
+        for (const auto& p : pairs) {
+            mx += refStars[p.first].x;
+            my += refStars[p.first].y;
+            mu += frameStars[p.second].x;
+            mv += frameStars[p.second].y;
+        }
+        double n = pairs.size();
+        mx /= n; my /= n; mu /= n; mv /= n;
+
+        double sxx = 0, sa = 0, sb = 0;
+        for (const auto& p : pairs) {
+            double x = refStars[p.first].x - mx;
+            double y = refStars[p.first].y - my;
+            double u = frameStars[p.second].x - mu;
+            double v = frameStars[p.second].y - mv;
+            sxx += x * x + y * y;
+            sa += x * u + y * v;
+            sb += x * v - y * u;
+        }
+
+        FrameTransform t;
+        if (sxx > 0) {
+            t.a = sa / sxx;
+            t.b = sb / sxx;
+        }
+        t.tx = mu - t.a * mx + t.b * my;
+        t.ty = mv - t.b * mx - t.a * my;
+        return t;
+    }
+};
+
+#endif // STARMATCHER_H
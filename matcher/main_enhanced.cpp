@@ -4,6 +4,11 @@
 #include "FitsProcessor.h"
 #include "ImageCache.h"
 #include "ImageMatcherDialog.h"
+#include "FrameStacker.h"
+#include "LiveStacker.h"
+#include "FrameQualityScorer.h"
+#include "PhotometricCalibrator.h"
+#include "MemoryBudget.h"
 #include <QApplication>
 #include <QWidget>
 #include <QVBoxLayout>
@@ -24,6 +29,11 @@
 #include <QMenu>
 #include <QMenuBar>
 #include <QMainWindow>
+#include <QFileSystemWatcher>
+#include <QDir>
+#include <QSet>
+#include <QHash>
+#include <QTimer>
 #include <fitsio.h>
 #include <QBuffer>
 #include <cmath>
@@ -31,6 +41,13 @@
 #include <QByteArray>
 #include <vector>
 #include <algorithm>
+#include <memory>
+
+// One live-stack step, produced on the thread pool for the GUI thread
+struct LiveStackUpdate {
+    LiveFrameReport report;
+    QImage preview;
+};
 
 class DSSViewerWindow : public QMainWindow {
     Q_OBJECT
@@ -66,14 +83,24 @@ private:
     MessierObject currentObject;
     QString userFitsPath;
     
-    // For composite image fetching
+    // Composite channels, kept for saving as a 3-plane FITS
     QImage irImage, redImage, blueImage;
-    int compositeFetchCount;
-    bool fetchingComposite;
+    
+    // Live stacking of frames arriving in a watched folder. Frames are fed
+    // to the stacker one at a time, in name order, off the GUI thread.
+    QFileSystemWatcher* liveWatcher = nullptr;
+    std::shared_ptr<LiveStacker> liveStacker;
+    QString liveFolder;
+    QSet<QString> liveSeen;
+    QStringList livePending;
+    QHash<QString, int> liveReadAttempts;
+    bool liveBusy = false;
+    Async::Future<bool> liveLastFrame = Async::makeReady(true);
+    QAction* liveStartAction;
+    QAction* liveStopAction;
 
 public:
-    DSSViewerWindow(QWidget* parent = nullptr) : QMainWindow(parent), 
-        compositeFetchCount(0), fetchingComposite(false) {
+    DSSViewerWindow(QWidget* parent = nullptr) : QMainWindow(parent) {
         setWindowTitle("DSS Image Matcher - Enhanced with WCS & Analysis");
         resize(1400, 900);
         
@@ -100,8 +127,6 @@ public:
     }
 
 private:
-    DSSurvey lastSurveyRequested;
-
     void setupMenuBar() {
         QMenuBar* menuBar = new QMenuBar(this);
         setMenuBar(menuBar);
@@ -113,6 +138,27 @@ private:
         connect(loadFitsAction, &QAction::triggered, this, &DSSViewerWindow::onLoadUserFits);
         fileMenu->addAction(loadFitsAction);
         
+        QAction* stackAction = new QAction("&Stack FITS Frames...", this);
+        connect(stackAction, &QAction::triggered, this, &DSSViewerWindow::onStackFrames);
+        fileMenu->addAction(stackAction);
+        
+        QAction* scoreAction = new QAction("Sc&ore FITS Frames...", this);
+        connect(scoreAction, &QAction::triggered, this, &DSSViewerWindow::onScoreFrames);
+        fileMenu->addAction(scoreAction);
+        
+        QAction* photometryAction = new QAction("Calibrate &Photometry...", this);
+        connect(photometryAction, &QAction::triggered, this, &DSSViewerWindow::onCalibratePhotometry);
+        fileMenu->addAction(photometryAction);
+        
+        liveStartAction = new QAction("Start &Live Stack...", this);
+        connect(liveStartAction, &QAction::triggered, this, &DSSViewerWindow::onStartLiveStack);
+        fileMenu->addAction(liveStartAction);
+        
+        liveStopAction = new QAction("Stop Live Stac&k", this);
+        liveStopAction->setEnabled(false);
+        connect(liveStopAction, &QAction::triggered, this, &DSSViewerWindow::onStopLiveStack);
+        fileMenu->addAction(liveStopAction);
+        
         fileMenu->addSeparator();
         
         QAction* exitAction = new QAction("E&xit", this);
@@ -133,6 +179,12 @@ private:
         QAction* cleanupAction = new QAction("Cleanup &Old Entries...", this);
         connect(cleanupAction, &QAction::triggered, this, &DSSViewerWindow::onCleanupCache);
         cacheMenu->addAction(cleanupAction);
+        
+        cacheMenu->addSeparator();
+        
+        QAction* memoryAction = new QAction("&Memory Usage...", this);
+        connect(memoryAction, &QAction::triggered, this, &DSSViewerWindow::showMemoryUsage);
+        cacheMenu->addAction(memoryAction);
     }
     
     void setupUI() {
@@ -409,22 +461,25 @@ private slots:
             return;
         }
         
-        fetchingComposite = false;
-        
         DSSurvey survey = (DSSurvey)surveyCombo->currentData().toInt();
-	lastSurveyRequested = survey;  // <--- remember
         
         statusLabel->setText(QString("Fetching DSS image for %1...").arg(currentObject.name));
         progressBar->show();
         setControlsEnabled(false);
         
-        matcher->fetchByCoordinates(cache,
-				    currentObject.sky_position.ra_deg,
-                                    currentObject.sky_position.dec_deg,
-                                    widthSpinBox->value(),
-                                    heightSpinBox->value(),
-                                    survey,
-                                    ImageFormat::FITS);
+        matcher->fetchCutout(cache,
+                             currentObject.sky_position.ra_deg,
+                             currentObject.sky_position.dec_deg,
+                             widthSpinBox->value(),
+                             heightSpinBox->value(),
+                             survey,
+                             currentObject.name)
+            .then(this, [this](const QByteArray& fitsData) {
+                onFitsReceived(fitsData);
+            })
+            .onFailed(this, [this](const QString& error) {
+                onError(error);
+            });
     }
     
     void onFetchComposite() {
@@ -433,27 +488,53 @@ private slots:
             return;
         }
         
-        fetchingComposite = true;
-        compositeFetchCount = 0;
         irImage = QImage();
         redImage = QImage();
         blueImage = QImage();
         
-        statusLabel->setText(QString("Fetching composite FITS for %1 (1/3: IR)...").arg(currentObject.name));
+        statusLabel->setText(QString("Fetching composite FITS for %1 (IR, Red, Blue)...").arg(currentObject.name));
         progressBar->show();
         progressBar->setRange(0, 3);
         progressBar->setValue(0);
         setControlsEnabled(false);
         
-        // First leg: IR
-        lastSurveyRequested = DSSurvey::POSS2UKSTU_IR;
-        matcher->fetchByCoordinates(cache,
-				    currentObject.sky_position.ra_deg,
-                                    currentObject.sky_position.dec_deg,
-                                    widthSpinBox->value(),
-                                    heightSpinBox->value(),
-                                    DSSurvey::POSS2UKSTU_IR,
-                                    ImageFormat::FITS);
+        // Fan out the three legs, decode each on the thread pool as it
+        // arrives, then fan in to build the composite
+        const QList<DSSurvey> legs = {DSSurvey::POSS2UKSTU_IR,
+                                      DSSurvey::POSS2UKSTU_RED,
+                                      DSSurvey::POSS2UKSTU_BLUE};
+        QList<Async::Future<DecodedFits>> decodes;
+        for (DSSurvey survey : legs) {
+            decodes << matcher->fetchCutout(cache,
+                                            currentObject.sky_position.ra_deg,
+                                            currentObject.sky_position.dec_deg,
+                                            widthSpinBox->value(),
+                                            heightSpinBox->value(),
+                                            survey,
+                                            currentObject.name)
+                .then(this, [this](const QByteArray& fitsData) {
+                    progressBar->setValue(progressBar->value() + 1);
+                    return FitsProcessor::decodeFits(fitsData);
+                });
+        }
+        
+        Async::whenAll(decodes)
+            .then(this, [this](const QList<DecodedFits>& channels) {
+                irImage = FitsProcessor::toGrayscaleImage(channels[0]);
+                redImage = FitsProcessor::toGrayscaleImage(channels[1]);
+                blueImage = FitsProcessor::toGrayscaleImage(channels[2]);
+                createFalseColorComposite();
+            })
+            .onFailed(this, [this](const QString& error) {
+                statusLabel->setText(QString("Error fetching composite for %1: %2")
+                                    .arg(currentObject.name)
+                                    .arg(error));
+                statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #f8d7da; color: #721c24; }");
+                QMessageBox::critical(this, "Fetch Error", error);
+                progressBar->hide();
+                progressBar->setRange(0, 0);
+                setControlsEnabled(true);
+            });
     }
     
     void onLoadUserFits() {
@@ -470,6 +551,411 @@ private slots:
         }
     }
     
+    // Register and sigma-clip stack several exposures of one field, then use
+    // the stack as the user image for matching against DSS
+    void onStackFrames() {
+        QStringList files = QFileDialog::getOpenFileNames(this,
+                                                          "Select FITS Frames to Stack",
+                                                          "",
+                                                          "FITS Files (*.fits *.fit *.fts);;All Files (*)");
+        if (files.size() < 2) {
+            if (!files.isEmpty()) {
+                QMessageBox::warning(this, "Stack Frames", "Select at least two frames to stack.");
+            }
+            return;
+        }
+        
+        QString outputPath = QFileDialog::getSaveFileName(this,
+                                                          "Save Stacked FITS",
+                                                          "stack.fits",
+                                                          "FITS Files (*.fits);;All Files (*)");
+        if (outputPath.isEmpty()) return;
+        
+        stackFiles(files, outputPath);
+    }
+    
+    void stackFiles(const QStringList& files, const QString& outputPath) {
+        statusLabel->setText(QString("Stacking %1 frames...").arg(files.size()));
+        progressBar->show();
+        progressBar->setRange(0, 0);
+        setControlsEnabled(false);
+        
+        Async::run([files, outputPath]() {
+            FrameStacker stacker;
+            StackResult result = stacker.stack(files);
+            if (result.ok && !FrameStacker::writeFits(outputPath, result)) {
+                result.ok = false;
+                result.error = "Failed to write " + outputPath;
+            }
+            result.data.clear();
+            result.data.shrink_to_fit();
+            return result;
+        }).then(this, [this, files, outputPath](const StackResult& result) {
+            progressBar->hide();
+            setControlsEnabled(true);
+            
+            if (!result.ok) {
+                statusLabel->setText("Stacking failed: " + result.error);
+                statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #f8d7da; color: #721c24; }");
+                QMessageBox::critical(this, "Stack Frames", result.error);
+                return;
+            }
+            
+            userFitsPath = outputPath;
+            statusLabel->setText(QString("Stacked %1 of %2 frames (%3×%4) into %5")
+                                .arg(result.framesUsed)
+                                .arg(files.size())
+                                .arg(result.width)
+                                .arg(result.height)
+                                .arg(QFileInfo(outputPath).fileName()));
+            statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #d4edda; }");
+            matchImagesBtn->setEnabled(!currentImageData.isEmpty());
+            
+            if (!result.rejectedFrames.isEmpty()) {
+                QMessageBox::warning(this, "Stack Frames",
+                    QString("%1 frame(s) could not be registered and were skipped:\n%2")
+                    .arg(result.rejectedFrames.size())
+                    .arg(result.rejectedFrames.join("\n")));
+            }
+            if (!result.failedFrames.isEmpty()) {
+                QMessageBox::warning(this, "Stack Frames",
+                    QString("%1 frame(s) could not be read while combining and were left out:\n%2")
+                    .arg(result.failedFrames.size())
+                    .arg(result.failedFrames.join("\n")));
+            }
+        });
+    }
+    
+    // Measure FWHM, eccentricity, star count, sky and noise for a set of
+    // frames, write one CSV record per frame and offer to stack the keepers
+    void onScoreFrames() {
+        QStringList files = QFileDialog::getOpenFileNames(this,
+                                                          "Select FITS Frames to Score",
+                                                          "",
+                                                          "FITS Files (*.fits *.fit *.fts);;All Files (*)");
+        if (files.isEmpty()) return;
+        
+        QString reportPath = QFileDialog::getSaveFileName(this,
+                                                          "Save Quality Report",
+                                                          "frame_quality.csv",
+                                                          "CSV Files (*.csv);;All Files (*)");
+        if (reportPath.isEmpty()) return;
+        
+        statusLabel->setText(QString("Scoring %1 frames...").arg(files.size()));
+        progressBar->show();
+        progressBar->setRange(0, files.size());
+        progressBar->setValue(0);
+        setControlsEnabled(false);
+        
+        QPointer<QProgressBar> bar(progressBar);
+        Async::run([files, reportPath, bar]() {
+            FrameQualityScorer scorer;
+            std::vector<FrameQuality> records = scorer.score(files,
+                [bar](const FrameQuality&, int done, int) {
+                    QMetaObject::invokeMethod(bar, [bar, done]() {
+                        if (bar) bar->setValue(done);
+                    }, Qt::QueuedConnection);
+                });
+            FrameQualityScorer::rank(records);
+            FrameQualityScorer::writeCsv(reportPath, records);
+            return records;
+        }).then(this, [this, files, reportPath](const std::vector<FrameQuality>& records) {
+            progressBar->hide();
+            setControlsEnabled(true);
+            
+            QStringList accepted;
+            for (const FrameQuality& record : records) {
+                if (!record.rejected) accepted << record.path;
+            }
+            statusLabel->setText(QString("Scored %1 frames: %2 accepted, %3 rejected (report: %4)")
+                                .arg(files.size())
+                                .arg(accepted.size())
+                                .arg(files.size() - accepted.size())
+                                .arg(QFileInfo(reportPath).fileName()));
+            statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #d4edda; }");
+            
+            if (accepted.size() < 2) return;
+            if (QMessageBox::question(this, "Score Frames",
+                    QString("Stack the %1 accepted frames now?").arg(accepted.size()))
+                != QMessageBox::Yes) {
+                return;
+            }
+            QString outputPath = QFileDialog::getSaveFileName(this,
+                                                              "Save Stacked FITS",
+                                                              "stack.fits",
+                                                              "FITS Files (*.fits);;All Files (*)");
+            if (!outputPath.isEmpty()) stackFiles(accepted, outputPath);
+        });
+    }
+    
+    // Zero point and colour term for each frame against Gaia: the PHOTZP
+    // keywords go into each FITS header and a calibrated star list
+    // (<frame>.phot.csv) is written next to it
+    void onCalibratePhotometry() {
+        QStringList files = QFileDialog::getOpenFileNames(this,
+                                                          "Select FITS Frames to Calibrate",
+                                                          "",
+                                                          "FITS Files (*.fits *.fit *.fts);;All Files (*)");
+        if (files.isEmpty()) return;
+        
+        statusLabel->setText(QString("Reading headers of %1 frames...").arg(files.size()));
+        progressBar->show();
+        progressBar->setRange(0, 0);
+        setControlsEnabled(false);
+        
+        // One catalog cone per group of overlapping frames, from the headers,
+        // read on the pool since a network share can take seconds per frame
+        Async::run([files]() {
+            std::vector<int> coneOf;
+            QList<CatalogCone> cones = PhotometricCalibrator::planCones(files, coneOf);
+            return std::make_pair(cones, coneOf);
+        }).then(this, [this, files](const std::pair<QList<CatalogCone>, std::vector<int>>& plan) {
+            if (plan.first.isEmpty()) {
+                progressBar->hide();
+                setControlsEnabled(true);
+                statusLabel->setText("Photometric calibration: no usable WCS");
+                QMessageBox::warning(this, "Calibrate Photometry",
+                                     "None of the selected frames has a usable WCS.");
+                return;
+            }
+            calibrateFrames(files, plan.first, plan.second);
+        });
+    }
+    
+    void calibrateFrames(const QStringList& files, const QList<CatalogCone>& cones,
+                         const std::vector<int>& coneOf) {
+        statusLabel->setText(QString("Fetching reference stars for %1 frames (%2 fields)...")
+                            .arg(files.size()).arg(cones.size()));
+        
+        QList<Async::Future<QByteArray>> fetches;
+        for (const CatalogCone& cone : cones) {
+            fetches << matcher->fetchReferenceCatalog(cache, cone.ra, cone.dec, cone.radiusArcmin * 1.2);
+        }
+        
+        QPointer<QProgressBar> bar(progressBar);
+        Async::whenAll(fetches)
+            .then(this, [this, files, coneOf, bar](const QList<QByteArray>& tables) {
+                statusLabel->setText(QString("Calibrating %1 frames...").arg(files.size()));
+                progressBar->setRange(0, files.size());
+                progressBar->setValue(0);
+                
+                return Async::run([files, coneOf, tables, bar]() {
+                    std::vector<CatalogIndex> catalogs;
+                    catalogs.reserve(size_t(tables.size()));
+                    for (const QByteArray& table : tables) {
+                        catalogs.emplace_back(PhotometricCalibrator::parseCatalog(table));
+                    }
+                    std::vector<PhotometricSolution> solutions(files.size());
+                    std::atomic<int> done{0};
+                    
+                    Parallel::forEach(files.size(), Parallel::threadCount(0), [&](int i) {
+                        std::vector<float> data;
+                        int width, height;
+                        WCSInfo wcs;
+                        FitsProcessor reader;
+                        if (coneOf[size_t(i)] < 0) {
+                            solutions[i].error = "no usable WCS";
+                        } else if (!reader.loadFits(files[i], data, width, height, wcs)) {
+                            solutions[i].error = "unreadable";
+                        } else {
+                            MemoryCharge frameCharge(MemoryStage::FitsDecode, data.size() * sizeof(float));
+                            PhotometricCalibrator calibrator(catalogs[size_t(coneOf[size_t(i)])]);
+                            std::vector<PhotometricStar> stars;
+                            solutions[i] = calibrator.calibrate(data.data(), width, height, wcs, &stars);
+                            if (solutions[i].ok) {
+                                PhotometricCalibrator::annotateFits(files[i], solutions[i], "Gaia DR3 G");
+                                PhotometricCalibrator::writeStarsCsv(files[i] + ".phot.csv", stars);
+                            }
+                        }
+                        int finished = ++done;
+                        QMetaObject::invokeMethod(bar, [bar, finished]() {
+                            if (bar) bar->setValue(finished);
+                        }, Qt::QueuedConnection);
+                    });
+                    return solutions;
+                });
+            })
+            .then(this, [this, files](const std::vector<PhotometricSolution>& solutions) {
+                progressBar->hide();
+                setControlsEnabled(true);
+                
+                QStringList lines, failed;
+                for (size_t i = 0; i < solutions.size(); ++i) {
+                    const PhotometricSolution& s = solutions[i];
+                    QString name = QFileInfo(files[i]).fileName();
+                    if (!s.ok) {
+                        failed << QString("%1: %2").arg(name).arg(s.error);
+                        continue;
+                    }
+                    lines << QString("%1: ZP %2 ± %3, CT %4, rms %5, %6 stars")
+                             .arg(name)
+                             .arg(s.zeroPoint, 0, 'f', 3)
+                             .arg(s.zeroPointError, 0, 'f', 3)
+                             .arg(s.hasColorTerm ? QString::number(s.colorTerm, 'f', 3) : QString("—"))
+                             .arg(s.rms, 0, 'f', 3)
+                             .arg(s.used);
+                }
+                statusLabel->setText(QString("Calibrated %1 of %2 frames")
+                                    .arg(lines.size()).arg(files.size()));
+                statusLabel->setStyleSheet(failed.isEmpty()
+                    ? "QLabel { padding: 5px; background-color: #d4edda; }"
+                    : "QLabel { padding: 5px; background-color: #fff3cd; }");
+                
+                QMessageBox box(this);
+                box.setWindowTitle("Calibrate Photometry");
+                box.setText(QString("Calibrated %1 of %2 frames against Gaia DR3.")
+                            .arg(lines.size()).arg(files.size()));
+                box.setDetailedText((lines + failed).join("\n"));
+                box.exec();
+            })
+            .onFailed(this, [this](const QString& error) {
+                progressBar->hide();
+                setControlsEnabled(true);
+                statusLabel->setText("Photometric calibration failed: " + error);
+                statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #f8d7da; color: #721c24; }");
+            });
+    }
+    
+    // Watch a folder and stack every FITS frame that lands in it, showing
+    // the running stack after each one
+    void onStartLiveStack() {
+        QString folder = QFileDialog::getExistingDirectory(this, "Select Folder Receiving Frames");
+        if (folder.isEmpty()) return;
+        
+        liveFolder = folder;
+        liveStacker = std::make_shared<LiveStacker>();
+        liveSeen.clear();
+        livePending.clear();
+        liveReadAttempts.clear();
+        
+        liveWatcher = new QFileSystemWatcher(QStringList() << folder, this);
+        connect(liveWatcher, &QFileSystemWatcher::directoryChanged,
+                this, &DSSViewerWindow::onLiveFolderChanged);
+        liveStartAction->setEnabled(false);
+        liveStopAction->setEnabled(true);
+        
+        statusLabel->setText("Live stacking: waiting for frames in " + folder);
+        statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #f0f0f0; }");
+        
+        // Frames already present are stacked first
+        onLiveFolderChanged(folder);
+    }
+    
+    void onLiveFolderChanged(const QString& folder) {
+        QStringList names = QDir(folder).entryList(QStringList() << "*.fits" << "*.fit" << "*.fts",
+                                                   QDir::Files, QDir::Name);
+        for (const QString& name : names) {
+            QString path = QDir(folder).filePath(name);
+            if (liveSeen.contains(path)) continue;
+            liveSeen.insert(path);
+            livePending << path;
+        }
+        processNextLiveFrame();
+    }
+    
+    void processNextLiveFrame() {
+        if (liveBusy || livePending.isEmpty() || !liveStacker) return;
+        
+        liveBusy = true;
+        QString path = livePending.takeFirst();
+        std::shared_ptr<LiveStacker> stacker = liveStacker;
+        int previewSize = std::max(imageLabel->width(), imageLabel->height());
+        
+        liveLastFrame = Async::run([stacker, path, previewSize]() {
+            LiveStackUpdate update;
+            update.report = stacker->addFile(path);
+            if (update.report.accepted) update.preview = stacker->renderPreview(previewSize);
+            return update;
+        }).then(this, [this, stacker, path](const LiveStackUpdate& update) {
+            liveBusy = false;
+            if (stacker != liveStacker) {    // session stopped or restarted meanwhile
+                processNextLiveFrame();
+                return;
+            }
+            
+            const LiveFrameReport& report = update.report;
+            QString name = QFileInfo(path).fileName();
+            if (report.accepted) {
+                imageLabel->setPixmap(QPixmap::fromImage(update.preview).scaled(imageLabel->size(),
+                                                                                 Qt::KeepAspectRatio,
+                                                                                 Qt::SmoothTransformation));
+                statusLabel->setText(QString("Live stack: %1 frames, added %2 (%3 stars, rms %4 px, %5 ms)")
+                                    .arg(report.framesStacked)
+                                    .arg(name)
+                                    .arg(report.transform.matchedStars)
+                                    .arg(report.transform.rms, 0, 'f', 2)
+                                    .arg(report.totalMs, 0, 'f', 0));
+                statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #d4edda; }");
+            } else if (report.reason.startsWith("Failed to read") &&
+                       ++liveReadAttempts[path] < 3) {
+                // Probably still being written; try again shortly
+                QTimer::singleShot(1000, this, [this, stacker, path]() {
+                    if (stacker != liveStacker) return;
+                    livePending.prepend(path);
+                    processNextLiveFrame();
+                });
+            } else {
+                statusLabel->setText(QString("Live stack: %1 frames, skipped %2: %3")
+                                    .arg(report.framesStacked)
+                                    .arg(name)
+                                    .arg(report.reason));
+                statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #fff3cd; }");
+            }
+            processNextLiveFrame();
+        });
+    }
+    
+    // Stop watching and optionally save the stack as the user FITS image
+    void onStopLiveStack() {
+        delete liveWatcher;
+        liveWatcher = nullptr;
+        liveStartAction->setEnabled(true);
+        liveStopAction->setEnabled(false);
+        
+        std::shared_ptr<LiveStacker> stacker = liveStacker;
+        liveStacker.reset();
+        livePending.clear();
+        if (!stacker || stacker->frameCount() == 0) {
+            statusLabel->setText("Live stacking stopped");
+            return;
+        }
+        
+        QString outputPath = QFileDialog::getSaveFileName(this,
+                                                          "Save Live Stack",
+                                                          QDir(liveFolder).filePath("live_stack.fits"),
+                                                          "FITS Files (*.fits);;All Files (*)");
+        if (outputPath.isEmpty()) {
+            statusLabel->setText(QString("Live stacking stopped after %1 frames").arg(stacker->frameCount()));
+            return;
+        }
+        
+        // A frame may still be in flight on the pool; save once it is done
+        liveLastFrame.then(this, [stacker, outputPath](bool) {
+            return Async::run([stacker, outputPath]() {
+                StackResult result;
+                std::vector<float> image = stacker->stackedImage();
+                result.data.assign(image.begin(), image.end());
+                result.width = stacker->stackWidth();
+                result.height = stacker->stackHeight();
+                result.wcs = stacker->referenceWcs();
+                result.framesUsed = stacker->frameCount();
+                result.ok = true;
+                return FrameStacker::writeFits(outputPath, result, StackMethod::Mean);
+            });
+        }).then(this, [this, stacker, outputPath](bool saved) {
+            if (!saved) {
+                QMessageBox::critical(this, "Live Stack", "Failed to write " + outputPath);
+                return;
+            }
+            userFitsPath = outputPath;
+            statusLabel->setText(QString("Live stack of %1 frames saved to %2")
+                                .arg(stacker->frameCount())
+                                .arg(QFileInfo(outputPath).fileName()));
+            statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #d4edda; }");
+            matchImagesBtn->setEnabled(!currentImageData.isEmpty());
+        });
+    }
+    
     void onMatchImages() {
         if (userFitsPath.isEmpty()) {
             QMessageBox::warning(this, "No User FITS", "Please load a FITS file first!");
@@ -482,8 +968,28 @@ private slots:
             return;
         }
         
+        // Reference stars let the dialog compare calibrated brightness; the
+        // comparison is simply left out if the catalog can't be had
+        double ra, dec, radiusArcmin;
+        if (!PhotometricCalibrator::fieldOfView(userFitsPath, ra, dec, radiusArcmin)) {
+            openMatcherDialog(nullptr);
+            return;
+        }
+        statusLabel->setText("Fetching reference stars...");
+        matcher->fetchReferenceCatalog(cache, ra, dec, radiusArcmin * 1.2)
+            .then(this, [this](const QByteArray& table) {
+                openMatcherDialog(std::make_shared<const CatalogIndex>(
+                    PhotometricCalibrator::parseCatalog(table)));
+            })
+            .onFailed(this, [this](const QString& error) {
+                qDebug() << "Reference catalog unavailable:" << error;
+                openMatcherDialog(nullptr);
+            });
+    }
+    
+    void openMatcherDialog(std::shared_ptr<const CatalogIndex> catalog) {
         ImageMatcherDialog* dialog = new ImageMatcherDialog(
-            userFitsPath, currentImageData, this);
+            userFitsPath, currentImageData, this, std::move(catalog));
         dialog->exec();
     }
     
@@ -499,9 +1005,45 @@ private slots:
             .arg(stats.totalSize / (1024.0 * 1024.0), 0, 'f', 2)
             .arg(cache->getCacheDirectory());
         
+        info += "\n\nCache tiers (fastest first):";
+        for (const TieredCache::TierStats& tier : cache->tierStats()) {
+            QString usage = tier.entries < 0 ? QString("not indexed")
+                : QString("%1 files, %2 MB").arg(tier.entries).arg(tier.bytes / (1024.0 * 1024.0), 0, 'f', 1);
+            QString capacity = tier.capacity > 0
+                ? QString("%1 MB").arg(tier.capacity / (1024.0 * 1024.0), 0, 'f', 0) : QString("unbounded");
+            info += QString("\n  %1: %2 of %3, %4 hits")
+                    .arg(tier.label).arg(usage).arg(capacity).arg(tier.hits);
+        }
+        info += QString("\nFile I/O backend: %1").arg(BatchIO::backend());
+        
+        QString surveyKey = cache->surveyKey((DSSurvey)surveyCombo->currentData().toInt());
+        Moc covered = cache->surveyCoverage(surveyKey);
+        info += QString("\n\nSky covered for %1: %2 deg²")
+                .arg(surveyCombo->currentText())
+                .arg(covered.areaSqDeg(), 0, 'f', 3);
+        if (!currentObject.name.isEmpty()) {
+            // Cutouts are looked up by their exact field, not by coverage
+            bool local = cache->isCached(currentObject.sky_position.ra_deg,
+                                         currentObject.sky_position.dec_deg,
+                                         widthSpinBox->value(), heightSpinBox->value(),
+                                         surveyKey, "fits");
+            info += QString("\n%1 field available offline: %2")
+                    .arg(currentObject.name).arg(local ? "yes" : "no");
+        }
+        
         QMessageBox::information(this, "Cache Information", info);
     }
     
+    void showMemoryUsage() {
+        MemoryAccounting::instance().printReport();
+        
+        QMessageBox box(this);
+        box.setWindowTitle("Memory Usage");
+        box.setText("Per-stage memory accounting (current / peak):");
+        box.setDetailedText(MemoryAccounting::instance().reportLines().join("\n"));
+        box.exec();
+    }
+    
     void onClearCache() {
         auto reply = QMessageBox::question(this, "Clear Cache",
                                           "Are you sure you want to clear all cached images?",
@@ -520,38 +1062,6 @@ private slots:
                                 "Old cache entries (>30 days) have been removed.");
     }
     
-    void continueCompositeFetch() {
-        compositeFetchCount++;
-        progressBar->setValue(compositeFetchCount);
-        
-        if (compositeFetchCount == 1) {
-            // Fetch Red next - always FITS
-	    lastSurveyRequested = DSSurvey::POSS2UKSTU_RED;
-            statusLabel->setText(QString("Fetching composite FITS for %1 (2/3: Red)...").arg(currentObject.name));
-            matcher->fetchByCoordinates(cache,
-					currentObject.sky_position.ra_deg,
-                                        currentObject.sky_position.dec_deg,
-                                        widthSpinBox->value(),
-                                        heightSpinBox->value(),
-                                        DSSurvey::POSS2UKSTU_RED,
-                                        ImageFormat::FITS);
-        } else if (compositeFetchCount == 2) {
-            // Fetch Blue last - always FITS
-	    lastSurveyRequested = DSSurvey::POSS2UKSTU_BLUE;
-            statusLabel->setText(QString("Fetching composite FITS for %1 (3/3: Blue)...").arg(currentObject.name));
-            matcher->fetchByCoordinates(cache,
-					currentObject.sky_position.ra_deg,
-                                        currentObject.sky_position.dec_deg,
-                                        widthSpinBox->value(),
-                                        heightSpinBox->value(),
-                                        DSSurvey::POSS2UKSTU_BLUE,
-                                        ImageFormat::FITS);
-        } else if (compositeFetchCount == 3) {
-            // All images fetched, create composite
-            createFalseColorComposite();
-        }
-    }
-    
     void createFalseColorComposite() {
         statusLabel->setText(QString("Creating false color composite for %1...").arg(currentObject.name));
         
@@ -560,7 +1070,6 @@ private slots:
             QMessageBox::critical(this, "Error", "Failed to fetch all required images for composite!");
             progressBar->hide();
             setControlsEnabled(true);
-            fetchingComposite = false;
             return;
         }
         
@@ -631,7 +1140,6 @@ private slots:
         progressBar->setRange(0, 0);
         setControlsEnabled(true);
         saveImageBtn->setEnabled(true);
-        fetchingComposite = false;
     }
     
     void onImageReceived(const QImage& image, const QByteArray& rawData) {
@@ -645,22 +1153,6 @@ private slots:
 	    "gif",
 	    currentObject.name
 	);
-        if (fetchingComposite) {
-            // Store image based on fetch count
-            if (compositeFetchCount == 0) {
-                irImage = image;
-            } else if (compositeFetchCount == 1) {
-                redImage = image;
-            } else if (compositeFetchCount == 2) {
-                blueImage = image;
-            }
-            
-            // Continue to next image or create composite
-            continueCompositeFetch();
-            return;
-        }
-        
-        // Normal single image fetch
         currentImage = image;
         currentImageData = rawData;
         
@@ -682,48 +1174,7 @@ private slots:
     }
   
     void onFitsReceived(const QByteArray& fitsData) {
-	// 1. Cache every FITS we download, regardless of composite/single.
-	//    This uses a canonical survey key derived from lastSurveyRequested.
-	if (!fitsData.isEmpty()) {
-	    QString surveyStr = cache->surveyKey(lastSurveyRequested);
-
-	    cache->cacheImage(
-		fitsData,
-		currentObject.sky_position.ra_deg,
-		currentObject.sky_position.dec_deg,
-		widthSpinBox->value(),
-		heightSpinBox->value(),
-		surveyStr,
-		"fits",                // no special "fits_composite" distinction
-		currentObject.name
-	    );
-	}
-
-	// 2. Composite path short-circuit stays as before, but now we've cached.
-	if (fetchingComposite) {
-	    QImage img = parseFitsToImage(fitsData);
-
-	    if (img.isNull()) {
-		onError("Failed to parse FITS data for composite");
-		return;
-	    }
-
-	    // Store image based on fetch count
-	    if (compositeFetchCount == 0) {
-		irImage = img;
-	    } else if (compositeFetchCount == 1) {
-		redImage = img;
-	    } else if (compositeFetchCount == 2) {
-		blueImage = img;
-	    }
-
-	    // Continue to next image or create composite
-	    continueCompositeFetch();
-	    return;
-	}
-
-	// 3. Normal single-image display path (unchanged, except that
-	//    currentImageData is now the raw FITS we just cached).
+	// Cutouts are cached by DSSImageMatcher::fetchCutout
 	currentImageData = fitsData;
 	currentImage = parseFitsToImage(fitsData);
 
@@ -817,6 +1268,7 @@ private slots:
 	// --- Read pixel data into a float buffer ---
 	const long npixels = width * height;
 	std::vector<float> buffer(npixels);
+	MemoryCharge decodeCharge(MemoryStage::FitsDecode, npixels * sizeof(float) + memsize);
 
 	long fpixel[3] = {1, 1, 1};
 	if (fits_read_pix(fptr, TFLOAT, fpixel, npixels, NULL, buffer.data(), NULL, &status))
@@ -859,16 +1311,9 @@ private slots:
     }
   
     void onError(const QString& error) {
-        if (fetchingComposite) {
-            statusLabel->setText(QString("Error fetching composite for %1: %2")
-                                .arg(currentObject.name)
-                                .arg(error));
-            fetchingComposite = false;
-        } else {
-            statusLabel->setText(QString("Error fetching %1: %2")
-                                .arg(currentObject.name)
-                                .arg(error));
-        }
+        statusLabel->setText(QString("Error fetching %1: %2")
+                            .arg(currentObject.name)
+                            .arg(error));
         
         statusLabel->setStyleSheet("QLabel { padding: 5px; background-color: #f8d7da; color: #721c24; }");
         
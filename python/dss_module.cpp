@@ -0,0 +1,310 @@
+// dss_module.cpp - Python bindings for the mosaic renderer, render cache,
+// FITS loader, frame statistics and star detector
+//
+//   import dss
+//   data, wcs = dss.load_fits("frame.fits")     # float32 (h, w), no copy
+//   median, sigma = dss.background(data)
+//   stars = dss.detect_stars(data)              # float64 (n, 3): x, y, flux
+//   rgb = dss.render_mosaic(83.82, -5.39, "M42") # uint8 (h, w, 3) view
+//
+// Results are NumPy arrays over the C++ buffers themselves: each array
+// owns its std::vector/QImage through a capsule, so nothing is copied on
+// the way out. Inputs that are already C-contiguous float32 are read in
+// place. The GIL is released while decoding, detecting and rendering.
+// Qt objects are driven from the calling thread, so call the renderer
+// from one Python thread only.
+
+// Python headers first: Qt's `slots` macro breaks them otherwise
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <QGuiApplication>
+#include <memory>
+#include "EnhancedMosaicCreator.h"
+#include "RenderCache.h"
+#include "FitsProcessor.h"
+#include "StarMatcher.h"
+#include "FrameQualityScorer.h"
+
+namespace py = pybind11;
+
+namespace {
+
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+// The renderer needs a Qt application (fonts, network, event loop);
+// scripts get an offscreen one on first use that lives for the process
+void ensureApplication() {
+    if (QCoreApplication::instance()) return;
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    static int argc = 1;
+    static char name[] = "dss";
+    static char* argv[] = {name, nullptr};
+    new QGuiApplication(argc, argv);
+}
+
+EnhancedMosaicCreator& mosaicCreator() {
+    ensureApplication();
+    static EnhancedMosaicCreator* creator = new EnhancedMosaicCreator();
+    return *creator;
+}
+
+// Hand a vector to NumPy: the array keeps it alive, no copy is made
+template <typename T>
+py::array_t<T> adopt(std::vector<T>&& values, std::vector<py::ssize_t> shape) {
+    auto* owner = new std::vector<T>(std::move(values));
+    py::capsule release(owner, [](void* p) { delete static_cast<std::vector<T>*>(p); });
+    return py::array_t<T>(shape, owner->data(), release);
+}
+
+// Read-only view over a QImage's pixels. The image may still be shared
+// (e.g. with a finished future), so writing would force a detach.
+py::array imageArray(QImage image) {
+    if (image.isNull()) return py::array_t<uint8_t>(std::vector<py::ssize_t>{0, 0, 3});
+
+    bool rgb32 = image.format() == QImage::Format_RGB32 ||
+                 image.format() == QImage::Format_ARGB32;
+    if (image.format() != QImage::Format_Grayscale8 &&
+        image.format() != QImage::Format_RGB888 &&
+        !(rgb32 && Q_BYTE_ORDER == Q_LITTLE_ENDIAN)) {
+        image = image.convertToFormat(QImage::Format_RGB888);
+        rgb32 = false;
+    }
+
+    auto* owner = new QImage(std::move(image));
+    py::capsule release(owner, [](void* p) { delete static_cast<QImage*>(p); });
+    const uint8_t* bits = owner->constBits();
+    const py::ssize_t h = owner->height(), w = owner->width(), bpl = owner->bytesPerLine();
+
+    py::array result;
+    if (owner->format() == QImage::Format_Grayscale8) {
+        result = py::array_t<uint8_t>({h, w}, {bpl, py::ssize_t(1)}, bits, release);
+    } else if (rgb32) {
+        // 0xffRRGGBB is stored B, G, R, A: view it as RGB with a negative
+        // channel stride starting at the red byte
+        result = py::array_t<uint8_t>({h, w, py::ssize_t(3)}, {bpl, py::ssize_t(4), py::ssize_t(-1)},
+                                      bits + 2, release);
+    } else {
+        result = py::array_t<uint8_t>({h, w, py::ssize_t(3)}, {bpl, py::ssize_t(3), py::ssize_t(1)},
+                                      bits, release);
+    }
+    result.attr("setflags")(py::arg("write") = false);
+    return result;
+}
+
+py::dict wcsDict(const WCSInfo& wcs) {
+    py::dict d;
+    d["valid"] = wcs.isValid;
+    d["crval1"] = wcs.crval1;
+    d["crval2"] = wcs.crval2;
+    d["crpix1"] = wcs.crpix1;
+    d["crpix2"] = wcs.crpix2;
+    d["cdelt1"] = wcs.cdelt1;
+    d["cdelt2"] = wcs.cdelt2;
+    d["crota2"] = wcs.crota2;
+    d["ctype1"] = wcs.ctype1.toStdString();
+    d["ctype2"] = wcs.ctype2.toStdString();
+    d["equinox"] = wcs.equinox;
+    return d;
+}
+
+py::dict qualityDict(const FrameQuality& q) {
+    py::dict d;
+    d["path"] = q.path.toStdString();
+    d["ok"] = q.ok;
+    d["width"] = q.width;
+    d["height"] = q.height;
+    d["background"] = q.background;
+    d["gradient"] = q.gradient;
+    d["noise"] = q.noise;
+    d["stars"] = q.stars;
+    d["fwhm"] = q.fwhm;
+    d["eccentricity"] = q.eccentricity;
+    d["score"] = q.score;
+    d["rejected"] = q.rejected;
+    d["reason"] = q.reason.toStdString();
+    return d;
+}
+
+void requireImage(const FloatArray& data) {
+    if (data.ndim() != 2) throw py::value_error("expected a 2-D image array");
+}
+
+SkyPosition skyPosition(double ra, double dec, const std::string& name) {
+    SkyPosition target;
+    target.ra_deg = ra;
+    target.dec_deg = dec;
+    target.name = QString::fromStdString(name);
+    return target;
+}
+
+} // namespace
+
+PYBIND11_MODULE(dss, m) {
+    m.doc() = "DSS survey pipeline: mosaics, render cache, FITS, statistics and stars";
+
+    // FITS
+    m.def("load_fits", [](const std::string& path) {
+        std::vector<float> data;
+        int width = 0, height = 0;
+        WCSInfo wcs;
+        bool ok;
+        {
+            py::gil_scoped_release release;
+            FitsProcessor reader;
+            ok = reader.loadFits(QString::fromStdString(path), data, width, height, wcs);
+        }
+        if (!ok) throw std::runtime_error("Failed to read FITS image: " + path);
+        return py::make_tuple(adopt(std::move(data), {height, width}), wcsDict(wcs));
+    }, py::arg("path"), "Pixels as float32 (height, width) and the WCS as a dict");
+
+    m.def("decode_fits", [](py::bytes bytes) {
+        std::string_view view(bytes);
+        QByteArray fitsData(view.data(), int(view.size()));
+        DecodedFits decoded;
+        {
+            py::gil_scoped_release release;
+            decoded = FitsProcessor::decodeFitsData(fitsData);
+        }
+        if (!decoded.ok) throw std::runtime_error("Failed to decode FITS data");
+        return py::make_tuple(adopt(std::move(decoded.data), {decoded.height, decoded.width}),
+                              wcsDict(decoded.wcs));
+    }, py::arg("data"), "Like load_fits, from FITS bytes (e.g. a DSS cutout)");
+
+    // Statistics and detection
+    m.def("background", [](FloatArray data, size_t step) {
+        float median = 0, sigma = 0;
+        bool ok;
+        {
+            py::gil_scoped_release release;
+            ok = StarMatcher::estimateBackground(data.data(), data.size(), median, sigma,
+                                                 std::max<size_t>(1, step));
+        }
+        if (!ok) throw py::value_error("no finite pixels");
+        return py::make_tuple(median, sigma);
+    }, py::arg("data"), py::arg("step") = 16, "Sky median and robust sigma (MAD)");
+
+    m.def("detect_stars", [](FloatArray data, double thresholdSigma, int maxStars) {
+        requireImage(data);
+        const int height = data.shape(0), width = data.shape(1);
+        std::vector<StarMatcher::Star> stars;
+        {
+            py::gil_scoped_release release;
+            float background = 0, sigma = 0;
+            if (StarMatcher::estimateBackground(data.data(), data.size(), background, sigma)) {
+                StarMatcher detector;
+                detector.maxStars = maxStars;
+                stars = detector.detectStars(data.data(), width, height, background,
+                                             background + float(thresholdSigma) * sigma);
+            }
+        }
+        static_assert(sizeof(StarMatcher::Star) == 3 * sizeof(double), "Star must be x, y, flux");
+        auto* owner = new std::vector<StarMatcher::Star>(std::move(stars));
+        py::capsule release(owner, [](void* p) { delete static_cast<std::vector<StarMatcher::Star>*>(p); });
+        return py::array_t<double>({py::ssize_t(owner->size()), py::ssize_t(3)},
+                                   {py::ssize_t(sizeof(StarMatcher::Star)), py::ssize_t(sizeof(double))},
+                                   reinterpret_cast<const double*>(owner->data()), release);
+    }, py::arg("data"), py::arg("threshold_sigma") = 5.0, py::arg("max_stars") = 1000,
+       "Stars as float64 (n, 3): x, y, flux, brightest first");
+
+    m.def("frame_quality", [](FloatArray data) {
+        requireImage(data);
+        const int height = data.shape(0), width = data.shape(1);
+        FrameQuality record;
+        {
+            py::gil_scoped_release release;
+            // scoreData repairs defects in place, so it needs its own copy
+            std::vector<float> pixels(data.data(), data.data() + data.size());
+            record = FrameQualityScorer().scoreData(std::move(pixels), width, height);
+        }
+        return qualityDict(record);
+    }, py::arg("data"), "Background, gradient, noise, stars, FWHM and eccentricity");
+
+    m.def("score_frames", [](const std::vector<std::string>& paths, int threads) {
+        QStringList files;
+        for (const std::string& path : paths) files << QString::fromStdString(path);
+        QualityOptions options;
+        options.threads = threads;
+        std::vector<FrameQuality> records;
+        {
+            py::gil_scoped_release release;
+            records = FrameQualityScorer(options).score(files);
+            FrameQualityScorer::rank(records, options);
+        }
+        py::list result;
+        for (const FrameQuality& record : records) result.append(qualityDict(record));
+        return result;
+    }, py::arg("paths"), py::arg("threads") = 0, "Per-frame quality, scored and ranked against the set");
+
+    // Mosaic renderer
+    m.def("render_mosaic", [](double ra, double dec, const std::string& name) {
+        EnhancedMosaicCreator& creator = mosaicCreator();
+        Async::Future<QImage> future = creator.renderMosaic(skyPosition(ra, dec, name));
+        QImage mosaic;
+        {
+            py::gil_scoped_release release;
+            mosaic = future.waitForResult();
+        }
+        if (future.isFailed()) throw std::runtime_error(future.errorString().toStdString());
+        return imageArray(mosaic);
+    }, py::arg("ra"), py::arg("dec"), py::arg("name") = "target",
+       "Centred DSS colour mosaic as uint8 (h, w, 3); served from the render cache when unchanged");
+
+    m.def("mosaic_key", [](double ra, double dec, const std::string& name) {
+        return mosaicCreator().mosaicKey(skyPosition(ra, dec, name));
+    }, py::arg("ra"), py::arg("dec"), py::arg("name") = "target");
+
+    m.def("can_render_locally", [](double ra, double dec) {
+        return mosaicCreator().canRenderLocally(skyPosition(ra, dec, "target"));
+    }, py::arg("ra"), py::arg("dec"), "True when every tile the mosaic needs is on disk");
+
+    // Render cache
+    py::class_<RenderKey>(m, "RenderKey")
+        .def(py::init([](const std::string& output) { return RenderKey(QString::fromStdString(output)); }),
+             py::arg("output") = "")
+        .def("add", [](RenderKey& key, const std::string& name, const std::string& value) -> RenderKey& {
+            return key.add(QString::fromStdString(name), QString::fromStdString(value));
+        }, py::return_value_policy::reference_internal)
+        .def("add", [](RenderKey& key, const std::string& name, qint64 value) -> RenderKey& {
+            return key.add(QString::fromStdString(name), value);
+        }, py::return_value_policy::reference_internal)
+        .def("add", [](RenderKey& key, const std::string& name, double value) -> RenderKey& {
+            return key.add(QString::fromStdString(name), value);
+        }, py::return_value_policy::reference_internal)
+        .def("add_file", [](RenderKey& key, const std::string& name, const std::string& path) -> RenderKey& {
+            return key.addFile(QString::fromStdString(name), QString::fromStdString(path));
+        }, py::return_value_policy::reference_internal)
+        .def_property_readonly("valid", &RenderKey::isValid)
+        .def_property_readonly("hash", [](const RenderKey& key) { return key.hash().toStdString(); })
+        .def("__str__", [](const RenderKey& key) { return key.canonical().toStdString(); });
+
+    py::class_<RenderCache>(m, "RenderCache")
+        .def(py::init([](const std::string& directory, qint64 maxBytes) {
+            return std::make_unique<RenderCache>(QString::fromStdString(directory), maxBytes);
+        }), py::arg("directory"), py::arg("max_bytes") = 1024LL * 1024 * 1024)
+        .def("lookup", [](RenderCache& cache, const RenderKey& key) -> py::object {
+            QString path = cache.lookup(key);
+            if (path.isEmpty()) return py::none();
+            return py::str(path.toStdString());
+        }, "Path of the cached output, or None")
+        .def("lookup_image", [](RenderCache& cache, const RenderKey& key) -> py::object {
+            QImage image;
+            {
+                py::gil_scoped_release release;
+                image = cache.lookupImage(key);
+            }
+            if (image.isNull()) return py::none();
+            return imageArray(image);
+        })
+        .def("store", [](RenderCache& cache, const RenderKey& key, py::bytes data) {
+            std::string_view view(data);
+            return cache.store(key, QByteArray(view.data(), int(view.size())));
+        })
+        .def("store_file", [](RenderCache& cache, const RenderKey& key, const std::string& path) {
+            py::gil_scoped_release release;
+            return cache.storeFile(key, QString::fromStdString(path));
+        });
+}
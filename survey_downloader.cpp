@@ -6,8 +6,17 @@
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
+#include <QBuffer>
+#include <memory>
+#include <vector>
 #include "ProperHipsClient.h"
 #include "EnhancedMosaicCreator.h"
+#include "BufferPool.h"
+#include "MemoryBudget.h"
+#include "Pipeline.h"
+#include "DeepZoom.h"
+#include "RenderCache.h"
+#include "matcher/SphericalGeometry.h"
 
 class SurveyDownloader : public QObject {
     Q_OBJECT
@@ -21,43 +30,32 @@ public:
         QString homeDir = QDir::homePath();
         m_outputDir = QDir(homeDir).absoluteFilePath("plate_solver_test_images");
         QDir().mkpath(m_outputDir);
+        m_renderCache = std::make_unique<RenderCache>(m_outputDir + "/render_cache");
         
         qDebug() << "Survey Downloader initialized";
         qDebug() << "Output directory:" << m_outputDir;
-        
-        connect(m_mosaicCreator, &EnhancedMosaicCreator::mosaicComplete,
-                this, &SurveyDownloader::onImageReady);
     }
     
+    // Also write each frame as a Deep Zoom pyramid (<name>.dzi + <name>_files)
+    void setDeepZoomExport(bool enabled) { m_deepZoom = enabled; }
+    
     // Download image for specific coordinates
     void downloadForCoordinates(double ra_deg, double dec_deg, 
                                const QString& name = "test_image") {
         qDebug() << QString("\n=== Downloading image for %1 ===").arg(name);
-        qDebug() << QString("Coordinates: RA=%1°, Dec=%2°").arg(ra_deg).arg(dec_deg);
+        qDebug() << QString("Coordinates: RA=%1°, Dec=%2° (%3 %4)")
+                    .arg(ra_deg).arg(dec_deg)
+                    .arg(degToHMS(ra_deg)).arg(degToDMS(dec_deg));
         
-        m_currentName = name;
-        m_currentRA = ra_deg;
-        m_currentDec = dec_deg;
+        m_testQueue.clear();
         
-        // Create sky position
-        SkyPosition pos;
+        TestPosition pos;
         pos.ra_deg = ra_deg;
         pos.dec_deg = dec_deg;
         pos.name = name;
-        pos.description = QString("Test image for plate solver at RA=%1°, Dec=%2°")
-                         .arg(ra_deg).arg(dec_deg);
-        
-        // Convert to HMS/DMS for the mosaic creator
-        QString raText = degToHMS(ra_deg);
-        QString decText = degToDMS(dec_deg);
-        
-        qDebug() << "Converted coordinates:";
-        qDebug() << "  RA (HMS):" << raText;
-        qDebug() << "  Dec (DMS):" << decText;
+        m_testQueue.append(pos);
         
-        // Use mosaic creator to fetch the image
-        m_mosaicCreator->setCustomCoordinates(raText, decText, name);
-        m_mosaicCreator->createCustomMosaic(pos);
+        startBatch();
     }
     
     // Download images for a test field grid
@@ -69,37 +67,37 @@ public:
         
         m_testQueue.clear();
         
+        // Grid offsets are tangent-plane (gnomonic) coordinates around the
+        // center, so spacing stays even at high Dec and across RA 0/360
+        const int count = grid_size * grid_size;
+        std::vector<float> xi(count), eta(count), x(count), y(count), z(count);
+        std::vector<double> ra(count), dec(count);
+        for (int i = 0; i < count; i++) {
+            xi[i] = float((i % grid_size - grid_size/2) * spacing_deg * M_PI / 180.0);
+            eta[i] = float((i / grid_size - grid_size/2) * spacing_deg * M_PI / 180.0);
+        }
+        spherical::gnomonicInverse(spherical::Rotation::tangentFrame(center_ra, center_dec),
+                                   xi.data(), eta.data(), count, x.data(), y.data(), z.data());
+        spherical::vectorsToRaDec(x.data(), y.data(), z.data(), count, ra.data(), dec.data());
+        
         // Create grid of test positions
-        for (int y = 0; y < grid_size; y++) {
-            for (int x = 0; x < grid_size; x++) {
-                double offset_x = (x - grid_size/2) * spacing_deg;
-                double offset_y = (y - grid_size/2) * spacing_deg;
-                
-                double ra = center_ra + offset_x / cos(center_dec * M_PI / 180.0);
-                double dec = center_dec + offset_y;
-                
-                // Normalize RA
-                while (ra < 0) ra += 360.0;
-                while (ra >= 360.0) ra -= 360.0;
-                
-                // Clamp Dec
-                if (dec > 90.0) dec = 90.0;
-                if (dec < -90.0) dec = -90.0;
-                
-                TestPosition pos;
-                pos.ra_deg = ra;
-                pos.dec_deg = dec;
-                pos.name = QString("grid_%1_%2").arg(x).arg(y);
-                
-                m_testQueue.append(pos);
-                
-                qDebug() << QString("  Grid[%1,%2]: RA=%3°, Dec=%4°")
-                            .arg(x).arg(y).arg(ra, 0, 'f', 4).arg(dec, 0, 'f', 4);
-            }
+        for (int i = 0; i < count; i++) {
+            int gx = i % grid_size;
+            int gy = i / grid_size;
+            
+            TestPosition pos;
+            pos.ra_deg = ra[i];
+            pos.dec_deg = dec[i];
+            pos.name = QString("grid_%1_%2").arg(gx).arg(gy);
+            
+            m_testQueue.append(pos);
+            
+            qDebug() << QString("  Grid[%1,%2]: RA=%3°, Dec=%4°")
+                        .arg(gx).arg(gy).arg(ra[i], 0, 'f', 4).arg(dec[i], 0, 'f', 4);
         }
         
         qDebug() << QString("Created test queue with %1 positions").arg(m_testQueue.size());
-        processNextInQueue();
+        startBatch();
     }
     
     // Download images for common test targets
@@ -137,7 +135,7 @@ public:
                         .arg(target.name).arg(target.ra_deg).arg(target.dec_deg);
         }
         
-        processNextInQueue();
+        startBatch();
     }
     
     // Generate metadata file for plate solver testing
@@ -181,82 +179,274 @@ public:
         qDebug() << "\nMetadata file created:" << metadataPath;
     }
 
-private slots:
-    void onImageReady(const QImage& image) {
-        if (image.isNull()) {
-            qDebug() << "❌ Failed to generate image for" << m_currentName;
-            processNextInQueue();
-            return;
+private:
+    // One target flowing through the resample -> encode -> write stages
+    struct FrameJob {
+        QString name;
+        double ra_deg = 0.0;
+        double dec_deg = 0.0;
+        QImage mosaic;
+        QImage frame;
+        QByteArray encoded;
+        RenderKey cacheKey;
+        // BatchJobs reservation taken before the fetch, returned by writeFrame
+        std::shared_ptr<MemoryCharge> reservation;
+    };
+    
+    // Fetches run on the event loop (at most kMaxFetchesInFlight at once);
+    // finished mosaics go through a pipeline whose bounded queues push back
+    // on fetching when encode or write fall behind.
+    void startBatch() {
+        m_jobsPending = m_testQueue.size();
+        m_jobsTotal = m_jobsPending;
+        m_fetchesInFlight = 0;
+        m_throttleRetries = 0;
+        
+        m_pipeline = std::make_unique<Pipeline<FrameJob>>("survey_downloader");
+        m_pipeline->addStage("resample", 2, 2, [](FrameJob& job) { return resampleFrame(job); });
+        if (m_deepZoom) {
+            m_pipeline->addStage("pyramid", 1, 2, [this](FrameJob& job) { return writePyramid(job); });
         }
+        m_pipeline->addStage("encode", kEncodeWorkers, 2, [](FrameJob& job) { return encodeFrame(job); })
+                   .addStage("write", 1, 4, [this](FrameJob& job) { return writeFrame(job); });
+        m_pipeline->start();
+        
+        int local = 0;
+        for (const TestPosition& pos : m_testQueue) {
+            SkyPosition target;
+            target.ra_deg = pos.ra_deg;
+            target.dec_deg = pos.dec_deg;
+            if (m_mosaicCreator->canRenderLocally(target)) local++;
+        }
+        qDebug() << QString("%1 of %2 targets render entirely from local tiles")
+                    .arg(local).arg(m_jobsTotal);
         
-        qDebug() << "✅ Image generated:" << image.width() << "x" << image.height();
-        
-        // Resize to match your camera resolution
-        QImage resized = image.scaled(3072, 2048, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        
-        // If aspect ratio doesn't match, create black letterbox
-        if (resized.width() != 3072 || resized.height() != 2048) {
-            QImage final(3072, 2048, QImage::Format_RGB888);
-            final.fill(Qt::black);
+        if (m_jobsPending == 0) {
+            finishBatch();
+            return;
+        }
+        startFetches();
+    }
+    
+    void startFetches() {
+        while (m_fetchesInFlight < kMaxFetchesInFlight && !m_testQueue.isEmpty()) {
+            // Reserve the next target's working set before starting it, so
+            // targets in flight count against the budget until written
+            MemoryAccounting& accounting = MemoryAccounting::instance();
+            if (!accounting.tryAdmit(MemoryStage::BatchJobs, kJobWorkingSetBytes)) {
+                if (m_throttleRetries++ < kMaxThrottleRetries) {
+                    qDebug() << "⏸ Memory budget reached, delaying next target";
+                    QTimer::singleShot(500, this, &SurveyDownloader::startFetches);
+                    return;
+                }
+                qDebug() << "⚠️ Memory budget still exceeded, starting next target anyway";
+                accounting.printReport();
+                accounting.charge(MemoryStage::BatchJobs, kJobWorkingSetBytes);
+            }
+            m_throttleRetries = 0;
+            auto reservation = std::make_shared<MemoryCharge>(
+                MemoryCharge::adopt(MemoryStage::BatchJobs, kJobWorkingSetBytes));
             
-            int x = (3072 - resized.width()) / 2;
-            int y = (2048 - resized.height()) / 2;
+            TestPosition pos = m_testQueue.takeFirst();
+            qDebug() << QString("\n[%1/%2] Processing: %3")
+                        .arg(m_jobsTotal - m_testQueue.size())
+                        .arg(m_jobsTotal)
+                        .arg(pos.name);
             
-            QPainter painter(&final);
-            painter.drawImage(x, y, resized);
-            painter.end();
+            SkyPosition target;
+            target.ra_deg = pos.ra_deg;
+            target.dec_deg = pos.dec_deg;
+            target.name = pos.name;
+            target.description = QString("Test image for plate solver at RA=%1°, Dec=%2°")
+                                 .arg(pos.ra_deg).arg(pos.dec_deg);
             
-            resized = final;
+            if (reuseCachedFrame(pos.name, target)) {
+                jobDone();
+                continue;
+            }
+            
+            m_fetchesInFlight++;
+            m_mosaicCreator->renderMosaic(target)
+                .then(this, [this, pos, target, reservation](const QImage& mosaic) {
+                    qDebug() << "✅ Image generated:" << mosaic.width() << "x" << mosaic.height();
+                    FrameJob job;
+                    job.name = pos.name;
+                    job.ra_deg = pos.ra_deg;
+                    job.dec_deg = pos.dec_deg;
+                    job.mosaic = mosaic;
+                    job.cacheKey = frameKey(target);
+                    job.reservation = reservation;
+                    submitJob(job);
+                })
+                .onFailed(this, [this, pos, reservation](const QString& error) {
+                    qDebug() << "❌ Failed to generate image for" << pos.name << ":" << error;
+                    reservation->reset();
+                    m_fetchesInFlight--;
+                    jobDone();
+                    startFetches();
+                });
+        }
+    }
+    
+    // The mosaic key plus the sensor geometry and encoding of the frame
+    RenderKey frameKey(const SkyPosition& target) const {
+        RenderKey key = m_mosaicCreator->mosaicKey(target);
+        key.add("output", "survey_frame")
+           .add("width", 3072)
+           .add("height", 2048)
+           .add("format", "PNG");
+        return key;
+    }
+    
+    // Identical target, sensor and tiles as an earlier run: copy that
+    // frame instead of rendering, resampling and encoding it again
+    bool reuseCachedFrame(const QString& name, const SkyPosition& target) {
+        if (m_deepZoom && !QFileInfo::exists(QString("%1/%2.dzi").arg(m_outputDir).arg(name))) {
+            return false;
         }
+        QString cachedPath = m_renderCache->lookup(frameKey(target));
+        if (cachedPath.isEmpty()) return false;
+        
+        QString filename = QString("%1/%2.png").arg(m_outputDir).arg(name);
+        QFile::remove(filename);
+        if (!QFile::copy(cachedPath, filename)) return false;
         
-        // Save the image
-        QString filename = QString("%1/%2.png").arg(m_outputDir).arg(m_currentName);
-        bool saved = resized.save(filename);
+        qDebug() << "♻️ Unchanged since last run, reused:" << filename;
+        TestPosition pos;
+        pos.name = name;
+        pos.ra_deg = target.ra_deg;
+        pos.dec_deg = target.dec_deg;
+        m_downloadedImages.append(pos);
+        return true;
+    }
+    
+    // The fetch slot stays occupied until the pipeline accepts the mosaic,
+    // so a full resample queue stops new downloads from starting
+    void submitJob(FrameJob job) {
+        if (!m_pipeline->trySubmit(job)) {
+            QTimer::singleShot(50, this, [this, job]() { submitJob(job); });
+            return;
+        }
+        m_fetchesInFlight--;
+        startFetches();
+    }
+    
+    // Resize to match your camera resolution, letterboxed in black.
+    // Scale straight into a pooled frame rather than via an
+    // intermediate QImage::scaled() copy.
+    static bool resampleFrame(FrameJob& job) {
+        QSize scaledSize = job.mosaic.size().scaled(3072, 2048, Qt::KeepAspectRatio);
+        QRect targetRect((3072 - scaledSize.width()) / 2,
+                         (2048 - scaledSize.height()) / 2,
+                         scaledSize.width(), scaledSize.height());
+        
+        job.frame = BufferPool::instance().createImage(3072, 2048, QImage::Format_RGB888);
+        job.frame.fill(Qt::black);
+        
+        QPainter painter(&job.frame);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawImage(targetRect, job.mosaic);
+        painter.end();
+        
+        job.mosaic = QImage();
+        return true;
+    }
+    
+    // A failed pyramid is logged but never drops the frame itself
+    bool writePyramid(FrameJob& job) {
+        QString dziPath = QString("%1/%2.dzi").arg(m_outputDir).arg(job.name);
+        DeepZoomOptions options;
+        options.threads = 2;
+        if (DeepZoomWriter(options).write(job.frame, dziPath)) {
+            qDebug() << "✅ Pyramid:" << dziPath;
+        } else {
+            qDebug() << "❌ Failed to write pyramid:" << dziPath;
+        }
+        return true;
+    }
+    
+    // A failed encode goes on with nothing to write, so writeFrame still
+    // finishes the job's bookkeeping
+    static bool encodeFrame(FrameJob& job) {
+        QBuffer buffer(&job.encoded);
+        buffer.open(QIODevice::WriteOnly);
+        bool ok = job.frame.save(&buffer, "PNG");
+        job.frame = QImage();
+        if (!ok) {
+            qDebug() << "❌ Failed to encode:" << job.name;
+            job.encoded.clear();
+        }
+        return true;
+    }
+    
+    // Runs on the write worker; bookkeeping is handed back to the event loop
+    bool writeFrame(FrameJob& job) {
+        QString filename = QString("%1/%2.png").arg(m_outputDir).arg(job.name);
+        bool saved = false;
+        if (!job.encoded.isEmpty()) {
+            QFile file(filename);
+            saved = file.open(QIODevice::WriteOnly) &&
+                    file.write(job.encoded) == job.encoded.size();
+            file.close();
+        }
         
         if (saved) {
             qDebug() << "✅ Saved:" << filename;
-            qDebug() << "   Size:" << resized.width() << "x" << resized.height();
-            
-            // Record this download with current position info
-            TestPosition pos;
-            pos.name = m_currentName;
-            pos.ra_deg = m_currentRA;
-            pos.dec_deg = m_currentDec;
-            m_downloadedImages.append(pos);
+            qDebug() << "   Size: 3072 x 2048";
+            m_renderCache->store(job.cacheKey, job.encoded);
         } else {
             qDebug() << "❌ Failed to save:" << filename;
         }
         
-        // Process next in queue
-        QTimer::singleShot(1000, this, &SurveyDownloader::processNextInQueue);
+        job.encoded.clear();
+        if (job.reservation) job.reservation->reset();
+        
+        TestPosition pos;
+        pos.name = job.name;
+        pos.ra_deg = job.ra_deg;
+        pos.dec_deg = job.dec_deg;
+        QMetaObject::invokeMethod(this, [this, pos, saved]() {
+            if (saved) {
+                m_downloadedImages.append(pos);
+            }
+            jobDone();
+        }, Qt::QueuedConnection);
+        return saved;
     }
     
-    void processNextInQueue() {
-        if (m_testQueue.isEmpty()) {
-            qDebug() << "\n=== All downloads complete ===";
-            qDebug() << "Total images:" << m_downloadedImages.size();
-            qDebug() << "Location:" << m_outputDir;
-            generateMetadataFile();
-            QTimer::singleShot(1000, qApp, &QApplication::quit);
-            return;
+    void jobDone() {
+        if (--m_jobsPending == 0) {
+            finishBatch();
         }
-        
-        TestPosition pos = m_testQueue.takeFirst();
-        qDebug() << QString("\n[%1/%2] Processing: %3")
-                    .arg(m_downloadedImages.size() + 1)
-                    .arg(m_downloadedImages.size() + m_testQueue.size() + 1)
-                    .arg(pos.name);
-        
-        downloadForCoordinates(pos.ra_deg, pos.dec_deg, pos.name);
+    }
+    
+    void finishBatch() {
+        m_pipeline->close();
+        m_pipeline->wait();
+        
+        qDebug() << "\n=== All downloads complete ===";
+        qDebug() << "Total images:" << m_downloadedImages.size();
+        qDebug() << "Location:" << m_outputDir;
+        generateMetadataFile();
+        
+        QString coveragePath = QString("%1/tile_coverage.fits").arg(m_outputDir);
+        Moc coverage = m_mosaicCreator->tileCoverage();
+        if (coverage.writeFits(coveragePath, "survey_downloader")) {
+            qDebug() << QString("Tile coverage: %1 deg² (MOC written to %2)")
+                        .arg(coverage.areaSqDeg(), 0, 'f', 2).arg(coveragePath);
+        }
+        m_pipeline->printStats();
+        m_renderCache->printStats();
+        m_mosaicCreator->tileStore().printStats();
+        m_mosaicCreator->pixelSlab().printStats();
+        MemoryAccounting::instance().printReport();
+        QTimer::singleShot(1000, qApp, &QApplication::quit);
     }
 
 private:
     ProperHipsClient* m_hipsClient;
     EnhancedMosaicCreator* m_mosaicCreator;
     QString m_outputDir;
-    QString m_currentName;
-    double m_currentRA;
-    double m_currentDec;
     
     struct TestPosition {
         QString name;
@@ -267,6 +457,22 @@ private:
     QList<TestPosition> m_testQueue;
     QList<TestPosition> m_downloadedImages;
     
+    // Estimated peak bytes for one target: 9 tiles, raw canvas, crop, output frame
+    static constexpr qint64 kJobWorkingSetBytes =
+        9LL * 512 * 512 * 4 + 1536LL * 1536 * 4 + 1200LL * 1200 * 4 + 3072LL * 2048 * 3;
+    static constexpr int kMaxThrottleRetries = 120;
+    int m_throttleRetries = 0;
+    
+    bool m_deepZoom = false;
+    
+    static constexpr int kMaxFetchesInFlight = 2;
+    static constexpr int kEncodeWorkers = 2;
+    std::unique_ptr<Pipeline<FrameJob>> m_pipeline;
+    std::unique_ptr<RenderCache> m_renderCache;
+    int m_fetchesInFlight = 0;
+    int m_jobsPending = 0;
+    int m_jobsTotal = 0;
+    
     // Coordinate conversion helpers
     QString degToHMS(double deg) const {
         double hours = deg / 15.0;
@@ -332,10 +538,25 @@ int main(int argc, char *argv[]) {
         "Grid spacing in degrees", "spacing", "1.0");
     parser.addOption(spacingOption);
     
+    QCommandLineOption memoryBudgetOption(QStringList() << "memory-budget",
+        "Process memory budget in MB (0 = unlimited)", "mb");
+    parser.addOption(memoryBudgetOption);
+    
+    QCommandLineOption deepZoomOption(QStringList() << "deepzoom",
+        "Also write each frame as a Deep Zoom tile pyramid (.dzi)");
+    parser.addOption(deepZoomOption);
+    
     parser.process(app);
     
+    if (parser.isSet(memoryBudgetOption)) {
+        qint64 budgetMB = parser.value(memoryBudgetOption).toLongLong();
+        MemoryAccounting::instance().setBudget(budgetMB * 1024 * 1024);
+        qDebug() << "Memory budget:" << budgetMB << "MB";
+    }
+    
     // Create downloader
     SurveyDownloader downloader;
+    downloader.setDeepZoomExport(parser.isSet(deepZoomOption));
     
     QString mode = parser.value(modeOption);
     